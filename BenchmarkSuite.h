@@ -0,0 +1,226 @@
+#ifndef BenchmarkSuite_H
+#define BenchmarkSuite_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <ostream>
+#include <iomanip>
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+#include "QueryMetrics.h"
+
+/*
++ AllocationCounter: Counts heap allocations, for BenchmarkSuite's allocations per op.
+
+- Nothing counts on its own; the program has to replace the global operator new with one that calls add() (see
+  benchmark.cpp). Without that, every case shows 0 allocations.
+- The counts are for every thread, so run cases one at a time, and keep background threads quiet while they run.
+*/
+class AllocationCounter {
+public:
+    static void add(size_t bytes) {
+        allocationCount().fetch_add(1, std::memory_order_relaxed);
+        byteCount().fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    static unsigned long long allocations() {
+        return allocationCount().load(std::memory_order_relaxed);
+    }
+
+    static unsigned long long bytes() {
+        return byteCount().load(std::memory_order_relaxed);
+    }
+
+private:
+    static std::atomic<unsigned long long>& allocationCount() {
+        static std::atomic<unsigned long long> count(0);
+        return count;
+    }
+
+    static std::atomic<unsigned long long>& byteCount() {
+        static std::atomic<unsigned long long> count(0);
+        return count;
+    }
+};
+
+
+/*
++ BenchmarkSuite: Micro-benchmarks in the style of Google Benchmark, without needing the library. Each case runs an
+    operation a number of times, one call after another, and gets timed call by call.
+
+        BenchmarkSuite suite(std::cout, filter);
+        suite.run("ProductStore::getProductPage/100", 1000, [&](int i) { productStore.getProductPage(0, 100); }, 100);
+        ...
+        suite.writeJSON(jsonFile, { { "backend", "in-process" } });
+
+- Each case prints its ops/s, items/s (when it handles more than one item per op, like rows in a page), p50/p99/max
+  latency, and allocations and bytes allocated per op (see AllocationCounter).
+- A case only runs if filter is empty or part of its name; use selected() to skip setup for cases that won't run.
+- writeJSON writes the results in Google Benchmark's JSON format, so its tools/compare.py can compare two runs.
+  Times are in nanoseconds; the latency percentiles and allocations are extra counters on each benchmark.
+
+NOTE: Cases run right away, in the order they're given, so a case can use what the ones before it made.
+*/
+class BenchmarkSuite {
+public:
+    struct Result {
+        std::string name;
+        int iterations = 0;
+        double itemsPerOp = 1;
+        unsigned long long totalNanos = 0;
+        unsigned long long cpuNanos = 0;
+        unsigned long long p50Nanos = 0;
+        unsigned long long p99Nanos = 0;
+        unsigned long long maxNanos = 0;
+        unsigned long long allocations = 0;
+        unsigned long long allocatedBytes = 0;
+
+        double opsPerSecond() const {
+            return totalNanos == 0 ? 0.0 : iterations * 1000000000.0 / totalNanos;
+        }
+    };
+
+    explicit BenchmarkSuite(std::ostream& out, std::string filter = "") : out(out), filter(std::move(filter)) {}
+
+    bool selected(const std::string& name) const {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    // Runs operation(i) for i from 0 to iterations - 1, timing each call, and prints how it did; itemsPerOp is for items/s
+    template<typename Operation>
+    void run(const std::string& name, int iterations, Operation operation, double itemsPerOp = 1) {
+        if (!selected(name) || iterations < 1) {
+            return;
+        }
+
+        LatencyHistogram histogram; // Fed nanoseconds; its buckets don't care about the unit
+        Result result;
+        result.name = name;
+        result.iterations = iterations;
+        result.itemsPerOp = itemsPerOp;
+        unsigned long long allocationsBefore = AllocationCounter::allocations();
+        unsigned long long bytesBefore = AllocationCounter::bytes();
+        std::clock_t cpuStart = std::clock();
+        for (int i = 0; i < iterations; i++) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            operation(i);
+            unsigned long long nanos = static_cast<unsigned long long>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+            histogram.add(nanos);
+            result.totalNanos += nanos;
+            result.maxNanos = std::max(result.maxNanos, nanos);
+        }
+        result.cpuNanos = static_cast<unsigned long long>(static_cast<double>(std::clock() - cpuStart) * 1000000000.0 / CLOCKS_PER_SEC);
+        result.allocations = AllocationCounter::allocations() - allocationsBefore;
+        result.allocatedBytes = AllocationCounter::bytes() - bytesBefore;
+        result.p50Nanos = std::min(result.maxNanos, histogram.percentile(50));
+        result.p99Nanos = std::min(result.maxNanos, histogram.percentile(99));
+        results.push_back(result);
+        print(result);
+    }
+
+    const std::vector<Result>& getResults() const {
+        return results;
+    }
+
+    // Writes the results as Google Benchmark JSON; context is extra "key": "value" pairs for the context object
+    void writeJSON(std::ostream& json, const std::vector<std::pair<std::string, std::string>>& context) const {
+        std::ios::fmtflags flags = json.flags();
+        std::streamsize precision = json.precision();
+        json << std::fixed << std::setprecision(3);
+
+        json << "{\n  \"context\": {\n";
+        json << "    \"date\": \"" << currentTime() << "\",\n";
+        json << "    \"library_build_type\": \"" << (isDebugBuild() ? "debug" : "release") << "\"";
+        for (size_t i = 0; i < context.size(); i++) {
+            json << ",\n    \"" << escape(context[i].first) << "\": \"" << escape(context[i].second) << "\"";
+        }
+        json << "\n  },\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& result = results[i];
+            double iterations = static_cast<double>(result.iterations);
+            json << (i == 0 ? "\n" : ",\n") << "    {\n";
+            json << "      \"name\": \"" << escape(result.name) << "\",\n";
+            json << "      \"run_name\": \"" << escape(result.name) << "\",\n";
+            json << "      \"run_type\": \"iteration\",\n";
+            json << "      \"repetitions\": 1,\n";
+            json << "      \"repetition_index\": 0,\n";
+            json << "      \"threads\": 1,\n";
+            json << "      \"iterations\": " << result.iterations << ",\n";
+            json << "      \"real_time\": " << result.totalNanos / iterations << ",\n";
+            json << "      \"cpu_time\": " << result.cpuNanos / iterations << ",\n";
+            json << "      \"time_unit\": \"ns\",\n";
+            json << "      \"items_per_second\": " << result.opsPerSecond() * result.itemsPerOp << ",\n";
+            json << "      \"p50_ns\": " << result.p50Nanos << ",\n";
+            json << "      \"p99_ns\": " << result.p99Nanos << ",\n";
+            json << "      \"max_ns\": " << result.maxNanos << ",\n";
+            json << "      \"allocs_per_op\": " << result.allocations / iterations << ",\n";
+            json << "      \"bytes_per_op\": " << result.allocatedBytes / iterations << "\n";
+            json << "    }";
+        }
+        json << "\n  ]\n}\n";
+
+        json.flags(flags);
+        json.precision(precision);
+    }
+
+private:
+    std::ostream& out;
+    std::string filter;
+    std::vector<Result> results;
+
+    void print(const Result& result) {
+        double iterations = static_cast<double>(result.iterations);
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << std::fixed << std::setprecision(3) << "  " << std::left << std::setw(52) << result.name << std::right
+            << " ops(" << result.iterations << "), ops/s(" << std::setprecision(1) << result.opsPerSecond();
+        if (result.itemsPerOp != 1) {
+            out << "), items/s(" << result.opsPerSecond() * result.itemsPerOp;
+        }
+        out << std::setprecision(3) << "), p50(" << result.p50Nanos / 1000000.0 << "ms), p99(" << result.p99Nanos / 1000000.0
+            << "ms), max(" << result.maxNanos / 1000000.0 << "ms), allocs/op(" << std::setprecision(1) << result.allocations / iterations
+            << "), bytes/op(" << std::setprecision(0) << result.allocatedBytes / iterations << ")" << std::endl;
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    static bool isDebugBuild() {
+#ifdef NDEBUG
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    static std::string currentTime() {
+        time_t now = time(nullptr);
+        struct tm localTime;
+#ifdef _WIN32
+        localtime_s(&localTime, &now);
+#else
+        localtime_r(&now, &localTime);
+#endif
+        char buffer[32];
+        strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &localTime);
+        return std::string(buffer);
+    }
+
+    static std::string escape(const std::string& value) {
+        std::string escaped;
+        for (size_t i = 0; i < value.length(); i++) {
+            if (value[i] == '"' || value[i] == '\\') {
+                escaped += '\\';
+            }
+            escaped += value[i];
+        }
+        return escaped;
+    }
+};
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef CartItem_H
 #define CartItem_H
 #include <string>
+#include <utility>
 #include <ostream>
 
 class CartItem {
@@ -25,7 +26,7 @@ public:
 		int qty,
 		std::string p_name,
 		float price
-	) : customer_id(customer_id), product_id(product_id), qty(qty), p_name(p_name), price(price) {}
+	) : customer_id(customer_id), product_id(product_id), qty(qty), p_name(std::move(p_name)), price(price) {}
 
 	const int getCustomerID() {
 		return customer_id;
@@ -2,7 +2,11 @@
 #define CartItemManager_H
 #include <string>
 #include <vector>
-#include "DBConn.h"
+#include "ConnectionPool.h"
+#include "WorkloadRecorder.h"
+#include "RowMapper.h"
+#include "QueryBatch.h"
+#include "StorageBackend.h"
 #include "CartItem.h"
 
 
@@ -38,11 +42,11 @@ a product, and how much of that product a customer currently has in their shoppi
 	products referencing that supplier should be deleted. It'd be pretty difficult, to try to find a way to get the IDs of the 
 	deleted products, and try to synchronize our in-memory state.
 
-
++ This is the SQL Server CartItemStore (see StorageBackend.h), which is where UpsertResult is.
 */
-class CartItemManager {
+class CartItemManager : public CartItemStore {
 private:
-	DBConn& dbConn;
+	ConnectionPool& connectionPool;
 	std::string tableName;
 	std::string customerTableName;
 	std::string productTableName;
@@ -50,28 +54,56 @@ private:
 
 	static const int MAX_P_NAME_LENGTH = 50;
 
-	// Helper function to create customer object from row data.
-	CartItem createCartItemFromRow(SQLINTEGER customer_id, SQLINTEGER product_id, SQLINTEGER qty, SQLCHAR* p_name, SQLFLOAT price) {
+	// Columns of a cart item joined with its product, in order: customer_id, product_id, qty, p_name, price
+	typedef RowMapper<CartItem, IntColumn, IntColumn, IntColumn, StringColumn<MAX_P_NAME_LENGTH>, FloatColumn> CartItemRowMapper;
 
-		// Null terminate the string
-		p_name[MAX_P_NAME_LENGTH] = '\0';
+	// Reads the rows of the current result set into a vector of cart items; expects the cart item columns followed by p_name and price.
+	std::vector<CartItem> readCartItems(DBConn& dbConn) {
+		return CartItemRowMapper::read(dbConn, "Failed to fetch customer's cart items!");
+	}
 
-		// Convert data-types and add the cart item to the vector of cart items
-		int intCustomerID = static_cast<int>(customer_id);
-		int intProductID = static_cast<int>(product_id);
-		int intQty = static_cast<int>(qty);
-		std::string p_name_str(reinterpret_cast<char*>(p_name));
-		float floatPrice = static_cast<float>(price);
+	// JOIN query to get all cart items for a particular customer_id; get all cart item columns, but also p_name and price from products table.
+	std::string customerCartItemsQuery() const {
+		return "SELECT " + tableName + ".*, " + productTableName + ".p_name, " + productTableName + ".price "
+			"FROM " + tableName + " "
+			"JOIN " + productTableName + " ON " + productTableName + ".product_id = " + tableName + ".product_id "
+			"WHERE customer_id = ?;";
+	}
 
-		// Return cart item as object
-		CartItem cartItem(intCustomerID, intProductID, intQty, p_name_str, floatPrice);
-		return cartItem;
+	/*
+	- Inserts the cart item, or runs updateSet on it if it's already in the cart, in one MERGE statement.
+
+	NOTE: MERGE's row count is 1 either way, so we output $action ('INSERT' or 'UPDATE') to know which happened.
+		HOLDLOCK makes the MERGE take a range lock on the key, otherwise two MERGEs could both see no row and both insert.
+	*/
+	UpsertResult mergeCartItem(int customer_id, int product_id, int qty, const std::string& updateSet) {
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "MERGE " + tableName + " WITH (HOLDLOCK) AS target "
+			"USING (VALUES (?, ?, ?)) AS source (customer_id, product_id, qty) "
+			"ON target.customer_id = source.customer_id AND target.product_id = source.product_id "
+			"WHEN MATCHED THEN UPDATE SET " + updateSet + " "
+			"WHEN NOT MATCHED THEN INSERT (customer_id, product_id, qty) VALUES (source.customer_id, source.product_id, source.qty) "
+			"OUTPUT $action;";
+		if (!dbConn->executePrepared(query, { customer_id, product_id, qty })) {
+			throw std::runtime_error("Failed to add or update cart item!");
+		}
+
+		std::string action;
+		SQLRETURN retcode = dbConn->fetchRow();
+		bool succeeded = (retcode == SQL_SUCCESS || retcode == SQL_SUCCESS_WITH_INFO) && dbConn->getData(1, action);
+		dbConn->closeCursor();
+		if (!succeeded) {
+			throw std::runtime_error("Failed to add or update cart item!");
+		}
+		return action == "INSERT" ? UpsertResult::Inserted : UpsertResult::Updated;
 	}
 
 public:
-	CartItemManager(DBConn& dbConn, std::string tableName, std::string customerTableName, std::string productTableName) : dbConn(dbConn), tableName(tableName), customerTableName(customerTableName), productTableName(productTableName) {}
+	CartItemManager(ConnectionPool& connectionPool, std::string tableName, std::string customerTableName, std::string productTableName) : connectionPool(connectionPool), tableName(tableName), customerTableName(customerTableName), productTableName(productTableName) {}
 
 	void initTable() {
+		QueryCaller queryCaller("CartItemManager::initTable");
+		DBConnLease dbConn = connectionPool.acquire();
 		std::string query = "CREATE TABLE " + tableName + " ( "
 			"customer_id INT NOT NULL, "
 			"product_id INT NOT NULL, "
@@ -80,79 +112,58 @@ public:
 			"FOREIGN KEY (customer_id) REFERENCES " + customerTableName + " (customer_id), "
 			"FOREIGN KEY (product_id) REFERENCES " + productTableName + " (product_id)"
 			");";
-		if (!dbConn.executeSQL(query)) {
+		if (!dbConn->executeSQL(query)) {
 			throw std::runtime_error("Failed to initialize '" + tableName + "' table!");
 		}
 	}
 
 
+	// Given a query string, fetch a vector of cart items
 	std::vector<CartItem> fetchCartItems(const std::string query) {
-		std::vector<CartItem> cartItems;
-
-		// Execute query to fetch customers
-		if (!dbConn.executeSQL(query)) {
+		DBConnLease dbConn = connectionPool.acquire();
+		// Execute query to fetch cart items
+		if (!dbConn->executeSQL(query)) {
 			throw std::runtime_error("Failed to query cart items from the database!");
 		}
+		return readCartItems(*dbConn);
+	}
 
-		// Create variables that will get data fro
-		SQLINTEGER customer_id = 0;
-		SQLINTEGER product_id = 0;
-		SQLINTEGER qty = 0;
-		SQLCHAR p_name[MAX_P_NAME_LENGTH + 1] = {};
-		SQLFLOAT price = 0;
-
-
-		// Bind/prepare columns to get the data
-		dbConn.bindColumn(1, SQL_INTEGER, &customer_id, sizeof(customer_id));
-		dbConn.bindColumn(2, SQL_INTEGER, &product_id, sizeof(product_id));
-		dbConn.bindColumn(3, SQL_INTEGER, &qty, sizeof(qty));
-		dbConn.bindColumn(4, SQL_C_CHAR, &p_name, sizeof(p_name));
-		dbConn.bindColumn(5, SQL_C_DOUBLE, &price, sizeof(price));
-
-		while (true) {
-			SQLRETURN retcode = dbConn.fetchRow();
-			if (retcode == SQL_NO_DATA) {
-				break;
-			}
-			else if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
-				dbConn.closeCursor();
-				throw std::runtime_error("Failed to fetch customer's cart items!");
-			}
-
-			CartItem cartItem = createCartItemFromRow(customer_id, product_id, qty, p_name, price);
-			cartItems.push_back(cartItem);
+	// Given a parameterized query and the values for its placeholders, fetch a vector of cart items using a prepared statement
+	std::vector<CartItem> fetchCartItems(const std::string& query, std::vector<SQLParam> params) {
+		DBConnLease dbConn = connectionPool.acquire();
+		if (!dbConn->executePrepared(query, std::move(params))) {
+			throw std::runtime_error("Failed to query cart items from the database!");
 		}
-
-		dbConn.closeCursor();
-
-		return cartItems;
+		return readCartItems(*dbConn);
 	}
 
-
 	// Get all cart items for a particular customer
-	std::vector<CartItem> getCustomerCartItems(int customer_id) {
-		// Create JOIN query to get all cart items for a particular customer_id; get all cart item columns, but also p_name and price from products table.
-		std::string query = "SELECT " + tableName + ".*, " + productTableName + ".p_name, " + productTableName + ".price "
-			"FROM " + tableName + " "
-			"JOIN " + productTableName + " ON " + productTableName + ".product_id = " + tableName + ".product_id "
-			"WHERE customer_id = " + std::to_string(customer_id) + ";";
-
+	std::vector<CartItem> getCustomerCartItems(int customer_id) override {
+		QueryCaller queryCaller("CartItemManager::getCustomerCartItems");
+		WorkloadCall workloadCall(queryCaller, customer_id);
 		// Run query and get back vector of cart items; then return vector
-		std::vector<CartItem> cartItems = fetchCartItems(query);
+		std::vector<CartItem> cartItems = fetchCartItems(customerCartItemsQuery(), { customer_id });
 		return cartItems;
 	}
 
+	// Adds the query for a customer's cart items to batch; cartItems gets them once the batch is executed
+	void batchGetCustomerCartItems(ReadBatch& batch, int customer_id, std::vector<CartItem>& cartItems) override {
+		QueryBatch::from(batch).add(customerCartItemsQuery(), { customer_id }, [this, &cartItems](DBConn& dbConn) { cartItems = readCartItems(dbConn); });
+	}
+
 	// Get a specific cart item for a particular customer
-	CartItem getCartItem(int customer_id, int product_id) {
+	CartItem getCartItem(int customer_id, int product_id) override {
+		QueryCaller queryCaller("CartItemManager::getCartItem");
+		WorkloadCall workloadCall(queryCaller, customer_id, product_id);
 
 		// Create a JOIN query for a cart item with a particular customer_id and product_id
 		std::string query = "SELECT " + tableName + ".*, " + productTableName + ".p_name, " + productTableName + ".price "
 			"FROM " + tableName + " "
 			"JOIN " + productTableName + " ON " + productTableName + ".product_id = " + tableName + ".product_id "
-			"WHERE customer_id = " + std::to_string(customer_id) + " AND " + productTableName + ".product_id = " + std::to_string(product_id) + ";";
+			"WHERE customer_id = ? AND " + productTableName + ".product_id = ?;";
 
 		// Fetch cart items; we're expecting only one cart item since customer_id and product_id make up the primary key
-		std::vector<CartItem> cartItems = fetchCartItems(query);
+		std::vector<CartItem> cartItems = fetchCartItems(query, { customer_id, product_id });
 
 		// If empty, cart item doesn't exist
 		if (cartItems.empty()) {
@@ -174,98 +185,126 @@ public:
 	the matching customer_id and product_id already exists.
 
 	*/
-	bool isExistingCartItem(int customer_id, int product_id) {
+	bool isExistingCartItem(int customer_id, int product_id) override {
+		QueryCaller queryCaller("CartItemManager::isExistingCartItem");
+		WorkloadCall workloadCall(queryCaller, customer_id, product_id);
+		DBConnLease dbConn = connectionPool.acquire();
 		bool isExists = true;
 
 		// Create and execute query
-		std::string query = "SELECT * FROM " + tableName + " WHERE customer_id=" + std::to_string(customer_id) + " AND product_id=" + std::to_string(product_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+		std::string query = "SELECT * FROM " + tableName + " WHERE customer_id=? AND product_id=?;";
+		if (!dbConn->executePrepared(query, { customer_id, product_id })) {
 			throw std::runtime_error("Failed to query cart items from the database!");
 		}
 
 		// Fetch the row, if it isn't a success, then the row (cart item) doesn't exist so mark the boolean as false
-		SQLRETURN retcode = dbConn.fetchRow();
+		SQLRETURN retcode = dbConn->fetchRow();
 		if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
 			isExists = false;
 		}
-		dbConn.closeCursor();
+		dbConn->closeCursor();
 		return isExists;
 	}
 
 	/*
 	- Add new cart item. Good for adding new product into a customer's cart.
 	
-	NOTE: Ensure it is not an existing cart item, because if we don't we'd be adding 
-		in a customer_id and product_id that already exists, therefore ruining the 
-		uniqueness of the table.
+	NOTE: The item is only inserted if it's not already in the customer's cart, because if we didn't check we'd be 
+		adding in a customer_id and product_id that already exists, ruining the uniqueness of the table. That check 
+		used to be a separate query (isExistingCartItem) before the insert. Now it's part of the INSERT, so adding to 
+		the cart is one round trip, and the locks (UPDLOCK, HOLDLOCK) stop two terminals adding the same product at 
+		the same time from both passing the check.
 	*/
-	void createCartItem(int customer_id, int product_id, int qty) {
-
-		// Check if item is already in the given customer's cart, if so stop function execution
-		bool isExists = isExistingCartItem(customer_id, product_id);
-		if (isExists) {
-			throw std::runtime_error("Product with ID (" + std::to_string(product_id) + ") is already in customer's cart!");
+	void createCartItem(int customer_id, int product_id, int qty) override {
+		QueryCaller queryCaller("CartItemManager::createCartItem");
+		WorkloadCall workloadCall(queryCaller, customer_id, product_id, qty);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "INSERT INTO " + tableName + " (customer_id, product_id, qty) SELECT ?, ?, ? "
+			"WHERE NOT EXISTS (SELECT 1 FROM " + tableName + " WITH (UPDLOCK, HOLDLOCK) WHERE customer_id=? AND product_id=?);";
+
+		int rowCount = 0;
+		if (!dbConn->executeUpdate(query, { customer_id, product_id, qty, customer_id, product_id }, rowCount)) {
+			throw std::runtime_error("Insert cart item into the database!");
 		}
 
-		std::string query = "INSERT INTO " + tableName + " (customer_id, product_id, qty) VALUES ("
-			+ std::to_string(customer_id) + ", "
-			+ std::to_string(product_id) + ", "
-			+ std::to_string(qty) + ");";
-
-		if (!dbConn.executeSQL(query)) {
-			throw std::runtime_error("Insert cart item into the database!");
+		// Nothing was inserted, so the item was already in the customer's cart
+		if (rowCount == 0) {
+			throw std::runtime_error("Product with ID (" + std::to_string(product_id) + ") is already in customer's cart!");
 		}
 	}
 
-	// Updates the quantity for an existing cart item.
-	void updateCartItem(int customer_id, int product_id, int qty) {
-		
-		// Verify that the cart item actually exists.
-		bool isExists = isExistingCartItem(customer_id, product_id);
-		if (!isExists) {
-			throw std::runtime_error("Cart item with customer_id(" + std::to_string(customer_id) + " and product_id(" + std::to_string(product_id) + ") is already in customer's cart!");
-		}
+	// Updates the quantity for an existing cart item; throws if the item isn't in the customer's cart.
+	void updateCartItem(int customer_id, int product_id, int qty) override {
+		QueryCaller queryCaller("CartItemManager::updateCartItem");
+		WorkloadCall workloadCall(queryCaller, customer_id, product_id, qty);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "UPDATE " + tableName + " SET qty=? WHERE customer_id=? AND product_id=?;";
 
-		std::string query = "UPDATE " + tableName + " SET qty="
-			+ std::to_string(qty) + " WHERE customer_id="
-			+ std::to_string(customer_id) + " AND product_id="
-			+ std::to_string(product_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+		// The row count tells us if the cart item actually exists, so we don't need to check first
+		int rowCount = 0;
+		if (!dbConn->executeUpdate(query, { qty, customer_id, product_id }, rowCount)) {
 			throw std::runtime_error("Failed to update cart item!");
 		}
+		if (rowCount == 0) {
+			throw std::runtime_error("Cart item with customer_id(" + std::to_string(customer_id) + ") and product_id(" + std::to_string(product_id) + ") isn't in customer's cart!");
+		}
+	}
 
+	// Sets the quantity of a product in the customer's cart, adding it to the cart if it isn't there yet
+	UpsertResult setCartItemQty(int customer_id, int product_id, int qty) override {
+		QueryCaller queryCaller("CartItemManager::setCartItemQty");
+		WorkloadCall workloadCall(queryCaller, customer_id, product_id, qty);
+		return mergeCartItem(customer_id, product_id, qty, "target.qty = source.qty");
+	}
 
+	// Adds qty more of a product to the customer's cart, or adds the product with qty if it isn't there yet
+	UpsertResult incrementCartItemQty(int customer_id, int product_id, int qty) override {
+		QueryCaller queryCaller("CartItemManager::incrementCartItemQty");
+		WorkloadCall workloadCall(queryCaller, customer_id, product_id, qty);
+		return mergeCartItem(customer_id, product_id, qty, "target.qty = target.qty + source.qty");
 	}
 
 	// Delete a cart item from the table using customer_id and product_id; removing item from customer's cart
-	void deleteCartItem(int customer_id, int product_id) {
-		std::string query = "DELETE FROM " + tableName + " WHERE customer_id=" + std::to_string(customer_id) + " AND product_id=" + std::to_string(product_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+	void deleteCartItem(int customer_id, int product_id) override {
+		QueryCaller queryCaller("CartItemManager::deleteCartItem");
+		WorkloadCall workloadCall(queryCaller, customer_id, product_id);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "DELETE FROM " + tableName + " WHERE customer_id=? AND product_id=?;";
+		if (!dbConn->executePrepared(query, { customer_id, product_id })) {
 			throw std::runtime_error("Failed to delete cart item from the database!");
 		}
 	}
 
 	// Delete cart items via product_id; good when deleting a product
-	void deleteByProductID(int product_id) {
-		std::string query = "DELETE FROM " + tableName + " WHERE product_id=" + std::to_string(product_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+	void deleteByProductID(int product_id) override {
+		QueryCaller queryCaller("CartItemManager::deleteByProductID");
+		WorkloadCall workloadCall(queryCaller, product_id);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "DELETE FROM " + tableName + " WHERE product_id=?;";
+		if (!dbConn->executePrepared(query, { product_id })) {
 			throw std::runtime_error("Failed to delete cart items via product_id!");
 		}
 	}
 
 	// Delete cart items via customer_id; good when deleting a customer
-	void deleteByCustomerID(int customer_id) {
-		std::string query = "DELETE FROM " + tableName + " WHERE customer_id=" + std::to_string(customer_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+	void deleteByCustomerID(int customer_id) override {
+		QueryCaller queryCaller("CartItemManager::deleteByCustomerID");
+		WorkloadCall workloadCall(queryCaller, customer_id);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "DELETE FROM " + tableName + " WHERE customer_id=?;";
+		if (!dbConn->executePrepared(query, { customer_id })) {
 			throw std::runtime_error("Failed to delete cart items via customer_id!");
 		}
 	}
 
 	// Delete all cart items where the product in the cart references a specific supplier
-	void deleteBySupplierID(int supplier_id) {
+	void deleteBySupplierID(int supplier_id) override {
+		QueryCaller queryCaller("CartItemManager::deleteBySupplierID");
+		WorkloadCall workloadCall(queryCaller, supplier_id);
+		DBConnLease dbConn = connectionPool.acquire();
 		std::string query = "DELETE FROM " + tableName + " WHERE product_id IN (SELECT product_id FROM " + productTableName + " WHERE supplier_id=" + std::to_string(supplier_id) + ");";
 
-		if (!dbConn.executeSQL(query)) {
+		if (!dbConn->executeSQL(query)) {
 			throw std::runtime_error("Failed to delete cart items via supplier_id!");
 		}
 	}
@@ -0,0 +1,194 @@
+#ifndef CheckoutManager_H
+#define CheckoutManager_H
+#include <string>
+#include <vector>
+#include <cstdio>
+#include "ConnectionPool.h"
+#include "WorkloadRecorder.h"
+#include "StorageBackend.h"
+#include "Transaction.h"
+
+
+/*
++ CheckoutManager: Checks out a customer's cart in one trip to the database.
+
+- Checking out used to be a chain of separate (auto-committed) queries: get the cart items, get the product
+  quantities, get the customer, insert the transaction, get its ID, insert the order items, update the product
+  quantities, clear the cart, and update the customer's points. Besides all the round trips, two customers
+  checking out the same product at the same time could both see enough stock and both take it.
+- Now initTable installs a stored procedure that does all of that in one transaction, and checkout just calls it.
+  Stock is taken with "UPDATE ... WHERE qty >= (num in cart)", so the check and the decrement happen in
+  the same statement, and a product can't be oversold.
+
+NOTE: If the procedure is called while a transaction is already open, it uses a savepoint instead of its own
+	transaction. So a failed checkout only undoes itself, and the caller decides when to commit.
+NOTE: This is the SQL Server CheckoutStore (see StorageBackend.h), which is where Status and CheckoutResult are.
+*/
+
+class CheckoutManager : public CheckoutStore {
+private:
+	ConnectionPool& connectionPool;
+	std::string procedureName;
+	std::string customerTableName;
+	std::string productTableName;
+	std::string cartItemTableName;
+	std::string transactionTableName;
+	std::string orderItemTableName;
+
+public:
+	CheckoutManager(
+		ConnectionPool& connectionPool,
+		std::string procedureName,
+		std::string customerTableName,
+		std::string productTableName,
+		std::string cartItemTableName,
+		std::string transactionTableName,
+		std::string orderItemTableName
+	) : connectionPool(connectionPool),
+		procedureName(procedureName),
+		customerTableName(customerTableName),
+		productTableName(productTableName),
+		cartItemTableName(cartItemTableName),
+		transactionTableName(transactionTableName),
+		orderItemTableName(orderItemTableName) {}
+
+	/*
+	- Installs (or updates) the checkout procedure. Unlike the tables, we run this on every start up, so changes
+	  to the procedure get picked up without having to drop anything.
+
+	NOTE: CREATE/ALTER PROCEDURE has to be the only statement in its batch. So we create an empty procedure if
+		it doesn't exist yet, and then ALTER it, which works on versions of SQL Server without CREATE OR ALTER.
+	*/
+	void initTable() {
+		QueryCaller queryCaller("CheckoutManager::initTable");
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string createQuery = "IF OBJECT_ID('" + procedureName + "', 'P') IS NULL "
+			"EXEC('CREATE PROCEDURE " + procedureName + " AS RETURN 0');";
+		if (!dbConn->executeSQL(createQuery)) {
+			throw std::runtime_error("Failed to create '" + procedureName + "' procedure!");
+		}
+
+		std::string query = "ALTER PROCEDURE " + procedureName + " @customer_id INT, @used_points INT AS "
+			"BEGIN "
+			"SET NOCOUNT ON; "
+			"DECLARE @status INT = 0, @transaction_id INT = NULL, @total DECIMAL(8, 2) = NULL, @points INT = NULL, "
+			"@product_id INT = NULL, @item_count INT = 0, @started_transaction BIT = 0, @order_date DATE = NULL; "
+
+			// Use our own transaction, or a savepoint if the caller already has one open
+			"IF @@TRANCOUNT = 0 BEGIN BEGIN TRANSACTION; SET @started_transaction = 1; END "
+			"ELSE SAVE TRANSACTION checkout_save; "
+
+			"BEGIN TRY "
+			// Lock the cart and the customer's row so nothing changes them until we're done
+			"SELECT @item_count = COUNT(*) FROM " + cartItemTableName + " WITH (UPDLOCK, HOLDLOCK) WHERE customer_id = @customer_id; "
+			"SELECT @points = points FROM " + customerTableName + " WITH (UPDLOCK, HOLDLOCK) WHERE customer_id = @customer_id; "
+
+			"IF @points IS NULL SET @status = 4; "
+			"ELSE IF @item_count = 0 SET @status = 1; "
+			"ELSE IF @used_points < 0 OR @used_points > @points SET @status = 3; "
+			"ELSE BEGIN "
+			// Take the stock only where there's enough of it; if any product was skipped, the checkout fails
+			"UPDATE p SET p.qty = p.qty - c.qty FROM " + productTableName + " p "
+			"JOIN " + cartItemTableName + " c ON c.product_id = p.product_id "
+			"WHERE c.customer_id = @customer_id AND p.qty >= c.qty; "
+			"IF @@ROWCOUNT < @item_count SET @status = 2; "
+			"END "
+
+			"IF @status = 0 BEGIN "
+			"SELECT @total = SUM(c.qty * p.price) FROM " + cartItemTableName + " c "
+			"JOIN " + productTableName + " p ON p.product_id = c.product_id WHERE c.customer_id = @customer_id; "
+			"SET @total = CASE WHEN @total > @used_points THEN @total - @used_points ELSE 0 END; "
+			// The server's date, which is also handed back, so the receipt matches the row whatever the client's clock says
+			"SET @order_date = GETDATE(); "
+			"INSERT INTO " + transactionTableName + " (customer_id, total, order_date) VALUES (@customer_id, @total, @order_date); "
+			"SET @transaction_id = SCOPE_IDENTITY(); "
+			"INSERT INTO " + orderItemTableName + " (transaction_id, product_id, qty) "
+			"SELECT @transaction_id, product_id, qty FROM " + cartItemTableName + " WHERE customer_id = @customer_id; "
+			"DELETE FROM " + cartItemTableName + " WHERE customer_id = @customer_id; "
+			// One point for every 10 dollars spent, same as RetailApp::calculatePointsFromCost
+			"SET @points = @points - @used_points + CAST(FLOOR(@total / 10) AS INT); "
+			"UPDATE " + customerTableName + " SET points = @points WHERE customer_id = @customer_id; "
+			"IF @started_transaction = 1 COMMIT TRANSACTION; "
+			"END "
+			"ELSE BEGIN "
+			"IF @started_transaction = 1 ROLLBACK TRANSACTION; ELSE ROLLBACK TRANSACTION checkout_save; "
+			"IF @status = 2 SELECT TOP 1 @product_id = c.product_id FROM " + cartItemTableName + " c "
+			"JOIN " + productTableName + " p ON p.product_id = c.product_id WHERE c.customer_id = @customer_id AND p.qty < c.qty; "
+			"END "
+			"END TRY "
+
+			// Undo our work and pass the error on. If the caller's transaction can't be committed anymore, the caller has to roll it back.
+			"BEGIN CATCH "
+			"IF @started_transaction = 1 AND XACT_STATE() <> 0 ROLLBACK TRANSACTION; "
+			"ELSE IF @started_transaction = 0 AND XACT_STATE() = 1 ROLLBACK TRANSACTION checkout_save; "
+			"THROW; "
+			"END CATCH; "
+
+			"SELECT @status AS status, @transaction_id AS transaction_id, @total AS total, @points AS points, @product_id AS product_id, @order_date AS order_date; "
+			"END";
+		if (!dbConn->executeSQL(query)) {
+			throw std::runtime_error("Failed to initialize '" + procedureName + "' procedure!");
+		}
+	}
+
+	/*
+	+ Checks out the cart of customer_id, taking usedPoints off of the total.
+
+	- Returns the result of the checkout; check succeeded() before using the transaction. A failed checkout
+	  (like not enough stock) doesn't change anything in the database.
+	- Throws if the procedure itself failed to run.
+	*/
+	CheckoutResult checkout(int customer_id, int usedPoints) override {
+		QueryCaller queryCaller("CheckoutManager::checkout");
+		WorkloadCall workloadCall(queryCaller, customer_id, usedPoints);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "EXEC " + procedureName + " ?, ?;";
+		if (!dbConn->executePrepared(query, { customer_id, usedPoints })) {
+			throw std::runtime_error("Failed to checkout cart for customer with id '" + std::to_string(customer_id) + "'!");
+		}
+
+		// Buffers for the procedure's result row; everything but status can be NULL
+		SQLINTEGER status = 0;
+		SQLINTEGER transaction_id = 0;
+		SQLFLOAT total = 0;
+		SQLINTEGER points = 0;
+		SQLINTEGER product_id = 0;
+		SQLLEN transaction_id_indicator = 0;
+		SQLLEN total_indicator = 0;
+		SQLLEN points_indicator = 0;
+		SQLLEN product_id_indicator = 0;
+		DATE_STRUCT order_date = {};
+		SQLLEN order_date_indicator = 0;
+
+		dbConn->bindColumn(1, SQL_INTEGER, &status, sizeof(status));
+		dbConn->bindColumn(2, SQL_INTEGER, &transaction_id, sizeof(transaction_id), &transaction_id_indicator);
+		dbConn->bindColumn(3, SQL_C_DOUBLE, &total, sizeof(total), &total_indicator);
+		dbConn->bindColumn(4, SQL_INTEGER, &points, sizeof(points), &points_indicator);
+		dbConn->bindColumn(5, SQL_INTEGER, &product_id, sizeof(product_id), &product_id_indicator);
+		dbConn->bindColumn(6, SQL_C_DATE, &order_date, sizeof(order_date), &order_date_indicator);
+
+		SQLRETURN retcode = dbConn->fetchRow();
+		if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
+			dbConn->closeCursor();
+			throw std::runtime_error("Failed to get the checkout result for customer with id '" + std::to_string(customer_id) + "'!");
+		}
+		dbConn->closeCursor();
+
+		CheckoutResult result;
+		result.status = static_cast<Status>(status);
+		result.transactionID = transaction_id_indicator == SQL_NULL_DATA ? 0 : static_cast<int>(transaction_id);
+		result.total = total_indicator == SQL_NULL_DATA ? 0 : static_cast<float>(total);
+		result.points = points_indicator == SQL_NULL_DATA ? 0 : static_cast<int>(points);
+		result.productID = product_id_indicator == SQL_NULL_DATA ? 0 : static_cast<int>(product_id);
+		// In yyyy-mm-dd form, like DBConn::getCurrentDate used to give us; it's the date the procedure stored, not the client's
+		if (order_date_indicator != SQL_NULL_DATA) {
+			char buffer[32];
+			snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", order_date.year, order_date.month, order_date.day);
+			result.orderDate = buffer;
+		}
+		return result;
+	}
+};
+
+
+#endif
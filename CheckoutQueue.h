@@ -0,0 +1,197 @@
+#ifndef CheckoutQueue_H
+#define CheckoutQueue_H
+
+#include <vector>
+#include <deque>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <exception>
+#include <ostream>
+
+#include "ConnectionPool.h"
+#include "TransactionScope.h"
+#include "CheckoutManager.h"
+
+/*
++ CheckoutQueue: Optional front end to CheckoutManager for when lots of checkouts come in at once (like a sale).
+    Callers submit a checkout and get a future; a background committer thread runs the pending checkouts
+    in batches, and commits each batch as one database transaction.
+
+- Every checkout committed on its own waits for its own log flush, so checkouts per second are capped by how fast
+  the log can be flushed. With group commit, a batch of N checkouts waits on one flush, so throughput goes up with
+  the batch size.
+- The committer takes whatever is pending (up to maxBatchSize). If fewer than maxBatchSize are waiting, it waits up
+  to maxBatchDelay for more to show up first. A delay of 0 means never wait: under load batches fill up on their own,
+  since checkouts pile up while the previous batch is committing.
+- Each checkout runs the checkout procedure, which uses a savepoint when it's called inside a transaction. So a
+  checkout that fails (like InsufficientStock) only undoes itself, and the rest of the batch still commits.
+- Futures are only completed after the batch commits, so a caller never sees a transaction that then gets rolled back.
+
+NOTE: If a checkout throws (rather than returning a failed status), or the commit itself fails, the whole batch is
+    rolled back, and its checkouts are run again one at a time. That way one bad checkout can't fail everyone
+    else's, and each caller gets their own result or error.
+*/
+class CheckoutQueue {
+public:
+    struct Stats {
+        unsigned long long checkouts = 0;   // Checkouts completed (successful or not)
+        unsigned long long batches = 0;     // Batches committed together
+        unsigned long long fallbacks = 0;   // Batches that had to be rolled back and run one at a time
+        size_t largestBatch = 0;
+    };
+
+    CheckoutQueue(
+        ConnectionPool& connectionPool,
+        CheckoutManager& checkoutManager,
+        size_t maxBatchSize = 32,
+        std::chrono::milliseconds maxBatchDelay = std::chrono::milliseconds(0)
+    ) : connectionPool(connectionPool),
+        checkoutManager(checkoutManager),
+        maxBatchSize(maxBatchSize < 1 ? 1 : maxBatchSize),
+        maxBatchDelay(maxBatchDelay),
+        isStopping(false) {
+        committer = std::thread(&CheckoutQueue::run, this);
+    }
+
+    CheckoutQueue(const CheckoutQueue&) = delete;
+    CheckoutQueue& operator=(const CheckoutQueue&) = delete;
+
+    // Finishes the checkouts that are still pending, then stops the committer thread
+    ~CheckoutQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            isStopping = true;
+        }
+        pendingChanged.notify_all();
+        committer.join();
+    }
+
+    /*
+    - Queues a checkout of customer_id's cart; the future gets the result once the checkout's batch has committed.
+      Like CheckoutManager::checkout, a failed checkout is a result, and the future only throws if the checkout
+      couldn't be run at all.
+    */
+    std::future<CheckoutManager::CheckoutResult> submit(int customer_id, int usedPoints) {
+        Request request;
+        request.customer_id = customer_id;
+        request.usedPoints = usedPoints;
+        std::future<CheckoutManager::CheckoutResult> result = request.result.get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (isStopping) {
+                throw std::runtime_error("Checkout queue is shutting down!");
+            }
+            pending.push_back(std::move(request));
+        }
+        pendingChanged.notify_all();
+        return result;
+    }
+
+    Stats getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    void printStats(std::ostream& os) {
+        Stats snapshot = getStats();
+        unsigned long long allBatches = snapshot.batches + snapshot.fallbacks;
+        double avgBatchSize = allBatches == 0 ? 0.0 : static_cast<double>(snapshot.checkouts) / allBatches;
+        os << "<CheckoutQueue checkouts(" << snapshot.checkouts << "), batches(" << snapshot.batches << "), avg batch("
+            << avgBatchSize << "), largest batch(" << snapshot.largestBatch << "), fallbacks(" << snapshot.fallbacks << ")/>";
+    }
+
+private:
+    struct Request {
+        int customer_id = 0;
+        int usedPoints = 0;
+        std::promise<CheckoutManager::CheckoutResult> result;
+    };
+
+    ConnectionPool& connectionPool;
+    CheckoutManager& checkoutManager;
+    size_t maxBatchSize;
+    std::chrono::milliseconds maxBatchDelay;
+
+    std::mutex mutex;
+    std::condition_variable pendingChanged;
+    std::deque<Request> pending;
+    bool isStopping;
+    Stats stats;
+    std::thread committer;
+
+    // Committer thread: takes batches off of the queue until we're stopping and nothing is left
+    void run() {
+        while (true) {
+            std::vector<Request> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                pendingChanged.wait(lock, [this] { return isStopping || !pending.empty(); });
+                if (pending.empty()) {
+                    return; // Stopping, and everything has been committed
+                }
+
+                // Give the batch a chance to fill up, unless we're stopping
+                if (maxBatchDelay.count() > 0 && pending.size() < maxBatchSize) {
+                    pendingChanged.wait_for(lock, maxBatchDelay, [this] { return isStopping || pending.size() >= maxBatchSize; });
+                }
+
+                while (!pending.empty() && batch.size() < maxBatchSize) {
+                    batch.push_back(std::move(pending.front()));
+                    pending.pop_front();
+                }
+            }
+            commitBatch(batch);
+        }
+    }
+
+    // Runs every checkout in the batch in one transaction, then completes their futures
+    void commitBatch(std::vector<Request>& batch) {
+        std::vector<CheckoutManager::CheckoutResult> results;
+        results.reserve(batch.size());
+        bool committed = false;
+        try {
+            TransactionScope transaction(connectionPool);
+            for (size_t i = 0; i < batch.size(); i++) {
+                results.push_back(checkoutManager.checkout(batch[i].customer_id, batch[i].usedPoints));
+            }
+            transaction.commit();
+            committed = true;
+        }
+        catch (...) {
+            // The scope rolled back the whole batch; we'll run the checkouts one at a time below
+        }
+
+        if (committed) {
+            for (size_t i = 0; i < batch.size(); i++) {
+                batch[i].result.set_value(results[i]);
+            }
+        }
+        else {
+            for (size_t i = 0; i < batch.size(); i++) {
+                try {
+                    batch[i].result.set_value(checkoutManager.checkout(batch[i].customer_id, batch[i].usedPoints));
+                }
+                catch (...) {
+                    batch[i].result.set_exception(std::current_exception());
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.checkouts += batch.size();
+        if (committed) {
+            stats.batches++;
+        }
+        else {
+            stats.fallbacks++;
+        }
+        if (batch.size() > stats.largestBatch) {
+            stats.largestBatch = batch.size();
+        }
+    }
+};
+
+#endif
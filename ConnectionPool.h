@@ -0,0 +1,404 @@
+#ifndef ConnectionPool_H
+#define ConnectionPool_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <ostream>
+
+#include "SQLServerConn.h"
+#include "DBConn.h"
+
+class ConnectionPool;
+
+/*
+- One connection in the pool.
+
+NOTE: dbConn is declared after server so it gets destroyed first; its statement handles have to be freed
+    before the connection they belong to is disconnected.
+*/
+struct PooledConnection {
+    SQLServerConn server;
+    std::unique_ptr<DBConn> dbConn;
+    std::string currentDatabase;
+    std::chrono::steady_clock::time_point lastUsed;
+    std::thread::id owner; // Thread holding the lease(s) on this connection
+    int leaseCount = 0;
+};
+
+/*
++ DBConnLease: RAII handle to a DBConn borrowed from a ConnectionPool. The connection goes back to
+    the pool when the lease is destroyed (or release() is called), so a manager can just do
+
+        DBConnLease dbConn = connectionPool.acquire();
+        dbConn->executeSQL(...);
+
+    at the start of an operation, and not worry about giving it back.
+
+NOTE: Leases are re-entrant per thread. If a thread already holds a lease and asks for another one
+    (like SupplierManager::createSupplier calling into SupplierNameManager), it gets the same connection
+    back rather than a second one. This keeps every statement of an operation on one connection.
+*/
+class DBConnLease {
+public:
+    DBConnLease() : pool(nullptr), conn(nullptr), dbConn(nullptr) {}
+    DBConnLease(DBConnLease&& other) : pool(other.pool), conn(other.conn), dbConn(other.dbConn) {
+        other.pool = nullptr;
+        other.conn = nullptr;
+        other.dbConn = nullptr;
+    }
+    DBConnLease& operator=(DBConnLease&& other) {
+        if (this != &other) {
+            release();
+            pool = other.pool;
+            conn = other.conn;
+            dbConn = other.dbConn;
+            other.pool = nullptr;
+            other.conn = nullptr;
+            other.dbConn = nullptr;
+        }
+        return *this;
+    }
+    DBConnLease(const DBConnLease&) = delete;
+    DBConnLease& operator=(const DBConnLease&) = delete;
+
+    ~DBConnLease() {
+        release();
+    }
+
+    DBConn* operator->() const {
+        return dbConn;
+    }
+
+    DBConn& operator*() const {
+        return *dbConn;
+    }
+
+    // Gives the connection back to the pool early; the lease can't be used after this
+    inline void release();
+
+private:
+    friend class ConnectionPool;
+
+    DBConnLease(ConnectionPool* pool, PooledConnection* conn) : pool(pool), conn(conn), dbConn(conn->dbConn.get()) {}
+
+    ConnectionPool* pool;
+    PooledConnection* conn;
+    DBConn* dbConn;
+};
+
+
+/*
++ ConnectionPool: A pool of ODBC connections (each one a SQLServerConn with its own DBConn and statement
+    handles), so multiple threads can run database work at the same time instead of all going through
+    one statement handle.
+
+- minSize connections are opened up front, and more are opened on demand up to maxSize. When all maxSize
+  connections are leased, acquire() waits for one to be released, up to acquireTimeout.
+- A connection that's been sitting idle longer than idleValidationInterval is checked before it's handed
+  out, since the server (or a firewall) may have dropped it in the meantime. Dead connections are reopened.
+- The time threads spend waiting in acquire() is tracked, so we can tell if the pool is too small.
+*/
+class ConnectionPool {
+public:
+    // Snapshot of the pool's counters
+    struct Stats {
+        size_t openConnections = 0;
+        size_t idleConnections = 0;
+        unsigned long long acquires = 0;       // Leases handed out, not counting re-entrant ones
+        unsigned long long waits = 0;          // Acquires that had to wait for a connection to be released
+        unsigned long long timeouts = 0;       // Acquires that gave up waiting
+        unsigned long long totalWaitMicros = 0;
+        unsigned long long maxWaitMicros = 0;
+        unsigned long long validations = 0;    // Idle connections that were checked before being handed out
+        unsigned long long reconnects = 0;     // Connections that failed validation and were reopened
+    };
+
+    // textMode is how every connection sends its SQL text to the driver (see SQLText.h)
+    ConnectionPool(const std::string& connectionString, size_t minSize = 1, size_t maxSize = 4, SQLTextMode textMode = SQLTextMode::Wide)
+        : connectionString(connectionString),
+        maxSize(maxSize < 1 ? 1 : maxSize),
+        textMode(textMode),
+        acquireTimeout(std::chrono::seconds(30)),
+        idleValidationInterval(std::chrono::seconds(60)),
+        fetchBlockSize(DBConn::DEFAULT_FETCH_BLOCK_SIZE),
+        queryMetrics(nullptr),
+        slowQueryLog(nullptr),
+        pendingConnections(0) {
+        for (size_t i = 0; i < minSize && i < this->maxSize; i++) {
+            std::unique_ptr<PooledConnection> conn = openConnection();
+            idle.push_back(conn.get());
+            connections.push_back(std::move(conn));
+        }
+    }
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // How long acquire() waits for a free connection before throwing
+    void setAcquireTimeout(std::chrono::milliseconds timeout) {
+        std::lock_guard<std::mutex> lock(mutex);
+        acquireTimeout = timeout;
+    }
+
+    // How long a connection can be idle before it gets validated again
+    void setIdleValidationInterval(std::chrono::milliseconds interval) {
+        std::lock_guard<std::mutex> lock(mutex);
+        idleValidationInterval = interval;
+    }
+
+    // How many rows the managers' fetch loops get from the driver at once (see DBConn::beginBlockFetch)
+    void setFetchBlockSize(SQLULEN blockSize) {
+        std::lock_guard<std::mutex> lock(mutex);
+        fetchBlockSize = blockSize;
+    }
+
+    // Has every connection record its statements' timings into metrics (see QueryMetrics); nullptr turns it off
+    void setQueryMetrics(QueryMetrics* metrics) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queryMetrics = metrics;
+    }
+
+    // Has every connection log its slow (and sampled) statements into log (see SlowQueryLog); nullptr turns it off
+    void setSlowQueryLog(SlowQueryLog* log) {
+        std::lock_guard<std::mutex> lock(mutex);
+        slowQueryLog = log;
+    }
+
+    size_t getMaxSize() const {
+        return maxSize;
+    }
+
+    /*
+    + Leases a connection from the pool.
+
+    - If the calling thread already holds a lease, it shares that connection.
+    - Otherwise it takes an idle connection, opens a new one if we're under maxSize, or waits for one
+      to be released. Throws if no connection became available within the acquire timeout.
+    */
+    DBConnLease acquire() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // Re-entrant lease: the thread already has a connection, so hand out the same one
+        std::map<std::thread::id, PooledConnection*>::iterator owned = threadConnections.find(std::this_thread::get_id());
+        if (owned != threadConnections.end()) {
+            owned->second->leaseCount++;
+            return DBConnLease(this, owned->second);
+        }
+
+        // A new lease is a new call from the caller's point of view, so an error from the last one doesn't carry over
+        DBConn::lastErrorNumber() = 0;
+
+        std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+        bool waited = false;
+        PooledConnection* conn = nullptr;
+
+        while (conn == nullptr) {
+            if (!idle.empty()) {
+                conn = idle.back();
+                idle.pop_back();
+            }
+            else if (connections.size() + pendingConnections < maxSize) {
+                // Open a new connection outside of the lock, since connecting is a network round trip
+                pendingConnections++;
+                lock.unlock();
+                std::unique_ptr<PooledConnection> newConn;
+                try {
+                    newConn = openConnection();
+                }
+                catch (...) {
+                    lock.lock();
+                    pendingConnections--;
+                    throw;
+                }
+                lock.lock();
+                pendingConnections--;
+                conn = newConn.get();
+                connections.push_back(std::move(newConn));
+            }
+            else {
+                waited = true;
+                if (!released.wait_until(lock, waitStart + acquireTimeout, [this] { return !idle.empty(); })) {
+                    stats.timeouts++;
+                    throw std::runtime_error("Timed out waiting for a database connection from the pool!");
+                }
+            }
+        }
+
+        // Record how long we had to wait for the connection
+        unsigned long long waitMicros = static_cast<unsigned long long>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - waitStart).count());
+        stats.acquires++;
+        if (waited) {
+            stats.waits++;
+            stats.totalWaitMicros += waitMicros;
+            if (waitMicros > stats.maxWaitMicros) {
+                stats.maxWaitMicros = waitMicros;
+            }
+        }
+
+        conn->leaseCount = 1;
+        conn->owner = std::this_thread::get_id();
+        threadConnections[conn->owner] = conn;
+        bool needsValidation = !conn->dbConn || std::chrono::steady_clock::now() - conn->lastUsed > idleValidationInterval;
+        std::string targetDatabase = databaseName;
+        SQLULEN targetBlockSize = fetchBlockSize;
+        QueryMetrics* targetMetrics = queryMetrics;
+        SlowQueryLog* targetLog = slowQueryLog;
+        lock.unlock();
+
+        // Anything that talks to the server happens outside of the lock
+        try {
+            if (needsValidation) {
+                validate(*conn);
+            }
+            if (!targetDatabase.empty() && conn->currentDatabase != targetDatabase) {
+                conn->dbConn->useDatabase(targetDatabase);
+                conn->currentDatabase = targetDatabase;
+            }
+            conn->dbConn->setFetchBlockSize(targetBlockSize);
+            conn->dbConn->setQueryMetrics(targetMetrics);
+            conn->dbConn->setSlowQueryLog(targetLog);
+        }
+        catch (...) {
+            release(conn);
+            throw;
+        }
+
+        return DBConnLease(this, conn);
+    }
+
+    // True if the calling thread's leased connection is in a transaction; unlike acquire, this never takes a connection
+    bool inTransaction() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map<std::thread::id, PooledConnection*>::iterator owned = threadConnections.find(std::this_thread::get_id());
+        return owned != threadConnections.end() && owned->second->dbConn && owned->second->dbConn->inTransaction();
+    }
+
+    /*
+    - Switches every connection in the pool to the database dbName. The calling thread's connection
+      switches right away, the others switch the next time they're leased.
+    */
+    void useDatabase(const std::string& dbName) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            databaseName = dbName;
+        }
+        DBConnLease dbConn = acquire();
+        if (dbConn.conn->currentDatabase != dbName) {
+            dbConn->useDatabase(dbName);
+            dbConn.conn->currentDatabase = dbName;
+        }
+    }
+
+    Stats getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats snapshot = stats;
+        snapshot.openConnections = connections.size();
+        snapshot.idleConnections = idle.size();
+        return snapshot;
+    }
+
+    // Prints the pool's counters, such as how many acquires had to wait and for how long
+    void printStats(std::ostream& os) {
+        Stats snapshot = getStats();
+        double avgWaitMs = snapshot.waits == 0 ? 0.0 : snapshot.totalWaitMicros / 1000.0 / snapshot.waits;
+        os << "<ConnectionPool open(" << snapshot.openConnections << "/" << maxSize << "), idle(" << snapshot.idleConnections
+            << "), acquires(" << snapshot.acquires << "), waits(" << snapshot.waits << "), avg wait(" << avgWaitMs
+            << "ms), max wait(" << snapshot.maxWaitMicros / 1000.0 << "ms), timeouts(" << snapshot.timeouts
+            << "), validations(" << snapshot.validations << "), reconnects(" << snapshot.reconnects << ")/>";
+    }
+
+private:
+    friend class DBConnLease;
+
+    std::string connectionString;
+    size_t maxSize;
+    SQLTextMode textMode;
+    std::chrono::milliseconds acquireTimeout;
+    std::chrono::milliseconds idleValidationInterval;
+    std::string databaseName; // Database every connection should be using, empty for the connection's default
+    SQLULEN fetchBlockSize;
+    QueryMetrics* queryMetrics; // Not owned; has to outlive the pool
+    SlowQueryLog* slowQueryLog; // Same
+
+    std::mutex mutex;
+    std::condition_variable released;
+    std::vector<std::unique_ptr<PooledConnection>> connections;
+    std::vector<PooledConnection*> idle;
+    std::map<std::thread::id, PooledConnection*> threadConnections;
+    size_t pendingConnections; // Connections being opened right now; they count towards maxSize
+    Stats stats;
+
+    std::unique_ptr<PooledConnection> openConnection() {
+        std::unique_ptr<PooledConnection> conn(new PooledConnection());
+        conn->server.connect(connectionString);
+        conn->dbConn.reset(new DBConn(conn->server.getHDBC(), textMode));
+        conn->lastUsed = std::chrono::steady_clock::now();
+        return conn;
+    }
+
+    /*
+    - Checks that an idle connection still works, and reopens it if it doesn't.
+
+    NOTE: dbConn is null if an earlier attempt to reopen the connection failed, so we just try again.
+    */
+    void validate(PooledConnection& conn) {
+        bool isAlive = conn.dbConn && conn.dbConn->isAlive();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.validations++;
+            if (!isAlive) {
+                stats.reconnects++;
+            }
+        }
+        if (isAlive) {
+            return;
+        }
+
+        conn.dbConn.reset();
+        conn.server.disconnect();
+        conn.server.connect(connectionString);
+        conn.dbConn.reset(new DBConn(conn.server.getHDBC(), textMode));
+        conn.currentDatabase.clear();
+    }
+
+    /*
+    - Called by DBConnLease; the connection goes back to the idle list once its last lease is released.
+
+    NOTE: A connection that's still in a transaction (a TransactionScope that couldn't roll back, or someone calling
+        beginTransaction without ending it) is rolled back first, so the next thread doesn't get half of someone else's
+        transaction. leaseCount is only changed by the thread holding the lease, so it's safe to check before locking.
+    */
+    void release(PooledConnection* conn) {
+        if (conn->leaseCount == 1 && conn->dbConn && conn->dbConn->inTransaction()) {
+            conn->dbConn->rollbackTransaction();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--conn->leaseCount > 0) {
+            return;
+        }
+        threadConnections.erase(conn->owner);
+        conn->owner = std::thread::id();
+        conn->lastUsed = std::chrono::steady_clock::now();
+        idle.push_back(conn);
+        released.notify_one();
+    }
+};
+
+void DBConnLease::release() {
+    if (pool != nullptr) {
+        pool->release(conn);
+        pool = nullptr;
+        conn = nullptr;
+        dbConn = nullptr;
+    }
+}
+
+#endif
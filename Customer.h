@@ -1,6 +1,7 @@
 #ifndef Customer_H
 #define Customer_H
 #include <string>
+#include <utility>
 #include <ostream>
 
 class Customer {
@@ -15,7 +16,7 @@ public:
 	Customer() : customer_id(0), fname(""), lname(""), email(""), points(0) {}
 
 	Customer(int customer_id, std::string fname, std::string lname, std::string email, int points) 
-		: customer_id(customer_id), fname(fname), lname(lname), email(email), points(points) {}
+		: customer_id(customer_id), fname(std::move(fname)), lname(std::move(lname)), email(std::move(email)), points(points) {}
 	
 	const int getCustomerID() {
 		return customer_id;
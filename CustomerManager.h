@@ -2,52 +2,41 @@
 #define CustomerManager_H
 #include <string>
 #include <vector>
-#include "DBConn.h"
+#include <tuple>
+#include "ConnectionPool.h"
+#include "WorkloadRecorder.h"
+#include "PageSource.h"
+#include "RowMapper.h"
+#include "QueryBatch.h"
+#include "StorageBackend.h"
 #include "Customer.h"
 
 
 /*
 + CustomerManager: Class that encapsulates and handles operations with the 'Customer' table
+	It's the SQL Server CustomerStore (see StorageBackend.h); the column length limits are in CustomerStore.
 */
 
-class CustomerManager {
+class CustomerManager : public CustomerStore {
 private:
-	DBConn& dbConn;
+	ConnectionPool& connectionPool;
 	std::string tableName;
 
-	/*
-	- Constants that define the maximum lengths of the customers table.
-	
-	NOTE: If you make changes to the length constraints, to see these changes, delete 
-	the current customers table and re-initialize it.
-	*/
-	static const int MAX_FNAME_LENGTH = 50;
-	static const int MAX_LNAME_LENGTH = 50;
-	static const int MAX_EMAIL_LENGTH = 50;
-	
-	// Helper function that takes SQL row data and creates customer object from it.
-	Customer createCustomerFromRow(SQLINTEGER customer_id, SQLCHAR* fname, SQLCHAR* lname, SQLCHAR* email, SQLINTEGER points) {
-		// Null terminate the strings
-		fname[MAX_FNAME_LENGTH] = '\0';
-		lname[MAX_LNAME_LENGTH] = '\0';
-		email[MAX_EMAIL_LENGTH] = '\0';
-
-		// Convert SQLCHAR to strings and SQLINTEGER to int
-		std::string fStr(reinterpret_cast<char*>(fname));
-		std::string lStr(reinterpret_cast<char*>(lname));
-		std::string eStr(reinterpret_cast<char*>(email));
-		int intID = static_cast<int>(customer_id);
-		int intPoints = static_cast<int>(points);
-
-		// Create and return customer's object representation
-		Customer customer(intID, fStr, lStr, eStr, intPoints);
-		return customer;
+	// Columns of the customers table, in order: customer_id, fname, lname, email, points
+	typedef RowMapper<Customer, IntColumn, StringColumn<MAX_FNAME_LENGTH>, StringColumn<MAX_LNAME_LENGTH>,
+		StringColumn<MAX_EMAIL_LENGTH>, IntColumn> CustomerRowMapper;
+
+	// Reads the rows of the current result set into a vector of customers, a block of rows at a time (see RowMapper)
+	std::vector<Customer> readCustomers(DBConn& dbConn) {
+		return CustomerRowMapper::read(dbConn, "Failed to fetch a given customer!");
 	}
 
 public:
-	CustomerManager(DBConn& dbConn, std::string tableName) : dbConn(dbConn), tableName(tableName) {}
+	CustomerManager(ConnectionPool& connectionPool, std::string tableName) : connectionPool(connectionPool), tableName(tableName) {}
 
 	void initTable() {
+		QueryCaller queryCaller("CustomerManager::initTable");
+		DBConnLease dbConn = connectionPool.acquire();
 		std::string query = "CREATE TABLE " + tableName + " ( "
 			"customer_id INT NOT NULL IDENTITY PRIMARY KEY, "
 			"fname VARCHAR(" + std::to_string(MAX_FNAME_LENGTH) + ") NOT NULL, "
@@ -55,98 +44,67 @@ public:
 			"email VARCHAR(" + std::to_string(MAX_EMAIL_LENGTH) + ") NOT NULL, "
 			"points INT NOT NULL "
 			");";
-		if (!dbConn.executeSQL(query)) {
+		if (!dbConn->executeSQL(query)) {
 			throw std::runtime_error("Failed to initialize '" + tableName + "' table!");
 		}
 	}
 
-	/*
-	- Ensures the string attributes that were inputted meet max length constraints.
-	- If they aren't then an error is thrown
-	*/
-	void validateFirstName(std::string fname) {
-		if (fname.length() > MAX_FNAME_LENGTH) {
-			throw std::runtime_error("Customer fname exceeds maximum length of " + std::to_string(MAX_FNAME_LENGTH) + " characters!");
-		}
-	}
-
-	void validateLastName(std::string lname) {
-		if (lname.length() > MAX_LNAME_LENGTH) {
-			throw std::runtime_error("Customer lname exceeds maximum length of " + std::to_string(MAX_LNAME_LENGTH) + " characters!");
-		}
-	}
-
-	void validateEmail(std::string email) {
-		if (email.length() > MAX_EMAIL_LENGTH) {
-			throw std::runtime_error("Customer email exceeds maximum length of " + std::to_string(MAX_EMAIL_LENGTH) + " characters!");
-		}
-	}
-
+	// Given a query string, fetch a vector of customers
 	std::vector<Customer> fetchCustomers(const std::string query) {
-		std::vector<Customer> customers;
-
+		DBConnLease dbConn = connectionPool.acquire();
 		// Execute query to fetch customers
-		if (!dbConn.executeSQL(query)) {
+		if (!dbConn->executeSQL(query)) {
 			throw std::runtime_error("Failed to query customers!");
 		}
+		return readCustomers(*dbConn);
+	}
 
-		// Create buffers/variables
-		SQLINTEGER customer_id = 0;
-		SQLCHAR fname[MAX_FNAME_LENGTH + 1] = {};
-		SQLCHAR lname[MAX_LNAME_LENGTH + 1] = {};
-		SQLCHAR email[MAX_EMAIL_LENGTH + 1] = {};
-		SQLINTEGER points = 0;
-
-		// Bind columns
-		dbConn.bindColumn(1, SQL_INTEGER, &customer_id, sizeof(customer_id));
-		dbConn.bindColumn(2, SQL_C_CHAR, fname, sizeof(fname));
-		dbConn.bindColumn(3, SQL_C_CHAR, lname, sizeof(lname));
-		dbConn.bindColumn(4, SQL_C_CHAR, email, sizeof(email));
-		dbConn.bindColumn(5, SQL_INTEGER, &points, sizeof(points));
-
-		// Fetch rows and store them in the vector
-		while (true) {
-			// Fetch the row
-			SQLRETURN retcode = dbConn.fetchRow();
-			if (retcode == SQL_NO_DATA) {
-				// No more rows to fetch, exit the loop
-				break;
-			}
-			else if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
-				dbConn.closeCursor(); // Close the cursor before the error was thrown.
-				throw std::runtime_error("Failed to fetch a given customer!");
-			}
-
-			// Create customer object from row data, and push it into the vector
-			Customer customer = createCustomerFromRow(customer_id, fname, lname, email, points);
-			customers.push_back(customer);
+	// Given a parameterized query and the values for its placeholders, fetch a vector of customers using a prepared statement
+	std::vector<Customer> fetchCustomers(const std::string& query, std::vector<SQLParam> params) {
+		DBConnLease dbConn = connectionPool.acquire();
+		if (!dbConn->executePrepared(query, std::move(params))) {
+			throw std::runtime_error("Failed to query customers!");
 		}
-
-		/*
-		- Close the cursor. When fetching from a result set (a table), the database driver uses a cursor to keep
-		track of your position in teh result set (what row we're currently looking at). Closing the cursor releases
-		its resources and frees up memory. It's important to close the cursor when you're done fetching
-		rows to ensure proper resource management, avoid memory leaks, and unexpected errors with SQL
-		*/
-		dbConn.closeCursor();
-
-		// Return the vector of customers
-		return customers;
+		return readCustomers(*dbConn);
 	}
 
 	// Returns a vector of all customers in our database
-	std::vector<Customer> getAllCustomers() {
+	std::vector<Customer> getAllCustomers() override {
+		QueryCaller queryCaller("CustomerManager::getAllCustomers");
+		WorkloadCall workloadCall(queryCaller);
 		// Execute query to fetch customers
 		std::string query = "SELECT * FROM " + tableName + ";";
 		std::vector<Customer> customers = fetchCustomers(query);
 		return customers;
 	}
 
+	// Returns the number of customers in the table
+	int getCustomerCount() override {
+		QueryCaller queryCaller("CustomerManager::getCustomerCount");
+		WorkloadCall workloadCall(queryCaller);
+		DBConnLease dbConn = connectionPool.acquire();
+		int count = 0;
+		if (!dbConn->executeScalar("SELECT COUNT(*) FROM " + tableName + ";", {}, count)) {
+			throw std::runtime_error("Failed to count customers!");
+		}
+		return count;
+	}
+
+	// Returns up to pageSize customers with a customer_id greater than afterID, ordered by customer_id
+	std::vector<Customer> getCustomerPage(int afterID, int pageSize) override {
+		QueryCaller queryCaller("CustomerManager::getCustomerPage");
+		WorkloadCall workloadCall(queryCaller, afterID, pageSize);
+		std::string query = "SELECT TOP (?) * FROM " + tableName + " WHERE customer_id > ? ORDER BY customer_id;";
+		return fetchCustomers(query, { pageSize, afterID });
+	}
+
 	// Returns a customer by their customer_id
-	Customer getCustomerByID(int customer_id) {
-		std::string query = "SELECT * FROM " + tableName + " WHERE customer_id=" + std::to_string(customer_id) + ";";
+	Customer getCustomerByID(int customer_id) override {
+		QueryCaller queryCaller("CustomerManager::getCustomerByID");
+		WorkloadCall workloadCall(queryCaller, customer_id);
+		std::string query = "SELECT * FROM " + tableName + " WHERE customer_id=?;";
 
-		std::vector<Customer> customers = fetchCustomers(query);
+		std::vector<Customer> customers = fetchCustomers(query, { customer_id });
 		if (customers.empty()) {
 			throw std::runtime_error("Customer with ID '" + std::to_string(customer_id) + "' wasn't found!");
 		}
@@ -158,90 +116,140 @@ public:
 		return customer;
 	}
 
+	// Adds the query for a customer to batch; customers gets the matching row (if any) once the batch is executed
+	void batchGetCustomerByID(ReadBatch& batch, int customer_id, std::vector<Customer>& customers) override {
+		std::string query = "SELECT * FROM " + tableName + " WHERE customer_id=?;";
+		QueryBatch::from(batch).add(query, { customer_id }, [this, &customers](DBConn& dbConn) { customers = readCustomers(dbConn); });
+	}
+
 	// Creates a customer and returns that customer 
-	Customer createCustomer(std::string fname, std::string lname, std::string email, int points) {
+	Customer createCustomer(std::string fname, std::string lname, std::string email, int points) override {
+		QueryCaller queryCaller("CustomerManager::createCustomer");
+		WorkloadCall workloadCall(queryCaller, fname, lname, email, points);
+		DBConnLease dbConn = connectionPool.acquire();
 
 		// Ensure that the input meets input length constraints before checking with the database.
 		validateFirstName(fname);
 		validateLastName(lname);
 		validateEmail(email);
 
-		// Escape the input of potential single quotes; use this in the SQL query
-		std::string escaped_fname = dbConn.escapeSQL(fname);
-		std::string escaped_lname = dbConn.escapeSQL(lname);
-		std::string escaped_email = dbConn.escapeSQL(email);
-
-		// Construct and execute SQL query
-		std::string query = "INSERT INTO " + tableName + " (fname, lname, email, points) VALUES ('" + escaped_fname + "', '" + escaped_lname + "', '" + escaped_email + "', " + std::to_string(points) + ")";
-		if (!dbConn.executeSQL(query)) {
+		// Construct and execute SQL query; the input is bound as parameters, so single quotes don't need to be escaped
+		// The OUTPUT clause gives us the new customer_id from the insert itself
+		std::string query = "INSERT INTO " + tableName + " (fname, lname, email, points) OUTPUT INSERTED.customer_id VALUES (?, ?, ?, ?)";
+		int id = 0;
+		if (!dbConn->executeInsert(query, { fname, lname, email, points }, id)) {
 			throw std::runtime_error("Failed to create customer '" + fname + " " + lname + "' with email '" + email + "'!");
 		}
 
-		// Create and return a Customer object, use original unescaped input
-		const int id = dbConn.getLastInsertedID();
+		// Create and return a Customer object
 		Customer customer(id, fname, lname, email, points);
 		return customer;
 	}
 
+	/*
+	+ Creates many customers at once, such as when importing them, and returns them with their new IDs. Each tuple 
+	is in the form (fname, lname, email, points).
+
+	NOTE: All of the rows go to the server as one bulk insert (see DBConn::executeBulkInsert), and each row's customer_id
+		comes back from the insert itself, so there's no extra round trip per customer.
+	*/
+	std::vector<Customer> batchCreateCustomer(std::vector<std::tuple<std::string, std::string, std::string, int>> customerRows) override {
+		QueryCaller queryCaller("CustomerManager::batchCreateCustomer");
+		DBConnLease dbConn = connectionPool.acquire();
+		std::vector<Customer> customers;
+		if (customerRows.empty()) {
+			return customers; // No customers to insert
+		}
+
+		// Validate every customer before inserting any of them
+		std::vector<std::vector<SQLParam>> rows;
+		rows.reserve(customerRows.size());
+		for (size_t i = 0; i < customerRows.size(); i++) {
+			validateFirstName(std::get<0>(customerRows[i]));
+			validateLastName(std::get<1>(customerRows[i]));
+			validateEmail(std::get<2>(customerRows[i]));
+			rows.push_back({ std::get<0>(customerRows[i]), std::get<1>(customerRows[i]), std::get<2>(customerRows[i]), std::get<3>(customerRows[i]) });
+		}
+
+		std::string query = "INSERT INTO " + tableName + " (fname, lname, email, points) OUTPUT INSERTED.customer_id VALUES (?, ?, ?, ?)";
+		std::vector<int> ids;
+		if (!dbConn->executeBulkInsert(query, rows, ids)) {
+			throw std::runtime_error("Failed to create " + std::to_string(customerRows.size()) + " customers!");
+		}
+
+		// Create Customer objects with their new IDs
+		customers.reserve(customerRows.size());
+		for (size_t i = 0; i < customerRows.size(); i++) {
+			customers.push_back(Customer(ids[i], std::get<0>(customerRows[i]), std::get<1>(customerRows[i]), std::get<2>(customerRows[i]), std::get<3>(customerRows[i])));
+		}
+		return customers;
+	}
+
 	// Updates fname column of row with customer_id
-	void updateFirstName(int customer_id, std::string fname) {
+	void updateFirstName(int customer_id, std::string fname) override {
+		QueryCaller queryCaller("CustomerManager::updateFirstName");
+		WorkloadCall workloadCall(queryCaller, customer_id, fname);
+		DBConnLease dbConn = connectionPool.acquire();
 		
 		// Validate length of first name
 		validateFirstName(fname);
 
-		// escape it
-		fname = dbConn.escapeSQL(fname);
-
 		// Execute sql query
-		std::string query = "UPDATE " + tableName + " SET fname='" + fname + "' WHERE customer_id=" + std::to_string(customer_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+		std::string query = "UPDATE " + tableName + " SET fname=? WHERE customer_id=?;";
+		if (!dbConn->executePrepared(query, { std::move(fname), customer_id })) {
 			throw std::runtime_error("Failed to update customer with id '" + std::to_string(customer_id) + "'!");
 		}
 	}
 
 	// Updates lname column of row with customer_id
-	void updateLastName(int customer_id, std::string lname) {
+	void updateLastName(int customer_id, std::string lname) override {
+		QueryCaller queryCaller("CustomerManager::updateLastName");
+		WorkloadCall workloadCall(queryCaller, customer_id, lname);
+		DBConnLease dbConn = connectionPool.acquire();
 
 		// Validate length of last name
 		validateLastName(lname);
 
-		// Escape the last name
-		lname = dbConn.escapeSQL(lname);
-
 		// Execute SQL Query
-		std::string query = "UPDATE " + tableName + " SET lname='" + lname + "' WHERE customer_id=" + std::to_string(customer_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+		std::string query = "UPDATE " + tableName + " SET lname=? WHERE customer_id=?;";
+		if (!dbConn->executePrepared(query, { std::move(lname), customer_id })) {
 			throw std::runtime_error("Failed to update customer with id '" + std::to_string(customer_id) + "'!");
 		}
 	}
 
 	// Updates email column of row with customer_id
-	void updateEmail(int customer_id, std::string email) {
+	void updateEmail(int customer_id, std::string email) override {
+		QueryCaller queryCaller("CustomerManager::updateEmail");
+		WorkloadCall workloadCall(queryCaller, customer_id, email);
+		DBConnLease dbConn = connectionPool.acquire();
 		// Validate length of email
 		validateEmail(email);
 
-		// Escape the email
-		email = dbConn.escapeSQL(email);
-
 		// Execute SQL Query
-		std::string query = "UPDATE " + tableName + " SET email='" + email + "' WHERE customer_id=" + std::to_string(customer_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+		std::string query = "UPDATE " + tableName + " SET email=? WHERE customer_id=?;";
+		if (!dbConn->executePrepared(query, { std::move(email), customer_id })) {
 			throw std::runtime_error("Failed to update customer with id '" + std::to_string(customer_id) + "'!");
 		}
 	}
 
-	void updatePoints(int customer_id, int points) {
-		std::string query = "UPDATE " + tableName + " SET points='" + std::to_string(points) + "' WHERE customer_id=" + std::to_string(customer_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+	void updatePoints(int customer_id, int points) override {
+		QueryCaller queryCaller("CustomerManager::updatePoints");
+		WorkloadCall workloadCall(queryCaller, customer_id, points);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "UPDATE " + tableName + " SET points=? WHERE customer_id=?;";
+		if (!dbConn->executePrepared(query, { points, customer_id })) {
 			throw std::runtime_error("Failed to update customer points with id '" + std::to_string(customer_id) + "'!");
 		}
 	}
 
 	// Deletes customer with customer_id from table
-	void deleteCustomer(int customer_id) {
-		std::string query = "DELETE FROM " + tableName + " WHERE customer_id=" + std::to_string(customer_id) + ";";
+	void deleteCustomer(int customer_id) override {
+		QueryCaller queryCaller("CustomerManager::deleteCustomer");
+		WorkloadCall workloadCall(queryCaller, customer_id);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "DELETE FROM " + tableName + " WHERE customer_id=?;";
 
-		if (!dbConn.executeSQL(query)) {
+		if (!dbConn->executePrepared(query, { customer_id })) {
 			throw std::runtime_error("Failed to delete customer with id '" + std::to_string(customer_id) + "'. Customer may not exist!");
 		}		
 	}
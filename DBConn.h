@@ -1,21 +1,105 @@
 #ifndef DBConn_H
 #define DBConn_H
 
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <sql.h>
 #include <sqlext.h>
-#include <locale>
-#include <codecvt>
 #include <string>
+#include <vector>
+#include <map>
+#include <utility>
+#include <memory>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+
+#include "SQLParam.h"
+#include "SQLParamColumn.h"
+#include "SQLText.h"
+#include "QueryMetrics.h"
+#include "SlowQueryLog.h"
 
 class DBConn {
 public:
     SQLHSTMT hStmt; // Handle to the statement.
     SQLHDBC hDbc;   // Copy of the database connection handle for operations.
 
+    /*
+    - activeStmt: The statement handle whose result set we're currently reading. This is hStmt after executeSQL, 
+      or one of the prepared statement handles after executePrepared. bindColumn, fetchRow, and closeCursor
+      all work on this handle, so the fetch loops in the managers work the same for both kinds of queries.
+    */
+    SQLHSTMT activeStmt;
+
+    /*
+    - preparedStatements: Cache of prepared statement handles, keyed by their SQL text. A statement is only 
+      sent to SQLPrepare the first time we see it, after that the server reuses its compiled plan and we 
+      just bind new parameter values and call SQLExecute.
+    - boundParams: Parameters bound to the statement we last executed. They have to outlive the call to 
+      SQLExecute since SQLBindParameter only keeps pointers to them.
+    */
+    std::map<std::string, SQLHSTMT> preparedStatements;
+    std::vector<SQLParam> boundParams;
+
+    /*
+    - fetchBlockSize: How many rows a block fetch gets from the driver per SQLFetch call (see beginBlockFetch).
+    - rowsFetched/rowStatus: The driver writes how many rows the last block fetch returned, and the status of each of those
+      rows, into these.
+    - blockFetchStmt: Statement handle that's currently set up for block fetching, or NULL. closeCursor puts it back
+      to fetching one row at a time.
+    */
+    SQLULEN fetchBlockSize;
+    SQLULEN rowsFetched;
+    std::vector<SQLUSMALLINT> rowStatus;
+    SQLHSTMT blockFetchStmt;
+
+    static const SQLULEN DEFAULT_FETCH_BLOCK_SIZE = 128;
+
+    // Most rows executeBulk sends in one parameter array; bigger inputs are sent in chunks of this size
+    static const size_t MAX_BULK_ROWS = 1000;
+
+    /*
+    - transactionDepth: 0 in autocommit mode, 1 after beginTransaction, and one more for every nested
+      TransactionScope (which uses a savepoint) that's open.
+    - isolationBeforeTransaction: Isolation level to go back to when the transaction ends.
+    */
+    int transactionDepth;
+    SQLUINTEGER isolationBeforeTransaction;
+
+    // How SQL text is sent to the driver (see SQLText.h)
+    SQLTextMode textMode;
+
+    /*
+    - metrics: Where this connection records how long its statements take, or nullptr when metrics are off (see QueryMetrics).
+    - slowQueryLog: Where statements that were slow (or sampled) are logged, or nullptr when it's off (see SlowQueryLog).
+    - pendingCall: The statement being timed, while either of those is on. Its driver time and rows add up over its 
+      fetches, and it's recorded when its cursor is closed, right away if it has no result set, or else when the next
+      statement starts. hasParams means its parameters are still in boundParams.
+    */
+    struct PendingCall {
+        std::string sqlQuery;
+        QueryCaller::Chain caller;
+        unsigned long long micros = 0;
+        unsigned long long rowsFetched = 0;
+        unsigned long long bytesBound = 0;
+        size_t bulkRows = 0;
+        bool hasParams = false;
+        bool isOpen = false;
+    };
+    QueryMetrics* metrics;
+    SlowQueryLog* slowQueryLog;
+    PendingCall pendingCall;
+
+    // True while reading the result sets of executeBatch; closeCursor only unbinds then, so the later result sets aren't thrown away
+    bool isBatchOpen;
+
     // Constructor takes a database connection handle and allocates a statement handle.
-    DBConn(SQLHDBC hDbc) : hDbc(hDbc), hStmt(NULL) {
+    DBConn(SQLHDBC hDbc, SQLTextMode textMode = SQLTextMode::Wide) : hStmt(NULL), hDbc(hDbc), activeStmt(NULL), fetchBlockSize(DEFAULT_FETCH_BLOCK_SIZE), rowsFetched(0), blockFetchStmt(NULL),
+        transactionDepth(0), isolationBeforeTransaction(SQL_TXN_READ_COMMITTED), textMode(textMode), metrics(nullptr), slowQueryLog(nullptr), isBatchOpen(false) {
         SQLAllocHandle(SQL_HANDLE_STMT, hDbc, &hStmt);
+        activeStmt = hStmt;
     }
 
     /*
@@ -23,8 +107,8 @@ public:
     NOTE: SQLExecDirectW expects a 'SQLWCHAR*' string for the SQL query,
         which uses Unicode (wide character) encoding. It's more common to use
         this over SQLExecDirectA as it supports more characters. As a result, we'd convert a
-        regular string into a 'wide string'. Then c_str() is able to turn that into a 
-        SQLWCHAR* for us.
+        regular string into a 'wide string', which toSQLWCHAR does into a buffer it reuses. 
+        In SQLTextMode::Narrow we skip the conversion and send the string as is (see SQLText.h).
 
     - Return false when SQL_ERROR so when something failed. We do this over !SQL_SUCCESS because this 
       allows us to return true, even if no rows were affected. So the query still ran, it just didn't 
@@ -37,50 +121,394 @@ public:
     'fixed' it by minimizing when I pass by reference because during my last 3 tests nothing bad happened. But I still don't know the solution to that mystery and it's actually frustrating.
     */
     bool executeSQL(const std::string& sqlQuery) {
-        // Convert string into wstring
-        std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-        std::wstring sqlQueryW = converter.from_bytes(sqlQuery);
-
         // Execute SQL Statement, and then return the success flag
-        SQLRETURN retcode = SQLExecDirectW(hStmt, (SQLWCHAR*)sqlQueryW.c_str(), SQL_NTS);
+        activeStmt = hStmt;
+        beginCall(sqlQuery, 0);
+        std::chrono::steady_clock::time_point start = callClock();
+        SQLRETURN retcode = textMode == SQLTextMode::Narrow
+            ? execDirectNarrow(hStmt, sqlQuery)
+            : SQLExecDirectW(hStmt, (SQLWCHAR*)toSQLWCHAR(sqlQuery), SQL_NTS);
+        addCallTime(start);
 
         if (SQL_ERROR == retcode) {
+            finishCall(true);
             logSQLError();
             return false;
         }
 
+        finishCallWithoutResults();
         return true;
     };
 
-    // Logs out SQL errors to console
+    /*
+    + Returns the cached statement handle for a parameterized query, preparing it the first time we see it.
+
+    NOTE: Returns NULL if the statement couldn't be prepared, such as when the SQL has a syntax error.
+    */
+    SQLHSTMT getPreparedStatement(const std::string& sqlQuery) {
+        std::map<std::string, SQLHSTMT>::iterator it = preparedStatements.find(sqlQuery);
+        if (it != preparedStatements.end()) {
+            return it->second;
+        }
+
+        SQLHSTMT hPrepared = NULL;
+        if (!SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, hDbc, &hPrepared))) {
+            return NULL;
+        }
+
+        SQLRETURN retcode = textMode == SQLTextMode::Narrow
+            ? prepareNarrow(hPrepared, sqlQuery)
+            : SQLPrepareW(hPrepared, (SQLWCHAR*)toSQLWCHAR(sqlQuery), SQL_NTS);
+        if (SQL_ERROR == retcode) {
+            activeStmt = hPrepared;
+            logSQLError();
+            SQLFreeHandle(SQL_HANDLE_STMT, hPrepared);
+            activeStmt = hStmt;
+            return NULL;
+        }
+
+        preparedStatements[sqlQuery] = hPrepared;
+        return hPrepared;
+    }
+
+    /*
+    + Executes a parameterized query, where each '?' in sqlQuery is replaced by the parameter at the same position in params.
+    
+    - The statement is prepared once and cached, so calling this again with the same sqlQuery only sends the 
+      parameter values to the server. Like executeSQL, it returns false only on SQL_ERROR, and on success 
+      the result set (if any) can be read with bindColumn, fetchRow, and closeCursor.
+
+    NOTE: Since the values never become part of the SQL text, strings don't need to be escaped with escapeSQL.
+    */
+    bool executePrepared(const std::string& sqlQuery, std::vector<SQLParam> params) {
+        SQLHSTMT hPrepared = getPreparedStatement(sqlQuery);
+        if (hPrepared == NULL) {
+            return false;
+        }
+        activeStmt = hPrepared;
+
+        // Start timing before boundParams is replaced, since the call before this one may still need its parameters logged
+        unsigned long long bytesBound = 0;
+        for (size_t i = 0; i < params.size(); i++) {
+            bytesBound += params[i].getDataLength();
+        }
+        beginCall(sqlQuery, bytesBound);
+        pendingCall.hasParams = true;
+
+        // Make sure a previous result set on this handle was closed, then bind the new parameter values
+        SQLFreeStmt(hPrepared, SQL_CLOSE);
+        boundParams = std::move(params);
+        for (size_t i = 0; i < boundParams.size(); i++) {
+            if (SQL_ERROR == boundParams[i].bind(hPrepared, static_cast<SQLUSMALLINT>(i + 1))) {
+                finishCall(true);
+                logSQLError();
+                return false;
+            }
+        }
+
+        std::chrono::steady_clock::time_point start = callClock();
+        SQLRETURN retcode = SQLExecute(hPrepared);
+        addCallTime(start);
+        if (SQL_ERROR == retcode) {
+            finishCall(true);
+            logSQLError();
+            return false;
+        }
+
+        finishCallWithoutResults();
+        return true;
+    }
+
+    /*
+    + Executes a parameterized INSERT that has an "OUTPUT INSERTED.<id column>" clause, and puts the generated ID of 
+      the new row into insertedID. 
+
+    - The ID comes back as the result of the INSERT itself, so there's no second query like "SELECT @@IDENTITY". 
+      @@IDENTITY could also give us the wrong ID, since it's the last identity made on the connection by anything,
+      including triggers.
+
+    NOTE: SQL Server won't allow OUTPUT without INTO on a table that has triggers. If we ever add triggers, the insert
+        has to OUTPUT INTO a table variable and select from that instead.
+    */
+    bool executeInsert(const std::string& sqlQuery, std::vector<SQLParam> params, int& insertedID) {
+        if (!executePrepared(sqlQuery, std::move(params))) {
+            return false;
+        }
+
+        std::vector<int> insertedIDs;
+        std::chrono::steady_clock::time_point start = callClock();
+        bool succeeded = readInsertedIDs(activeStmt, insertedIDs) && insertedIDs.size() == 1;
+        addCallTime(start);
+        finishCall(!succeeded);
+        if (!succeeded) {
+            logSQLError();
+            SQLFreeStmt(activeStmt, SQL_CLOSE);
+            return false;
+        }
+        insertedID = insertedIDs[0];
+        return true;
+    }
+
+    /*
+    + Executes several SELECTs sent as one batch (one round trip), such as "SELECT ... FROM a WHERE ...; SELECT ... FROM b ...;".
+      params has the values for every '?' in the whole batch, in order.
+
+    - The first result set can be read right away with the usual bindColumn/fetchRow/closeCursor (or a RowMapper), then
+      nextResultSet moves on to the next one. Call endBatch when done, which throws away anything that wasn't read.
+    - Use QueryBatch rather than calling this directly; it lets each manager add its own query and read its own results.
+    */
+    bool executeBatch(const std::string& sqlQuery, std::vector<SQLParam> params) {
+        bool succeeded = params.empty() ? executeSQL(sqlQuery) : executePrepared(sqlQuery, std::move(params));
+        isBatchOpen = succeeded;
+        return succeeded;
+    }
+
+    // Moves to the next result set of the batch, skipping over row counts; returns false if there are no more
+    bool nextResultSet() {
+        closeCursor();
+        while (true) {
+            std::chrono::steady_clock::time_point start = callClock();
+            SQLRETURN retcode = SQLMoreResults(activeStmt);
+            addCallTime(start);
+            if (retcode == SQL_NO_DATA) {
+                return false;
+            }
+            if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
+                logSQLError();
+                return false;
+            }
+            SQLSMALLINT columnCount = 0;
+            SQLNumResultCols(activeStmt, &columnCount);
+            if (columnCount > 0) {
+                return true;
+            }
+        }
+    }
+
+    // Closes the batch's cursor, along with any result sets that weren't read
+    void endBatch() {
+        isBatchOpen = false;
+        closeCursor();
+    }
+
+    /*
+    + Executes a parameterized INSERT, UPDATE, DELETE, or MERGE, and puts the number of rows it changed into rowCount.
+
+    NOTE: The count is for the first statement in sqlQuery, and is -1 if the driver doesn't know it.
+    */
+    bool executeUpdate(const std::string& sqlQuery, std::vector<SQLParam> params, int& rowCount) {
+        if (!executePrepared(sqlQuery, std::move(params))) {
+            return false;
+        }
+
+        SQLLEN count = -1;
+        SQLRETURN retcode = SQLRowCount(activeStmt, &count);
+        SQLFreeStmt(activeStmt, SQL_CLOSE);
+        if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
+            logSQLError();
+            return false;
+        }
+        rowCount = static_cast<int>(count);
+        return true;
+    }
+
+    /*
+    + Executes a parameterized query that returns a single number, like "SELECT COUNT(*) FROM ...", and puts it into value.
+
+    NOTE: A NULL result (like SUM over no rows) is returned as 0.
+    */
+    bool executeScalar(const std::string& sqlQuery, std::vector<SQLParam> params, int& value) {
+        if (!executePrepared(sqlQuery, std::move(params))) {
+            return false;
+        }
+
+        SQLINTEGER result = 0;
+        SQLLEN indicator = 0;
+        SQLRETURN retcode = fetchRow();
+        if (retcode == SQL_SUCCESS || retcode == SQL_SUCCESS_WITH_INFO) {
+            retcode = SQLGetData(activeStmt, 1, SQL_C_SLONG, &result, sizeof(result), &indicator);
+        }
+        closeCursor();
+        if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
+            return false;
+        }
+
+        value = indicator == SQL_NULL_DATA ? 0 : static_cast<int>(result);
+        return true;
+    }
+
+    /*
+    - Reads the first column of every row in every result set left on hStmt into insertedIDs. Results without columns
+      (like row counts) are skipped.
+    */
+    bool readInsertedIDs(SQLHSTMT hStmt, std::vector<int>& insertedIDs) {
+        SQLINTEGER id = 0;
+        SQLRETURN retcode = SQL_SUCCESS;
+        do {
+            SQLSMALLINT columnCount = 0;
+            SQLNumResultCols(hStmt, &columnCount);
+            if (columnCount > 0) {
+                SQLBindCol(hStmt, 1, SQL_C_SLONG, &id, sizeof(id), NULL);
+                while (SQL_SUCCEEDED(retcode = SQLFetch(hStmt))) {
+                    insertedIDs.push_back(static_cast<int>(id));
+                }
+                SQLFreeStmt(hStmt, SQL_UNBIND);
+                if (retcode != SQL_NO_DATA) {
+                    return false;
+                }
+            }
+            retcode = SQLMoreResults(hStmt);
+        } while (SQL_SUCCEEDED(retcode));
+
+        return retcode == SQL_NO_DATA;
+    }
+
+    /*
+    + Executes a parameterized query once for every row in rows, where row[i] is the value for the i-th '?'. This is 
+      meant for inserting many rows at once, such as "INSERT INTO t (a, b) VALUES (?, ?)" with one row per item.
+
+    - The statement is prepared once (and cached like executePrepared), and the rows are sent as parameter arrays
+      (SQL_ATTR_PARAMSET_SIZE), so the server gets one statement with N sets of values instead of a giant
+      "VALUES (...),(...)" string. That string had to be parsed again for every different row count, and SQL Server 
+      won't take more than 1000 rows in a VALUES list anyways.
+    - Every row needs the same number of values, and each placeholder has to be the same type in every row.
+    - Rows are sent in chunks of MAX_BULK_ROWS. Returns false if any chunk failed, or any row in it couldn't be executed.
+
+    NOTE: Each row is executed on its own by the server, so if a row fails, rows before it may have been inserted 
+        already. Wrap the call in a transaction if it has to be all or nothing.
+    */
+    bool executeBulk(const std::string& sqlQuery, const std::vector<std::vector<SQLParam>>& rows) {
+        return executeBulk(sqlQuery, rows, nullptr);
+    }
+
+    /*
+    - Same as executeBulk, but for an INSERT with an "OUTPUT INSERTED.<id column>" clause. The generated ID of each
+      row is put into insertedIDs, in the same order as rows, without another query per row.
+    */
+    bool executeBulkInsert(const std::string& sqlQuery, const std::vector<std::vector<SQLParam>>& rows, std::vector<int>& insertedIDs) {
+        insertedIDs.clear();
+        insertedIDs.reserve(rows.size());
+        if (!executeBulk(sqlQuery, rows, &insertedIDs)) {
+            return false;
+        }
+        return insertedIDs.size() == rows.size();
+    }
+
+    // Does the work for executeBulk and executeBulkInsert; insertedIDs is nullptr when the statement doesn't return IDs
+    bool executeBulk(const std::string& sqlQuery, const std::vector<std::vector<SQLParam>>& rows, std::vector<int>* insertedIDs) {
+        if (rows.empty()) {
+            return true;
+        }
+        const size_t paramCount = rows[0].size();
+        for (size_t i = 1; i < rows.size(); i++) {
+            if (rows[i].size() != paramCount) {
+                throw std::runtime_error("Every row of a bulk execute needs the same number of parameters!");
+            }
+            for (size_t col = 0; col < paramCount; col++) {
+                if (rows[i][col].getType() != rows[0][col].getType()) {
+                    throw std::runtime_error("Bulk parameter " + std::to_string(col + 1) + " has a different type in row " + std::to_string(i + 1) + "!");
+                }
+            }
+        }
+
+        SQLHSTMT hPrepared = getPreparedStatement(sqlQuery);
+        if (hPrepared == NULL) {
+            return false;
+        }
+        activeStmt = hPrepared;
+        SQLFreeStmt(hPrepared, SQL_CLOSE);
+
+        // The whole bulk execute is timed as one call
+        unsigned long long bytesBound = 0;
+        if (metrics != nullptr || slowQueryLog != nullptr) {
+            for (size_t i = 0; i < rows.size(); i++) {
+                for (size_t col = 0; col < paramCount; col++) {
+                    bytesBound += rows[i][col].getDataLength();
+                }
+            }
+        }
+        beginCall(sqlQuery, bytesBound);
+        pendingCall.bulkRows = rows.size();
+        std::chrono::steady_clock::time_point start = callClock();
+
+        bool succeeded = true;
+        for (size_t begin = 0; begin < rows.size() && succeeded; begin += MAX_BULK_ROWS) {
+            size_t end = begin + MAX_BULK_ROWS < rows.size() ? begin + MAX_BULK_ROWS : rows.size();
+            succeeded = executeBulkChunk(hPrepared, rows, begin, end, insertedIDs);
+        }
+        addCallTime(start);
+        finishCall(!succeeded);
+
+        // Put the handle back to executing one set of parameters, since executePrepared shares it
+        SQLFreeStmt(hPrepared, SQL_RESET_PARAMS);
+        SQLSetStmtAttr(hPrepared, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+        SQLSetStmtAttr(hPrepared, SQL_ATTR_PARAM_STATUS_PTR, NULL, 0);
+        SQLSetStmtAttr(hPrepared, SQL_ATTR_PARAMS_PROCESSED_PTR, NULL, 0);
+        return succeeded;
+    }
+
+    // SQL Server's error number for a statement that was picked to be rolled back to break a deadlock
+    static const int DEADLOCK_VICTIM_ERROR = 1205;
+
+    /*
+    - The number of the last SQL error logged on this thread since it leased its connection (ConnectionPool::acquire
+      sets it back to 0), or 0 if nothing failed. Callers read it after a call fails to decide what to do, like
+      retrying a deadlock victim.
+    - A deadlock sticks until the next lease, or until the caller clears it (StorageBackend::clearLastError). The
+      server has already rolled the transaction back by then, so the savepoint rollbacks run while the TransactionScopes
+      unwind fail too (3903), but 1205 is what the caller needs.
+    - A re-entrant lease doesn't clear it, so code that retries inside a held connection has to clear it before each try.
+    NOTE: It's kept per thread rather than per connection, since by the time the exception gets to someone who can
+        retry, the connection is back in the pool (and maybe leased to another thread).
+    */
+    static int& lastErrorNumber() {
+        static thread_local int errorNumber = 0;
+        return errorNumber;
+    }
+
+    /*
+    - Logs out SQL errors to console
+    NOTE: The messages are read with the ANSI version of SQLGetDiagRec (see getDiagRecNarrow), since SQLWCHAR is
+        only wchar_t on Windows; with unixODBC it's 16 bits, which std::wstring can't hold.
+    */
     void logSQLError() {
+        int errorNumber = 0;
         SQLSMALLINT recordNumber = 1;
-        SQLWCHAR sqlState[6];
+        SQLCHAR sqlState[6];
         SQLINTEGER nativeError;
-        SQLWCHAR* messageText = nullptr; // Pointer to error message buffer
+        SQLCHAR* messageText = nullptr; // Pointer to error message buffer
         SQLSMALLINT textLength;
         SQLRETURN diagRecRet;
 
         // Loop to retrieve and process error messages
-        while (SQL_SUCCESS == (diagRecRet = SQLGetDiagRec(SQL_HANDLE_STMT, hStmt, recordNumber++, sqlState, &nativeError, NULL, 0, &textLength))) {
+        while (SQL_SUCCESS == (diagRecRet = getDiagRecNarrow(SQL_HANDLE_STMT, activeStmt, recordNumber++, sqlState, &nativeError, NULL, 0, &textLength))) {
             // Allocate memory for the error message buffer
-            messageText = new SQLWCHAR[textLength + 1];
+            messageText = new SQLCHAR[textLength + 1];
 
             // Retrieve the error message
-            SQLGetDiagRec(SQL_HANDLE_STMT, hStmt, recordNumber - 1, sqlState, &nativeError, messageText, textLength + 1, &textLength);
+            getDiagRecNarrow(SQL_HANDLE_STMT, activeStmt, recordNumber - 1, sqlState, &nativeError, messageText, textLength + 1, &textLength);
+
+            // Keep the first error's number, unless a later one is the deadlock, which is the one callers act on
+            if (errorNumber == 0 || nativeError == DEADLOCK_VICTIM_ERROR) {
+                errorNumber = nativeError;
+            }
 
             // Output the error message
-            std::wcerr << "SQL Error " << nativeError << ": " << std::wstring(messageText) << std::endl;
+            std::cerr << "SQL Error " << nativeError << ": " << reinterpret_cast<const char*>(messageText) << std::endl;
 
             // Free the memory for the error message buffer
             delete[] messageText;
             messageText = nullptr;
         }
 
+        if (lastErrorNumber() != DEADLOCK_VICTIM_ERROR) {
+            lastErrorNumber() = errorNumber;
+        }
+
         // Check if an error occurred during the last iteration
         if (diagRecRet != SQL_NO_DATA) {
             // Error occurred while fetching error message
-            std::wcerr << "Error occurred while fetching error message" << std::endl;
+            std::cerr << "Error occurred while fetching error message" << std::endl;
             // Free the memory for the error message buffer if not already done
             if (messageText != nullptr) {
                 delete[] messageText;
@@ -88,31 +516,25 @@ public:
         }
     }
   
-    // Gets the primary key value of the last inserted row
-    int getLastInsertedID() {
-        // Execute the SQL statement to retrieve the last inserted ID
-        if (!executeSQL("SELECT @@IDENTITY AS LastID")) {
-            throw std::runtime_error("Failed to retrieve last inserted ID");
-        }
+    /*
+    - Checks if the connection to the server still works. The ConnectionPool uses this before it reuses a 
+      connection that's been sitting idle.
 
-        // Bind the result set column to a C variable
-        SQLINTEGER lastID = 0;
-        SQLRETURN retcode = SQLBindCol(hStmt, 1, SQL_C_SLONG, &lastID, sizeof(SQLINTEGER), NULL);
-        if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
-            // Handle error
-            throw std::runtime_error("Failed to bind result set column");
+    NOTE: SQL_ATTR_CONNECTION_DEAD only tells us what the driver already knows, so we also run a query
+        that doesn't touch any tables to see if the server still answers.
+    */
+    bool isAlive() {
+        SQLUINTEGER isDead = SQL_CD_FALSE;
+        SQLRETURN retcode = SQLGetConnectAttr(hDbc, SQL_ATTR_CONNECTION_DEAD, &isDead, SQL_IS_UINTEGER, NULL);
+        if (SQL_SUCCEEDED(retcode) && isDead == SQL_CD_TRUE) {
+            return false;
         }
 
-        // Fetch the result
-        retcode = SQLFetch(hStmt);
-        if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
-            // Handle error
-            throw std::runtime_error("Failed to fetch result set");
+        if (!executeSQL("SELECT 1;")) {
+            return false;
         }
-
-        // Clean up and return the ID we got as an integer
-        SQLFreeStmt(hStmt, SQL_CLOSE);
-        return static_cast<int>(lastID);
+        closeCursor();
+        return true;
     }
 
     // Attempts to create a new database
@@ -240,17 +662,189 @@ public:
        we know their maximum length and they won't be null, NULL is used as the default parameter.
     */
     SQLRETURN bindColumn(int colNum, SQLSMALLINT targetType, SQLPOINTER targetValue, SQLLEN bufferLength, SQLLEN* indicator = NULL) {
-        return SQLBindCol(hStmt, colNum, targetType, targetValue, bufferLength, indicator);
+        return SQLBindCol(activeStmt, colNum, targetType, targetValue, bufferLength, indicator);
     }
 
-    // Fetches data for a row
+    // Fetches data for a row, or for a block of rows after beginBlockFetch
     SQLRETURN fetchRow() {
-        return SQLFetch(hStmt);
+        if (!pendingCall.isOpen) {
+            return SQLFetch(activeStmt);
+        }
+
+        std::chrono::steady_clock::time_point start = callClock();
+        SQLRETURN retcode = SQLFetch(activeStmt);
+        addCallTime(start);
+        if (retcode == SQL_SUCCESS || retcode == SQL_SUCCESS_WITH_INFO) {
+            pendingCall.rowsFetched += blockFetchStmt == activeStmt ? rowsFetched : 1;
+        }
+        return retcode;
+    }
+
+    /*
+    - Reads a string column of the row we just fetched (with fetchRow) into value, without binding a buffer for it first.
+      A NULL value is read as an empty string. Returns false if the data couldn't be read.
+
+    NOTE: The value is read in chunks with SQLGetData, so a big VARCHAR column only costs as many bytes as the value 
+        actually has, rather than a buffer of its maximum length. The column can't be bound, and it should come after 
+        the bound columns in the select list, since drivers (like SQL Server's) only allow SQLGetData on those.
+    */
+    bool getData(int colNum, std::string& value) {
+        value.clear();
+        char buffer[512];
+        while (true) {
+            SQLLEN indicator = 0;
+            SQLRETURN retcode = SQLGetData(activeStmt, colNum, SQL_C_CHAR, buffer, sizeof(buffer), &indicator);
+            if (retcode == SQL_NO_DATA) {
+                return true; // Everything was read by the previous call
+            }
+            if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
+                logSQLError();
+                return false;
+            }
+            if (indicator == SQL_NULL_DATA) {
+                return true;
+            }
+
+            // A chunk that didn't fit fills the buffer (minus the null terminator); the last one is indicator long
+            size_t chunkLength = sizeof(buffer) - 1;
+            if (indicator != SQL_NO_TOTAL && static_cast<size_t>(indicator) < chunkLength) {
+                chunkLength = static_cast<size_t>(indicator);
+            }
+            value.append(buffer, chunkLength);
+
+            // SQL_SUCCESS_WITH_INFO means the value was cut off, so there's more to read
+            if (retcode == SQL_SUCCESS) {
+                return true;
+            }
+        }
+    }
+
+    // Sets how many rows a block fetch gets at once; values below 1 are treated as 1
+    void setFetchBlockSize(SQLULEN blockSize) {
+        fetchBlockSize = blockSize < 1 ? 1 : blockSize;
+    }
+
+    SQLULEN getFetchBlockSize() const {
+        return fetchBlockSize;
+    }
+
+    /*
+    + Sets up the current result set to be fetched in blocks of rows rather than one row at a time.
+
+    - Returns the number of rows in a block. Each bindColumn call after this has to bind an array with room for that many
+      values (column-wise binding), where bufferLength is the size of one value, so a VARCHAR(50) column is bound to an
+      array of blockSize * 51 chars with bufferLength 51.
+    - Each fetchRow then fills in up to blockSize rows, and getRowsFetched says how many. Rows the driver couldn't
+      fetch are flagged by isRowError.
+
+    NOTE: Fetching one row at a time means one driver call (and with SQL Server often one trip to the network buffer) per 
+        row, which is what dominated getAllProducts on big tables. closeCursor switches the handle back to single rows,
+        since the other fetch code (isValidRow, dbExists, etc.) binds single variables.
+    */
+    SQLULEN beginBlockFetch() {
+        rowsFetched = 0;
+        rowStatus.assign(fetchBlockSize, SQL_ROW_NOROW);
+
+        SQLSetStmtAttr(activeStmt, SQL_ATTR_ROW_BIND_TYPE, (SQLPOINTER)SQL_BIND_BY_COLUMN, 0);
+        SQLSetStmtAttr(activeStmt, SQL_ATTR_ROWS_FETCHED_PTR, &rowsFetched, 0);
+        SQLSetStmtAttr(activeStmt, SQL_ATTR_ROW_STATUS_PTR, rowStatus.data(), 0);
+        if (SQL_ERROR == SQLSetStmtAttr(activeStmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)fetchBlockSize, 0)) {
+            // The driver doesn't do block cursors, so fall back to fetching a row at a time
+            SQLSetStmtAttr(activeStmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+            blockFetchStmt = activeStmt;
+            return 1;
+        }
+        blockFetchStmt = activeStmt;
+        return fetchBlockSize;
     }
 
-    // Closes SQL Cursor and releases resources; We'll do these after every fetchRow()
+    // Number of rows the last block fetch returned
+    SQLULEN getRowsFetched() const {
+        return rowsFetched;
+    }
+
+    // True if the row at index row (starting at 0) of the last block couldn't be fetched
+    bool isRowError(SQLULEN row) const {
+        return rowStatus[row] == SQL_ROW_ERROR;
+    }
+
+    /*
+    - Closes SQL Cursor and releases resources; We'll do these after every fetchRow()
+
+    NOTE: We also unbind the columns. The buffers we bind are local variables in the managers' fetch functions, 
+        and a binding outlives a closed cursor. So without unbinding, the next fetchRow on the same handle 
+        (like the one in isExistingCartItem) would write into buffers that no longer exist, which is the memory 
+        access violation mentioned in executeSQL. This matters even more now that prepared handles get reused.
+    */
     SQLRETURN closeCursor() {
-        return SQLFreeStmt(hStmt, SQL_CLOSE);
+        SQLRETURN retcode = isBatchOpen ? SQL_SUCCESS : SQLFreeStmt(activeStmt, SQL_CLOSE);
+        SQLFreeStmt(activeStmt, SQL_UNBIND);
+        if (!isBatchOpen) {
+            finishCall(false);
+        }
+
+        // Put a block fetching handle back to fetching one row at a time
+        if (blockFetchStmt != NULL) {
+            SQLSetStmtAttr(blockFetchStmt, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+            SQLSetStmtAttr(blockFetchStmt, SQL_ATTR_ROWS_FETCHED_PTR, NULL, 0);
+            SQLSetStmtAttr(blockFetchStmt, SQL_ATTR_ROW_STATUS_PTR, NULL, 0);
+            blockFetchStmt = NULL;
+        }
+        return retcode;
+    }
+
+    /*
+    + Starts a transaction: turns off autocommit, so nothing we run is committed until commitTransaction.
+
+    - isolationLevel is one of ODBC's SQL_TXN_* levels, and only lasts until the transaction ends.
+    - Returns false if we're already in a transaction (use saveTransaction for a nested one), or the driver refused.
+
+    NOTE: In autocommit mode every statement is its own transaction, so every INSERT/UPDATE/DELETE waits on a
+        log flush, and a chain of them that fails halfway leaves the first ones done. Grouping them into one
+        transaction means one flush at commit, and all or nothing. Use TransactionScope rather than calling this directly.
+    */
+    bool beginTransaction(SQLUINTEGER isolationLevel = SQL_TXN_READ_COMMITTED) {
+        if (transactionDepth > 0) {
+            return false;
+        }
+
+        // The isolation level can only be changed while no transaction is open, so set it before turning off autocommit
+        isolationBeforeTransaction = SQL_TXN_READ_COMMITTED;
+        SQLGetConnectAttr(hDbc, SQL_ATTR_TXN_ISOLATION, &isolationBeforeTransaction, 0, NULL);
+        if (isolationLevel != isolationBeforeTransaction &&
+            !SQL_SUCCEEDED(SQLSetConnectAttr(hDbc, SQL_ATTR_TXN_ISOLATION, (SQLPOINTER)(SQLULEN)isolationLevel, 0))) {
+            return false;
+        }
+        if (!SQL_SUCCEEDED(SQLSetConnectAttr(hDbc, SQL_ATTR_AUTOCOMMIT, (SQLPOINTER)SQL_AUTOCOMMIT_OFF, 0))) {
+            SQLSetConnectAttr(hDbc, SQL_ATTR_TXN_ISOLATION, (SQLPOINTER)(SQLULEN)isolationBeforeTransaction, 0);
+            return false;
+        }
+        transactionDepth = 1;
+        return true;
+    }
+
+    // Commits the transaction and goes back to autocommit mode
+    bool commitTransaction() {
+        return endTransaction(SQL_COMMIT);
+    }
+
+    // Undoes everything since beginTransaction and goes back to autocommit mode
+    bool rollbackTransaction() {
+        return endTransaction(SQL_ROLLBACK);
+    }
+
+    bool inTransaction() const {
+        return transactionDepth > 0;
+    }
+
+    // Marks a savepoint in the current transaction, which rollbackToSavepoint can undo back to
+    bool saveTransaction(const std::string& savepointName) {
+        return inTransaction() && executeSQL("SAVE TRANSACTION " + savepointName + ";");
+    }
+
+    // Undoes everything since the savepoint; the transaction itself stays open
+    bool rollbackToSavepoint(const std::string& savepointName) {
+        return inTransaction() && executeSQL("ROLLBACK TRANSACTION " + savepointName + ";");
     }
 
     /*
@@ -275,7 +869,11 @@ public:
         // Get the current time
         time_t now = time(nullptr);
         struct tm localTime;
+#ifdef _WIN32
         localtime_s(&localTime, &now);
+#else
+        localtime_r(&now, &localTime);
+#endif
 
         // Format the time as a string
         char buffer[20];
@@ -284,8 +882,153 @@ public:
         return std::string(buffer);
     }
 
-    // Destructor frees the statement handle.
+    // Binds rows[begin] to rows[end - 1] as parameter arrays and executes them; used by executeBulk
+    bool executeBulkChunk(SQLHSTMT hPrepared, const std::vector<std::vector<SQLParam>>& rows, size_t begin, size_t end, std::vector<int>* insertedIDs) {
+        const SQLULEN rowCount = static_cast<SQLULEN>(end - begin);
+        std::vector<std::unique_ptr<SQLParamColumn>> columns;
+        std::vector<SQLUSMALLINT> paramStatus(rowCount, SQL_PARAM_UNUSED);
+        SQLULEN paramsProcessed = 0;
+
+        SQLSetStmtAttr(hPrepared, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0);
+        SQLSetStmtAttr(hPrepared, SQL_ATTR_PARAM_STATUS_PTR, paramStatus.data(), 0);
+        SQLSetStmtAttr(hPrepared, SQL_ATTR_PARAMS_PROCESSED_PTR, &paramsProcessed, 0);
+        if (SQL_ERROR == SQLSetStmtAttr(hPrepared, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)rowCount, 0)) {
+            logSQLError();
+            return false;
+        }
+
+        for (size_t col = 0; col < rows[begin].size(); col++) {
+            columns.push_back(std::unique_ptr<SQLParamColumn>(new SQLParamColumn(rows, col, begin, end)));
+            if (SQL_ERROR == columns.back()->bind(hPrepared, static_cast<SQLUSMALLINT>(col + 1))) {
+                logSQLError();
+                return false;
+            }
+        }
+
+        SQLRETURN retcode = SQLExecute(hPrepared);
+        if (SQL_ERROR == retcode) {
+            logSQLError();
+            return false;
+        }
+
+        // Every row gets its own result set with its generated ID
+        if (insertedIDs != nullptr && !readInsertedIDs(hPrepared, *insertedIDs)) {
+            logSQLError();
+            SQLFreeStmt(hPrepared, SQL_CLOSE);
+            return false;
+        }
+
+        // The statement can succeed as a whole (with info) while some of its rows failed
+        for (SQLULEN i = 0; i < paramsProcessed && i < rowCount; i++) {
+            if (paramStatus[i] == SQL_PARAM_ERROR) {
+                logSQLError();
+                SQLFreeStmt(hPrepared, SQL_CLOSE);
+                return false;
+            }
+        }
+        SQLFreeStmt(hPrepared, SQL_CLOSE);
+        return true;
+    }
+
+    // Starts recording into queryMetrics (or stops recording, with nullptr); the statement being timed is recorded first
+    void setQueryMetrics(QueryMetrics* queryMetrics) {
+        if (queryMetrics != metrics) {
+            finishCall(false);
+            metrics = queryMetrics;
+        }
+    }
+
+    // Starts logging into log (or stops, with nullptr); the statement being timed is recorded first
+    void setSlowQueryLog(SlowQueryLog* log) {
+        if (log != slowQueryLog) {
+            finishCall(false);
+            slowQueryLog = log;
+        }
+    }
+
+    // Starts timing a statement, after recording the previous one if it's still open; does nothing when metrics and the log are off
+    void beginCall(const std::string& sqlQuery, unsigned long long bytesBound) {
+        finishCall(false);
+        if (metrics == nullptr && slowQueryLog == nullptr) {
+            return;
+        }
+        pendingCall.sqlQuery = sqlQuery;
+        pendingCall.caller = QueryCaller::capture();
+        pendingCall.micros = 0;
+        pendingCall.rowsFetched = 0;
+        pendingCall.bytesBound = bytesBound;
+        pendingCall.bulkRows = 0;
+        pendingCall.hasParams = false;
+        pendingCall.isOpen = true;
+    }
+
+    // The time a driver call starts, for addCallTime; we don't read the clock when nothing is being timed
+    std::chrono::steady_clock::time_point callClock() const {
+        return pendingCall.isOpen ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+    }
+
+    // Adds the time since start (from callClock) to the statement being timed
+    void addCallTime(std::chrono::steady_clock::time_point start) {
+        if (pendingCall.isOpen) {
+            pendingCall.micros += static_cast<unsigned long long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    // Records the statement being timed, if there is one
+    void finishCall(bool failed) {
+        if (!pendingCall.isOpen) {
+            return;
+        }
+        pendingCall.isOpen = false;
+        if (metrics != nullptr) {
+            metrics->record(QueryMetrics::fingerprint(pendingCall.sqlQuery), pendingCall.micros, pendingCall.rowsFetched, pendingCall.bytesBound, failed);
+        }
+        if (slowQueryLog != nullptr) {
+            slowQueryLog->consider(pendingCall.sqlQuery, pendingCall.hasParams ? &boundParams : nullptr, pendingCall.bulkRows,
+                pendingCall.caller, pendingCall.micros, pendingCall.rowsFetched, failed);
+        }
+    }
+
+    // Records the statement being timed right away if it has no result set to fetch (like an UPDATE)
+    void finishCallWithoutResults() {
+        if (!pendingCall.isOpen) {
+            return;
+        }
+        SQLSMALLINT columnCount = 0;
+        SQLNumResultCols(activeStmt, &columnCount);
+        if (columnCount == 0) {
+            finishCall(false);
+        }
+    }
+
+    /*
+    - Commits or rolls back (completionType is SQL_COMMIT or SQL_ROLLBACK), then turns autocommit back on and
+      restores the isolation level. We always go back to autocommit, even if the commit failed, since the
+      server has ended (or will end) the transaction either way.
+    */
+    bool endTransaction(SQLSMALLINT completionType) {
+        if (transactionDepth == 0) {
+            return false;
+        }
+
+        // Cursors don't survive the end of a transaction on SQL Server, so close the one we're reading
+        closeCursor();
+        SQLRETURN retcode = SQLEndTran(SQL_HANDLE_DBC, hDbc, completionType);
+        if (!SQL_SUCCEEDED(retcode) && completionType == SQL_COMMIT) {
+            SQLEndTran(SQL_HANDLE_DBC, hDbc, SQL_ROLLBACK);
+        }
+        SQLSetConnectAttr(hDbc, SQL_ATTR_AUTOCOMMIT, (SQLPOINTER)SQL_AUTOCOMMIT_ON, 0);
+        SQLSetConnectAttr(hDbc, SQL_ATTR_TXN_ISOLATION, (SQLPOINTER)(SQLULEN)isolationBeforeTransaction, 0);
+        transactionDepth = 0;
+        return SQL_SUCCEEDED(retcode);
+    }
+
+    // Destructor frees the statement handle, and all of the prepared statement handles.
     ~DBConn() {
+        for (std::map<std::string, SQLHSTMT>::iterator it = preparedStatements.begin(); it != preparedStatements.end(); ++it) {
+            SQLFreeHandle(SQL_HANDLE_STMT, it->second);
+        }
         if (hStmt) SQLFreeHandle(SQL_HANDLE_STMT, hStmt);
     }
 };
@@ -0,0 +1,465 @@
+#ifndef DataGenerator_H
+#define DataGenerator_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <ostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <cmath>
+#include <cctype>
+#include <algorithm>
+#include <stdexcept>
+
+#include "ConnectionPool.h"
+#include "TransactionScope.h"
+#include "SQLParam.h"
+#include "SeededRandom.h"
+
+/*
++ DataGenerator: Fills the (empty) tables made by the managers' initTable with a made-up store, at whatever size we
+    want to benchmark at, without going through the managers one row at a time.
+
+        DataGenerator::Config config;
+        config.customers = 1000000;
+        config.suppliers = 5000;
+        config.products = 200000;
+        config.transactions = 20000000;
+        config.orderItems = 80000000;
+        DataGenerator generator(connectionPool, config);
+        generator.run(std::cout);
+
+- The data is skewed like a real store's. How often a product sells follows a Zipf distribution (productSkew), so a
+  few products are in most orders, and the same goes for which customers buy (customerSkew) and which suppliers have
+  the most products (supplierSkew). Order dates run from the start of firstYear through the end of the last year,
+  with more orders around the holidays and on weekends, and more every year (yearlyGrowth). Transaction ids go up
+  with the order date, like they would have if the orders really came in over those years.
+- orderItems is about how many order items there are in total; each transaction gets at least one, and
+  orderItems / transactions on average. Each transaction's total is what its order items cost.
+- The same seed gives the same data, whatever the number of threads: every table is cut into chunks of chunkRows
+  rows, and each chunk's rows come from their own random stream (see SeededRandom). The rows keep the ids we give
+  them (SET IDENTITY_INSERT), so the ids don't depend on which chunk got inserted first either.
+- Rows are sent as parameter arrays (see DBConn::executeBulk) by threads workers, each on its own connection, and each
+  chunk is committed as one transaction.
+- Cart items aren't generated; carts start empty.
+
+NOTE: The pool needs at least threads connections, or the workers will wait on each other.
+NOTE: The tables have to be empty (like right after initTable), or the ids we give the rows will collide. The
+    identity columns carry on after the largest id we inserted, so the managers can add rows afterwards.
+*/
+class DataGenerator {
+public:
+    struct Config {
+        uint64_t seed = 1;
+        int customers = 10000;
+        int suppliers = 100;
+        int products = 2000;
+        int transactions = 50000;
+        long long orderItems = 200000;
+        double productSkew = 1.0;  // Zipf exponents; 0 is uniform, and the bigger it is the more the top few dominate
+        double customerSkew = 0.7;
+        double supplierSkew = 0.8;
+        int firstYear = 2022;
+        int years = 3;
+        double yearlyGrowth = 0.15;
+        size_t threads = 4;
+        int chunkRows = 10000;
+    };
+
+    // Table names; the defaults are the ones main.cpp uses
+    struct Tables {
+        std::string customers = "Customers";
+        std::string suppliers = "Suppliers";
+        std::string supplierNames = "Supplier_Names";
+        std::string products = "Products";
+        std::string transactions = "Transactions";
+        std::string orderItems = "Order_Items";
+    };
+
+    DataGenerator(ConnectionPool& connectionPool, Config config) : DataGenerator(connectionPool, config, Tables()) {}
+
+    DataGenerator(ConnectionPool& connectionPool, Config config, Tables tables)
+        : connectionPool(connectionPool), config(config), tables(tables), averageItems(1.0) {}
+
+    DataGenerator(const DataGenerator&) = delete;
+    DataGenerator& operator=(const DataGenerator&) = delete;
+
+    // Generates and loads every table, printing how far along it is to progress; returns how many order items were made
+    long long run(std::ostream& progress) {
+        validateConfig();
+        prepare();
+
+        runStage(progress, "suppliers", config.suppliers, [this](size_t chunk, int begin, int end) { loadSuppliers(chunk, begin, end); });
+        runStage(progress, "customers", config.customers, [this](size_t chunk, int begin, int end) { loadCustomers(chunk, begin, end); });
+        runStage(progress, "products", config.products, [this](size_t chunk, int begin, int end) { loadProducts(chunk, begin, end); });
+        long long orderItems = countOrderItems();
+        progress << "Making " << orderItems << " order items for " << config.transactions << " transactions" << std::endl;
+        runStage(progress, "transactions", config.transactions, [this](size_t chunk, int begin, int end) { loadTransactions(chunk, begin, end); });
+        return orderItems;
+    }
+
+private:
+    // Ids for the random streams, so each table's data comes from its own
+    enum class Stream : uint64_t { Setup = 1, Suppliers, Customers, Products, Transactions, ItemCounts };
+
+    static const int MAX_ITEMS_PER_ORDER = 100;
+
+    ConnectionPool& connectionPool;
+    Config config;
+    Tables tables;
+
+    // Ids in order of popularity; the Zipf distributions pick a rank, and these turn it into an id
+    std::vector<int> suppliersByRank;
+    std::vector<int> customersByRank;
+    std::vector<int> productsByRank;
+    ZipfDistribution supplierPopularity;
+    ZipfDistribution customerPopularity;
+    ZipfDistribution productPopularity;
+
+    std::vector<std::string> orderDays; // Every day orders can be on, as yyyy-mm-dd
+    WeightedDistribution orderDayVolume; // How many of the orders are on each day in orderDays
+    std::vector<double> prices; // Price of each product (product_id - 1), filled in as the products are made
+    std::vector<int> firstOrderItemIDs; // order_item_id of the first order item in each chunk of transactions
+    double averageItems;
+
+    // Lets rows be inserted into a table with the ids we give them, on dbConn, for as long as it's alive
+    class IdentityInsert {
+    public:
+        IdentityInsert(DBConn& dbConn, const std::string& tableName) : dbConn(dbConn), tableName(tableName) {
+            if (!dbConn.executeSQL("SET IDENTITY_INSERT " + tableName + " ON;")) {
+                throw std::runtime_error("Failed to turn on IDENTITY_INSERT for '" + tableName + "'!");
+            }
+        }
+
+        ~IdentityInsert() {
+            dbConn.executeSQL("SET IDENTITY_INSERT " + tableName + " OFF;");
+        }
+
+        IdentityInsert(const IdentityInsert&) = delete;
+        IdentityInsert& operator=(const IdentityInsert&) = delete;
+
+    private:
+        DBConn& dbConn;
+        std::string tableName;
+    };
+
+    void validateConfig() const {
+        if (config.customers < 1 || config.suppliers < 1 || config.products < 1 || config.transactions < 1) {
+            throw std::runtime_error("The data generator needs at least one customer, supplier, product and transaction!");
+        }
+        if (config.orderItems < config.transactions) {
+            throw std::runtime_error("The data generator needs at least as many order items as transactions!");
+        }
+        if (config.years < 1 || config.firstYear < 1970) {
+            throw std::runtime_error("The data generator needs at least one year of orders, starting in 1970 or later!");
+        }
+        if (config.threads < 1 || config.chunkRows < 1) {
+            throw std::runtime_error("The data generator needs at least one thread, and at least one row per chunk!");
+        }
+    }
+
+    // Everything the chunks share, made before any of them run
+    void prepare() {
+        SeededRandom random(SeededRandom::mix(config.seed, static_cast<uint64_t>(Stream::Setup)));
+        suppliersByRank = shuffledIDs(random, config.suppliers);
+        customersByRank = shuffledIDs(random, config.customers);
+        productsByRank = shuffledIDs(random, config.products);
+        supplierPopularity = ZipfDistribution(static_cast<size_t>(config.suppliers), config.supplierSkew);
+        customerPopularity = ZipfDistribution(static_cast<size_t>(config.customers), config.customerSkew);
+        productPopularity = ZipfDistribution(static_cast<size_t>(config.products), config.productSkew);
+        prices.assign(static_cast<size_t>(config.products), 0.0);
+        averageItems = static_cast<double>(config.orderItems) / config.transactions;
+
+        // Weigh each day by its month (holidays up, late winter down) and weekday, and grow every year
+        static const double MONTH_WEIGHTS[12] = { 0.80, 0.75, 0.85, 0.90, 0.95, 0.95, 1.00, 1.05, 0.90, 1.00, 1.35, 1.70 };
+        std::vector<double> dayWeights;
+        orderDays.clear();
+        for (int year = config.firstYear; year < config.firstYear + config.years; year++) {
+            for (int month = 1; month <= 12; month++) {
+                for (int day = 1; day <= daysInMonth(year, month); day++) {
+                    int weekday = static_cast<int>((daysFromCivil(year, month, day) % 7 + 11) % 7); // 0 is Sunday
+                    double growth = std::pow(1.0 + config.yearlyGrowth, (year - config.firstYear) + (month - 1) / 12.0);
+                    dayWeights.push_back(MONTH_WEIGHTS[month - 1] * (weekday == 0 || weekday == 6 ? 1.3 : 1.0) * growth);
+                    orderDays.push_back(formatDate(year, month, day));
+                }
+            }
+        }
+        orderDayVolume = WeightedDistribution(dayWeights);
+    }
+
+    /*
+    - Runs load(chunk, begin, end) for every chunk of rows rows, on up to config.threads threads, each chunk in its
+      own transaction. begin and end are 0 based, so the chunk's ids are begin + 1 to end.
+    - The first exception stops the other threads from starting new chunks, and is rethrown once they're done.
+    */
+    template<typename Load>
+    void runStage(std::ostream& progress, const char* name, int rows, Load load) {
+        const size_t chunkCount = static_cast<size_t>((rows + config.chunkRows - 1) / config.chunkRows);
+        const size_t threadCount = std::min(config.threads, chunkCount);
+        progress << "Loading " << rows << " " << name << " in " << chunkCount << " chunks on " << threadCount << " threads" << std::endl;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::atomic<size_t> nextChunk(0);
+        std::atomic<bool> failed(false);
+        std::exception_ptr failure;
+        std::mutex mutex;
+        size_t doneChunks = 0;
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threadCount; t++) {
+            workers.push_back(std::thread([&]() {
+                try {
+                    for (size_t chunk = nextChunk++; chunk < chunkCount && !failed; chunk = nextChunk++) {
+                        int begin = static_cast<int>(chunk) * config.chunkRows;
+                        int end = std::min(rows, begin + config.chunkRows);
+                        TransactionScope transaction(connectionPool);
+                        load(chunk, begin, end);
+                        transaction.commit();
+
+                        // Print every tenth of the way
+                        std::lock_guard<std::mutex> lock(mutex);
+                        doneChunks++;
+                        if (doneChunks * 10 / chunkCount != (doneChunks - 1) * 10 / chunkCount) {
+                            progress << "  " << name << ": " << doneChunks * 100 / chunkCount << "%" << std::endl;
+                        }
+                    }
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                    failed = true;
+                }
+            }));
+        }
+        for (size_t t = 0; t < workers.size(); t++) {
+            workers[t].join();
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::ios::fmtflags flags = progress.flags();
+        std::streamsize precision = progress.precision();
+        progress << std::fixed << std::setprecision(1) << "Loaded " << name << " in " << seconds << "s ("
+            << (seconds > 0 ? rows / seconds : 0.0) << " rows/s)" << std::endl;
+        progress.flags(flags);
+        progress.precision(precision);
+    }
+
+    // Sends rows to table as parameter arrays; identity says the first column is the table's identity column
+    void insertRows(const std::string& tableName, const std::string& columns, const std::vector<std::vector<SQLParam>>& rows, bool identity) {
+        if (rows.empty()) {
+            return;
+        }
+        QueryCaller queryCaller("DataGenerator::insertRows");
+        DBConnLease dbConn = connectionPool.acquire();
+        std::string placeholders = "?";
+        for (size_t i = 1; i < rows[0].size(); i++) {
+            placeholders += ", ?";
+        }
+        std::string query = "INSERT INTO " + tableName + " (" + columns + ") VALUES (" + placeholders + ");";
+
+        std::unique_ptr<IdentityInsert> identityInsert;
+        if (identity) {
+            identityInsert.reset(new IdentityInsert(*dbConn, tableName));
+        }
+        if (!dbConn->executeBulk(query, rows)) {
+            throw std::runtime_error("Failed to load rows into '" + tableName + "'!");
+        }
+    }
+
+    void loadSuppliers(size_t chunk, int begin, int end) {
+        static const std::vector<std::string> PREFIXES = { "Northwind", "Blue Ridge", "Summit", "Harbor", "Evergreen", "Redwood",
+            "Prairie", "Lakeside", "Ironwood", "Silver Creek", "Golden Gate", "Maple Leaf", "Sunrise", "Pioneer", "Atlas", "Cedar" };
+        static const std::vector<std::string> KINDS = { "Trading", "Supply", "Wholesale", "Imports", "Distributors", "Goods", "Partners" };
+        static const std::vector<std::string> CATEGORIES = { "kitchen", "garden", "electronics", "toys", "apparel", "sporting goods",
+            "office supplies", "home decor", "grocery", "hardware", "pet supplies", "beauty" };
+
+        SeededRandom random(SeededRandom::mix(config.seed, static_cast<uint64_t>(Stream::Suppliers), chunk));
+        std::vector<std::vector<SQLParam>> supplierRows;
+        std::vector<std::vector<SQLParam>> nameRows;
+        for (int i = begin; i < end; i++) {
+            const int supplier_id = i + 1;
+            std::string s_name = random.pick(PREFIXES) + " " + random.pick(KINDS) + " " + std::to_string(supplier_id);
+            std::string description = "Wholesaler of " + random.pick(CATEGORIES) + " and " + random.pick(CATEGORIES) + ".";
+            std::string email = "orders@supplier" + std::to_string(supplier_id) + ".example.com";
+            supplierRows.push_back({ supplier_id, description, email, randomAddress(random) });
+            nameRows.push_back({ supplier_id, s_name });
+        }
+        insertRows(tables.suppliers, "supplier_id, description, email, address", supplierRows, true);
+        insertRows(tables.supplierNames, "supplier_id, s_name", nameRows, false);
+    }
+
+    void loadCustomers(size_t chunk, int begin, int end) {
+        static const std::vector<std::string> FIRST_NAMES = { "James", "Mary", "Robert", "Patricia", "John", "Jennifer", "Michael",
+            "Linda", "David", "Elizabeth", "William", "Barbara", "Richard", "Susan", "Joseph", "Jessica", "Thomas", "Sarah", "Carlos",
+            "Karen", "Daniel", "Lisa", "Matthew", "Nancy", "Anthony", "Sandra", "Mark", "Ashley", "Wei", "Emily", "Ahmed", "Priya",
+            "Kevin", "Maria", "Brian", "Fatima", "Hiroshi", "Olivia", "Diego", "Aisha" };
+        static const std::vector<std::string> LAST_NAMES = { "Smith", "Johnson", "Williams", "Brown", "Jones", "Garcia", "Miller",
+            "Davis", "Rodriguez", "Martinez", "Hernandez", "Lopez", "Gonzalez", "Wilson", "Anderson", "Thomas", "Taylor", "Moore",
+            "Jackson", "Martin", "Lee", "Perez", "Thompson", "White", "Harris", "Sanchez", "Clark", "Ramirez", "Lewis", "Robinson",
+            "Nguyen", "Kim", "Patel", "Chen", "Singh", "Tanaka", "Okafor", "Novak", "Schmidt", "Rossi" };
+
+        SeededRandom random(SeededRandom::mix(config.seed, static_cast<uint64_t>(Stream::Customers), chunk));
+        std::vector<std::vector<SQLParam>> rows;
+        rows.reserve(static_cast<size_t>(end - begin));
+        for (int i = begin; i < end; i++) {
+            const int customer_id = i + 1;
+            const std::string& fname = random.pick(FIRST_NAMES);
+            const std::string& lname = random.pick(LAST_NAMES);
+            std::string email = toLower(fname) + "." + toLower(lname) + std::to_string(customer_id) + "@example.com";
+            int points = std::min(5000, random.nextGeometric(1.0 / 150)); // Most have a few points, a few have a lot
+            rows.push_back({ customer_id, fname, lname, email, points });
+        }
+        insertRows(tables.customers, "customer_id, fname, lname, email, points", rows, true);
+    }
+
+    void loadProducts(size_t chunk, int begin, int end) {
+        static const std::vector<std::string> ADJECTIVES = { "Classic", "Deluxe", "Compact", "Organic", "Wireless", "Stainless",
+            "Vintage", "Ultra", "Eco", "Premium", "Portable", "Smart", "Heavy Duty", "Mini", "Handmade", "Everyday" };
+        static const std::vector<std::string> NOUNS = { "Kettle", "Lamp", "Backpack", "Headphones", "Blender", "Notebook", "Chair",
+            "Water Bottle", "Drill", "Sneakers", "Blanket", "Coffee Beans", "Plant Pot", "Desk", "Umbrella", "Jacket", "Candle",
+            "Board Game", "Dog Bed", "Skillet" };
+
+        SeededRandom random(SeededRandom::mix(config.seed, static_cast<uint64_t>(Stream::Products), chunk));
+        std::vector<std::vector<SQLParam>> rows;
+        rows.reserve(static_cast<size_t>(end - begin));
+        for (int i = begin; i < end; i++) {
+            const int product_id = i + 1;
+            const int supplier_id = suppliersByRank[supplierPopularity(random)];
+            const std::string& adjective = random.pick(ADJECTIVES);
+            const std::string& noun = random.pick(NOUNS);
+            std::string p_name = adjective + " " + noun + " " + std::to_string(product_id);
+            std::string description = "A " + toLower(adjective) + " " + toLower(noun) + ", model " + std::to_string(random.nextInt(100, 9999)) + ".";
+
+            // Prices are log-normal: mostly around $20, with a long tail of expensive things
+            double price = std::min(9999.99, std::max(0.99, std::round(std::exp(3.0 + 0.9 * random.nextNormal()) * 100) / 100));
+            int qty = random.nextBool(0.05) ? 0 : random.nextInt(1, 500);
+            prices[static_cast<size_t>(i)] = price;
+            rows.push_back({ product_id, supplier_id, p_name, description, price, qty });
+        }
+        insertRows(tables.products, "product_id, supplier_id, p_name, description, price, qty", rows, true);
+    }
+
+    // How many order items a transaction has, from the chunk's item count stream; at least 1, and averageItems on average
+    int nextItemCount(SeededRandom& itemCounts) const {
+        return std::min(MAX_ITEMS_PER_ORDER, 1 + itemCounts.nextGeometric(1.0 / averageItems));
+    }
+
+    // Draws every transaction's item count up front (the chunks draw them again), so each chunk knows its first order_item_id
+    long long countOrderItems() {
+        const size_t chunkCount = static_cast<size_t>((config.transactions + config.chunkRows - 1) / config.chunkRows);
+        firstOrderItemIDs.assign(chunkCount, 0);
+        long long total = 0;
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            if (total >= std::numeric_limits<int>::max()) {
+                throw std::runtime_error("Too many order items for an INT order_item_id!");
+            }
+            firstOrderItemIDs[chunk] = static_cast<int>(total + 1);
+            SeededRandom itemCounts(SeededRandom::mix(config.seed, static_cast<uint64_t>(Stream::ItemCounts), chunk));
+            int begin = static_cast<int>(chunk) * config.chunkRows;
+            int end = std::min(config.transactions, begin + config.chunkRows);
+            for (int i = begin; i < end; i++) {
+                total += nextItemCount(itemCounts);
+            }
+        }
+        return total;
+    }
+
+    // Loads a chunk of transactions, then their order items
+    void loadTransactions(size_t chunk, int begin, int end) {
+        SeededRandom random(SeededRandom::mix(config.seed, static_cast<uint64_t>(Stream::Transactions), chunk));
+        SeededRandom itemCounts(SeededRandom::mix(config.seed, static_cast<uint64_t>(Stream::ItemCounts), chunk));
+        std::vector<std::vector<SQLParam>> transactionRows;
+        std::vector<std::vector<SQLParam>> orderItemRows;
+        transactionRows.reserve(static_cast<size_t>(end - begin));
+        orderItemRows.reserve(static_cast<size_t>((end - begin) * averageItems * 1.2));
+        int order_item_id = firstOrderItemIDs[chunk];
+        std::vector<int> productIDs;
+        for (int i = begin; i < end; i++) {
+            const int transaction_id = i + 1;
+
+            // Spreading the transactions evenly over the day volumes keeps the ids in date order
+            const std::string& orderDate = orderDays[orderDayVolume.at((i + 0.5) / config.transactions)];
+            const int customer_id = customersByRank[customerPopularity(random)];
+
+            const int itemCount = nextItemCount(itemCounts);
+            productIDs.clear();
+            double total = 0;
+            for (int k = 0; k < itemCount; k++) {
+                int product_id = productsByRank[productPopularity(random)];
+                for (int tries = 0; tries < 10 && std::find(productIDs.begin(), productIDs.end(), product_id) != productIDs.end(); tries++) {
+                    product_id = productsByRank[productPopularity(random)]; // Popular products would come up twice a lot; pick again
+                }
+                productIDs.push_back(product_id);
+                int qty = std::min(10, 1 + random.nextGeometric(0.6));
+                total += qty * prices[static_cast<size_t>(product_id - 1)];
+                orderItemRows.push_back({ order_item_id++, transaction_id, product_id, qty });
+            }
+            transactionRows.push_back({ transaction_id, customer_id, std::round(total * 100) / 100, orderDate });
+        }
+        insertRows(tables.transactions, "transaction_id, customer_id, total, order_date", transactionRows, true);
+        insertRows(tables.orderItems, "order_item_id, transaction_id, product_id, qty", orderItemRows, true);
+    }
+
+    static std::vector<int> shuffledIDs(SeededRandom& random, int count) {
+        std::vector<int> ids(static_cast<size_t>(count));
+        for (int i = 0; i < count; i++) {
+            ids[static_cast<size_t>(i)] = i + 1;
+        }
+        random.shuffle(ids);
+        return ids;
+    }
+
+    static std::string randomAddress(SeededRandom& random) {
+        static const std::vector<std::string> STREETS = { "Main", "Oak", "Pine", "Elm", "Washington", "Lake", "Hill", "Park",
+            "River", "Market", "Industrial", "Commerce" };
+        static const std::vector<std::string> SUFFIXES = { "St", "Ave", "Blvd", "Rd", "Way", "Pkwy" };
+        return std::to_string(random.nextInt(1, 9999)) + " " + random.pick(STREETS) + " " + random.pick(SUFFIXES);
+    }
+
+    static std::string toLower(std::string value) {
+        for (size_t i = 0; i < value.length(); i++) {
+            value[i] = static_cast<char>(std::tolower(static_cast<unsigned char>(value[i])));
+        }
+        value.erase(std::remove(value.begin(), value.end(), ' '), value.end());
+        return value;
+    }
+
+    static bool isLeapYear(int year) {
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+
+    static int daysInMonth(int year, int month) {
+        static const int DAYS[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+        return month == 2 && isLeapYear(year) ? 29 : DAYS[month - 1];
+    }
+
+    // Days since 1970-01-01 (Howard Hinnant's days_from_civil)
+    static long long daysFromCivil(int year, int month, int day) {
+        year -= month <= 2 ? 1 : 0;
+        const long long era = (year >= 0 ? year : year - 399) / 400;
+        const long long yearOfEra = year - era * 400;
+        const long long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const long long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 719468;
+    }
+
+    static std::string formatDate(int year, int month, int day) {
+        char date[32];
+        snprintf(date, sizeof(date), "%04d-%02d-%02d", year, month, day);
+        return date;
+    }
+};
+
+#endif
@@ -0,0 +1,991 @@
+#ifndef InProcessBackend_H
+#define InProcessBackend_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include "StorageBackend.h"
+#include "InProcessDatabase.h"
+
+/*
++ InProcessBackend: A StorageBackend that keeps everything in an InProcessDatabase, in this process's memory.
+
+        InProcessBackend backend;
+        RetailApp myStore(backend);
+
+- The stores do what the managers' SQL does: same checks, same errors, the foreign keys and the unique supplier
+  names are enforced, and checking out follows the checkout procedure step for step. So the store (or a replay, or
+  a benchmark) behaves the same as it does on SQL Server, minus the network and the server.
+- Reads build the same Customer, Product, etc. objects the managers do, so what's left to measure is our own code.
+- The database starts empty, and there's no initTable; the tables are always there.
+
+NOTE: Everything is gone when the backend is destroyed, so this is for benchmarks, tests and trying things out.
+*/
+
+typedef std::unique_lock<std::recursive_mutex> InProcessLock;
+
+
+// InProcessBackend's ReadBatch; the reads are held until execute(), like a QueryBatch
+class InProcessReadBatch : public ReadBatch {
+public:
+    typedef std::function<void()> Read;
+
+    // The InProcessReadBatch behind batch; throws if batch came from some other backend
+    static InProcessReadBatch& from(ReadBatch& batch) {
+        InProcessReadBatch* readBatch = dynamic_cast<InProcessReadBatch*>(&batch);
+        if (readBatch == nullptr) {
+            throw std::runtime_error("An in-process store was given a read batch from another storage backend!");
+        }
+        return *readBatch;
+    }
+
+    void add(Read read) {
+        reads.push_back(std::move(read));
+    }
+
+    // Runs the reads in the order they were added; the batch is emptied either way
+    void execute() override {
+        std::vector<Read> pending;
+        pending.swap(reads);
+        for (size_t i = 0; i < pending.size(); i++) {
+            pending[i]();
+        }
+    }
+
+private:
+    std::vector<Read> reads;
+};
+
+
+// A RowCursor over rows copied out of the database, so a RowStream doesn't hold the database's lock while it's read
+template<typename T>
+class InProcessCursor : public RowCursor<T> {
+public:
+    explicit InProcessCursor(std::vector<T> rows) : rows(std::move(rows)), position(0) {}
+
+    bool next(std::vector<T>& row) override {
+        if (position >= rows.size()) {
+            return false;
+        }
+        row.clear();
+        row.push_back(std::move(rows[position++]));
+        return true;
+    }
+
+    static RowStream<T> stream(std::vector<T> rows) {
+        return RowStream<T>(std::unique_ptr<RowCursor<T>>(new InProcessCursor<T>(std::move(rows))));
+    }
+
+private:
+    std::vector<T> rows;
+    size_t position;
+};
+
+
+class InProcessCustomerStore : public CustomerStore {
+public:
+    explicit InProcessCustomerStore(InProcessDatabase& database) : database(database) {}
+
+    std::vector<Customer> getAllCustomers() override {
+        InProcessLock lock(database.mutex);
+        std::vector<Customer> customers;
+        customers.reserve(database.customers.size());
+        database.customers.forEach([&customers](int id, InProcessDatabase::CustomerRow& row) { customers.push_back(toCustomer(id, row)); });
+        return customers;
+    }
+
+    int getCustomerCount() override {
+        InProcessLock lock(database.mutex);
+        return static_cast<int>(database.customers.size());
+    }
+
+    std::vector<Customer> getCustomerPage(int afterID, int pageSize) override {
+        InProcessLock lock(database.mutex);
+        std::vector<Customer> customers;
+        database.customers.forEachAfter(afterID, pageLimit(pageSize), [](const InProcessDatabase::CustomerRow&) { return true; },
+            [&customers](int id, InProcessDatabase::CustomerRow& row) { customers.push_back(toCustomer(id, row)); });
+        return customers;
+    }
+
+    Customer getCustomerByID(int customer_id) override {
+        std::vector<Customer> customers = findCustomer(customer_id);
+        if (customers.empty()) {
+            throw std::runtime_error("Customer with ID '" + std::to_string(customer_id) + "' wasn't found!");
+        }
+        return customers[0];
+    }
+
+    void batchGetCustomerByID(ReadBatch& batch, int customer_id, std::vector<Customer>& customers) override {
+        InProcessReadBatch::from(batch).add([this, customer_id, &customers]() { customers = findCustomer(customer_id); });
+    }
+
+    Customer createCustomer(std::string fname, std::string lname, std::string email, int points) override {
+        validateFirstName(fname);
+        validateLastName(lname);
+        validateEmail(email);
+        InProcessLock lock(database.mutex);
+        int customer_id = database.customers.insert({ fname, lname, email, points });
+        return Customer(customer_id, fname, lname, email, points);
+    }
+
+    std::vector<Customer> batchCreateCustomer(std::vector<std::tuple<std::string, std::string, std::string, int>> customerRows) override {
+        // Validate every customer before inserting any of them
+        for (size_t i = 0; i < customerRows.size(); i++) {
+            validateFirstName(std::get<0>(customerRows[i]));
+            validateLastName(std::get<1>(customerRows[i]));
+            validateEmail(std::get<2>(customerRows[i]));
+        }
+
+        InProcessLock lock(database.mutex);
+        std::vector<Customer> customers;
+        customers.reserve(customerRows.size());
+        for (size_t i = 0; i < customerRows.size(); i++) {
+            InProcessDatabase::CustomerRow row = { std::get<0>(customerRows[i]), std::get<1>(customerRows[i]), std::get<2>(customerRows[i]), std::get<3>(customerRows[i]) };
+            int customer_id = database.customers.insert(row);
+            customers.push_back(toCustomer(customer_id, row));
+        }
+        return customers;
+    }
+
+    void updateFirstName(int customer_id, std::string fname) override {
+        validateFirstName(fname);
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::CustomerRow* customer = database.customers.update(customer_id)) {
+            customer->fname = std::move(fname);
+        }
+    }
+
+    void updateLastName(int customer_id, std::string lname) override {
+        validateLastName(lname);
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::CustomerRow* customer = database.customers.update(customer_id)) {
+            customer->lname = std::move(lname);
+        }
+    }
+
+    void updateEmail(int customer_id, std::string email) override {
+        validateEmail(email);
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::CustomerRow* customer = database.customers.update(customer_id)) {
+            customer->email = std::move(email);
+        }
+    }
+
+    void updatePoints(int customer_id, int points) override {
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::CustomerRow* customer = database.customers.update(customer_id)) {
+            customer->points = points;
+        }
+    }
+
+    // Like the foreign keys on SQL Server, fails while the customer still has a cart or transactions
+    void deleteCustomer(int customer_id) override {
+        InProcessLock lock(database.mutex);
+        bool isReferenced = database.findCart(customer_id) != nullptr;
+        database.transactions.forEach([customer_id, &isReferenced](int, InProcessDatabase::TransactionRow& row) {
+            isReferenced = isReferenced || row.customer_id == customer_id;
+        });
+        if (isReferenced) {
+            throw std::runtime_error("Failed to delete customer with id '" + std::to_string(customer_id) + "'. Customer may not exist!");
+        }
+        database.customers.erase(customer_id);
+    }
+
+private:
+    InProcessDatabase& database;
+
+    static Customer toCustomer(int customer_id, const InProcessDatabase::CustomerRow& row) {
+        return Customer(customer_id, row.fname, row.lname, row.email, row.points);
+    }
+
+    // The customer with customer_id, or an empty vector; the same thing the manager's query gets back
+    std::vector<Customer> findCustomer(int customer_id) {
+        InProcessLock lock(database.mutex);
+        std::vector<Customer> customers;
+        if (InProcessDatabase::CustomerRow* customer = database.customers.find(customer_id)) {
+            customers.push_back(toCustomer(customer_id, *customer));
+        }
+        return customers;
+    }
+
+    static size_t pageLimit(int pageSize) {
+        return pageSize < 0 ? 0 : static_cast<size_t>(pageSize);
+    }
+};
+
+
+class InProcessSupplierStore : public SupplierStore {
+public:
+    explicit InProcessSupplierStore(InProcessDatabase& database) : database(database) {}
+
+    bool isValidSupplierID(int supplier_id) override {
+        InProcessLock lock(database.mutex);
+        return database.suppliers.find(supplier_id) != nullptr;
+    }
+
+    std::vector<Supplier> getAllSuppliers() override {
+        InProcessLock lock(database.mutex);
+        std::vector<Supplier> suppliers;
+        suppliers.reserve(database.suppliers.size());
+        database.suppliers.forEach([&suppliers](int id, InProcessDatabase::SupplierRow& row) { suppliers.push_back(toSupplier(id, row)); });
+        return suppliers;
+    }
+
+    int getSupplierCount() override {
+        InProcessLock lock(database.mutex);
+        return static_cast<int>(database.suppliers.size());
+    }
+
+    std::vector<Supplier> getSupplierPage(int afterID, int pageSize) override {
+        InProcessLock lock(database.mutex);
+        std::vector<Supplier> suppliers;
+        database.suppliers.forEachAfter(afterID, pageSize < 0 ? 0 : static_cast<size_t>(pageSize), [](const InProcessDatabase::SupplierRow&) { return true; },
+            [&suppliers](int id, InProcessDatabase::SupplierRow& row) { suppliers.push_back(toSupplier(id, row)); });
+        return suppliers;
+    }
+
+    Supplier getSupplierByID(int supplier_id) override {
+        InProcessLock lock(database.mutex);
+        InProcessDatabase::SupplierRow* supplier = database.suppliers.find(supplier_id);
+        if (supplier == nullptr) {
+            throw std::runtime_error("Supplier with ID '" + std::to_string(supplier_id) + "' wasn't found!");
+        }
+        return toSupplier(supplier_id, *supplier);
+    }
+
+    Supplier createSupplier(std::string& s_name, std::string& description, std::string& email, std::string& address) override {
+        validateSupplierName(s_name);
+        validateDescription(description);
+        validateEmail(email);
+        validateAddress(address);
+        InProcessLock lock(database.mutex);
+        checkUniqueSupplierName(s_name);
+        int supplier_id = database.insertSupplier({ s_name, description, email, address });
+        return Supplier(supplier_id, s_name, description, email, address);
+    }
+
+    void updateName(int supplier_id, std::string& s_name) override {
+        validateSupplierName(s_name);
+        InProcessLock lock(database.mutex);
+        checkUniqueSupplierName(s_name, supplier_id);
+        database.updateSupplierName(supplier_id, s_name);
+    }
+
+    void updateDescription(int supplier_id, std::string& description) override {
+        validateDescription(description);
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::SupplierRow* supplier = database.suppliers.update(supplier_id)) {
+            supplier->description = description;
+        }
+    }
+
+    void updateEmail(int supplier_id, std::string& email) override {
+        validateEmail(email);
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::SupplierRow* supplier = database.suppliers.update(supplier_id)) {
+            supplier->email = email;
+        }
+    }
+
+    void updateAddress(int supplier_id, std::string& address) override {
+        validateAddress(address);
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::SupplierRow* supplier = database.suppliers.update(supplier_id)) {
+            supplier->address = address;
+        }
+    }
+
+    // Like the foreign key on SQL Server, fails while the supplier still has products
+    void deleteSupplier(int supplier_id) override {
+        InProcessLock lock(database.mutex);
+        bool hasProducts = false;
+        database.products.forEach([supplier_id, &hasProducts](int, InProcessDatabase::ProductRow& row) {
+            hasProducts = hasProducts || row.supplier_id == supplier_id;
+        });
+        if (hasProducts) {
+            throw std::runtime_error("Failed to delete supplier with id '" + std::to_string(supplier_id) + "'!");
+        }
+        database.eraseSupplier(supplier_id);
+    }
+
+private:
+    InProcessDatabase& database;
+
+    static Supplier toSupplier(int supplier_id, const InProcessDatabase::SupplierRow& row) {
+        return Supplier(supplier_id, row.s_name, row.description, row.email, row.address);
+    }
+
+    // Throws if another supplier already has s_name; renaming a supplier to its own name is fine, like on SQL Server
+    void checkUniqueSupplierName(const std::string& s_name, int supplier_id = 0) {
+        int owner_id = database.findSupplierByName(s_name);
+        if (owner_id != 0 && owner_id != supplier_id) {
+            throw std::runtime_error("SupplierName with s_name '" + s_name + "' already exists!");
+        }
+    }
+};
+
+
+/*
++ InProcessProductStore: Unlike ProductManager, the list functions hand back products with their descriptions, since
+    copying a string out of memory costs next to nothing next to a round trip. There's no cache either, for the same reason.
+*/
+class InProcessProductStore : public ProductStore {
+public:
+    explicit InProcessProductStore(InProcessDatabase& database) : database(database) {}
+
+    std::string getProductDescription(int product_id) override {
+        InProcessLock lock(database.mutex);
+        return findProduct(product_id).description;
+    }
+
+    std::vector<Product> getAllProducts() override {
+        return getProducts(false);
+    }
+
+    RowStream<Product> streamAll() override {
+        return InProcessCursor<Product>::stream(getProducts(false));
+    }
+
+    std::vector<Product> getAvailableProducts() override {
+        return getProducts(true);
+    }
+
+    int getProductCount(bool onlyAvailable = false) override {
+        InProcessLock lock(database.mutex);
+        if (!onlyAvailable) {
+            return static_cast<int>(database.products.size());
+        }
+        int count = 0;
+        database.products.forEach([&count](int, InProcessDatabase::ProductRow& row) { count += row.qty > 0 ? 1 : 0; });
+        return count;
+    }
+
+    std::vector<Product> getProductPage(int afterID, int pageSize, bool onlyAvailable = false) override {
+        InProcessLock lock(database.mutex);
+        std::vector<Product> products;
+        database.products.forEachAfter(afterID, pageSize < 0 ? 0 : static_cast<size_t>(pageSize),
+            [onlyAvailable](const InProcessDatabase::ProductRow& row) { return !onlyAvailable || row.qty > 0; },
+            [&products](int id, InProcessDatabase::ProductRow& row) { products.push_back(toProduct(id, row)); });
+        return products;
+    }
+
+    Product getProductByID(int product_id) override {
+        InProcessLock lock(database.mutex);
+        return toProduct(product_id, findProduct(product_id));
+    }
+
+    std::map<int, int> getProductQuantities(std::vector<int> productIDs) override {
+        InProcessLock lock(database.mutex);
+        std::map<int, int> productQuantityMap;
+        for (size_t i = 0; i < productIDs.size(); i++) {
+            if (InProcessDatabase::ProductRow* product = database.products.find(productIDs[i])) {
+                productQuantityMap[productIDs[i]] = product->qty;
+            }
+        }
+        return productQuantityMap;
+    }
+
+    void batchUpdateProductQty(std::vector<std::tuple<int, int>> productQuantities) override {
+        // The qty >= 0 check constraint; checked up front, so it's all or nothing
+        for (size_t i = 0; i < productQuantities.size(); i++) {
+            if (std::get<1>(productQuantities[i]) < 0) {
+                throw std::runtime_error("Failed to update product quantities!");
+            }
+        }
+        InProcessLock lock(database.mutex);
+        for (size_t i = 0; i < productQuantities.size(); i++) {
+            if (InProcessDatabase::ProductRow* product = database.products.update(std::get<0>(productQuantities[i]))) {
+                product->qty = std::get<1>(productQuantities[i]);
+            }
+        }
+    }
+
+    // ProductManager doesn't validate here and leaves it to the table's constraints, so a bad product gets the same error as the failed insert
+    Product createProduct(int supplier_id, std::string p_name, std::string description, float price, int qty) override {
+        InProcessLock lock(database.mutex);
+        if (!fitsColumns(p_name, description, price, qty) || database.suppliers.find(supplier_id) == nullptr) {
+            throw std::runtime_error("Failed to create with supplier_id(" + std::to_string(supplier_id) + "), and p_name '" + p_name + "'!");
+        }
+        InProcessDatabase::ProductRow row = { supplier_id, std::move(p_name), std::move(description), InProcessDatabase::toMoney(price), qty };
+        int product_id = database.products.insert(row);
+        return toProduct(product_id, row);
+    }
+
+    std::vector<Product> batchCreateProduct(std::vector<std::tuple<int, std::string, std::string, float, int>> productRows) override {
+        // Validate every product before inserting any of them
+        for (size_t i = 0; i < productRows.size(); i++) {
+            validateProductName(std::get<1>(productRows[i]));
+            validateDescription(std::get<2>(productRows[i]));
+            validatePrice(std::get<3>(productRows[i]));
+            validateQty(std::get<4>(productRows[i]));
+        }
+
+        InProcessLock lock(database.mutex);
+        for (size_t i = 0; i < productRows.size(); i++) {
+            if (database.suppliers.find(std::get<0>(productRows[i])) == nullptr) {
+                throw std::runtime_error("Failed to create " + std::to_string(productRows.size()) + " products!");
+            }
+        }
+        std::vector<Product> products;
+        products.reserve(productRows.size());
+        for (size_t i = 0; i < productRows.size(); i++) {
+            InProcessDatabase::ProductRow row = { std::get<0>(productRows[i]), std::get<1>(productRows[i]), std::get<2>(productRows[i]),
+                InProcessDatabase::toMoney(std::get<3>(productRows[i])), std::get<4>(productRows[i]) };
+            int product_id = database.products.insert(row);
+            products.push_back(toProduct(product_id, row));
+        }
+        return products;
+    }
+
+    void updateName(int product_id, std::string p_name) override {
+        validateProductName(p_name);
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::ProductRow* product = database.products.update(product_id)) {
+            product->p_name = std::move(p_name);
+        }
+    }
+
+    void updateDescription(int product_id, std::string description) override {
+        validateDescription(description);
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::ProductRow* product = database.products.update(product_id)) {
+            product->description = std::move(description);
+        }
+    }
+
+    void updatePrice(int product_id, float price) override {
+        validatePrice(price);
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::ProductRow* product = database.products.update(product_id)) {
+            product->price = InProcessDatabase::toMoney(price);
+        }
+    }
+
+    void updateQuantity(int product_id, int qty) override {
+        validateQty(qty);
+        InProcessLock lock(database.mutex);
+        if (InProcessDatabase::ProductRow* product = database.products.update(product_id)) {
+            product->qty = qty;
+        }
+    }
+
+    // Like the foreign keys on SQL Server, fails while the product is in a cart or an order
+    void deleteProduct(int product_id) override {
+        InProcessLock lock(database.mutex);
+        if (isReferenced(product_id)) {
+            throw std::runtime_error("Failed to delete product with id '" + std::to_string(product_id) + "'. It may not exist!");
+        }
+        database.products.erase(product_id);
+    }
+
+    void deleteBySupplierID(int supplier_id) override {
+        InProcessLock lock(database.mutex);
+        std::vector<int> productIDs;
+        database.products.forEach([supplier_id, &productIDs](int id, InProcessDatabase::ProductRow& row) {
+            if (row.supplier_id == supplier_id) {
+                productIDs.push_back(id);
+            }
+        });
+        for (size_t i = 0; i < productIDs.size(); i++) {
+            if (isReferenced(productIDs[i])) {
+                throw std::runtime_error("Failed to delete product with supplier_id '" + std::to_string(supplier_id) + "'. It may not exist!");
+            }
+        }
+        for (size_t i = 0; i < productIDs.size(); i++) {
+            database.products.erase(productIDs[i]);
+        }
+    }
+
+    // Nothing is cached
+    void invalidateCachedProducts(const std::vector<int>&) override {}
+
+private:
+    InProcessDatabase& database;
+
+    static Product toProduct(int product_id, const InProcessDatabase::ProductRow& row) {
+        return Product(product_id, row.supplier_id, row.p_name, row.description, row.price, row.qty);
+    }
+
+    // The product with product_id; throws if there isn't one. The caller holds the lock.
+    InProcessDatabase::ProductRow& findProduct(int product_id) {
+        InProcessDatabase::ProductRow* product = database.products.find(product_id);
+        if (product == nullptr) {
+            throw std::runtime_error("No product found with ID " + std::to_string(product_id));
+        }
+        return *product;
+    }
+
+    std::vector<Product> getProducts(bool onlyAvailable) {
+        InProcessLock lock(database.mutex);
+        std::vector<Product> products;
+        database.products.forEachAfter(0, database.products.size(),
+            [onlyAvailable](const InProcessDatabase::ProductRow& row) { return !onlyAvailable || row.qty > 0; },
+            [&products](int id, InProcessDatabase::ProductRow& row) { products.push_back(toProduct(id, row)); });
+        return products;
+    }
+
+    // Whether a cart item or order item references the product; order items have to be looked through one by one
+    bool isReferenced(int product_id) {
+        bool referenced = database.isProductInAnyCart(product_id);
+        database.orderItems.forEach([product_id, &referenced](int, InProcessDatabase::OrderItemRow& row) {
+            referenced = referenced || row.product_id == product_id;
+        });
+        return referenced;
+    }
+
+    // The products table's constraints: the varchar lengths, and price and qty can't be negative
+    bool fitsColumns(const std::string& p_name, const std::string& description, float price, int qty) const {
+        return p_name.length() <= MAX_P_NAME_LENGTH && description.length() <= MAX_DESCRIPTION_LENGTH && price >= 0 && qty >= 0;
+    }
+};
+
+
+class InProcessCartItemStore : public CartItemStore {
+public:
+    explicit InProcessCartItemStore(InProcessDatabase& database) : database(database) {}
+
+    std::vector<CartItem> getCustomerCartItems(int customer_id) override {
+        InProcessLock lock(database.mutex);
+        std::vector<CartItem> cartItems;
+        const std::map<int, int>* cart = database.findCart(customer_id);
+        if (cart == nullptr) {
+            return cartItems;
+        }
+        cartItems.reserve(cart->size());
+        for (std::map<int, int>::const_iterator item = cart->begin(); item != cart->end(); ++item) {
+            if (InProcessDatabase::ProductRow* product = database.products.find(item->first)) {
+                cartItems.push_back(CartItem(customer_id, item->first, item->second, product->p_name, product->price));
+            }
+        }
+        return cartItems;
+    }
+
+    void batchGetCustomerCartItems(ReadBatch& batch, int customer_id, std::vector<CartItem>& cartItems) override {
+        InProcessReadBatch::from(batch).add([this, customer_id, &cartItems]() { cartItems = getCustomerCartItems(customer_id); });
+    }
+
+    CartItem getCartItem(int customer_id, int product_id) override {
+        InProcessLock lock(database.mutex);
+        InProcessDatabase::ProductRow* product = database.products.find(product_id);
+        if (!isExistingCartItem(customer_id, product_id) || product == nullptr) {
+            throw std::runtime_error("Cart Item for customer_id(" + std::to_string(customer_id) + ") and product_id(" + std::to_string(product_id) + ") doesn't exist!");
+        }
+        return CartItem(customer_id, product_id, database.findCartItemQty(customer_id, product_id), product->p_name, product->price);
+    }
+
+    bool isExistingCartItem(int customer_id, int product_id) override {
+        InProcessLock lock(database.mutex);
+        const std::map<int, int>* cart = database.findCart(customer_id);
+        return cart != nullptr && cart->count(product_id) > 0;
+    }
+
+    void createCartItem(int customer_id, int product_id, int qty) override {
+        InProcessLock lock(database.mutex);
+        if (isExistingCartItem(customer_id, product_id)) {
+            throw std::runtime_error("Product with ID (" + std::to_string(product_id) + ") is already in customer's cart!");
+        }
+        if (!isValidKey(customer_id, product_id)) {
+            throw std::runtime_error("Insert cart item into the database!");
+        }
+        database.setCartItemQty(customer_id, product_id, qty);
+    }
+
+    void updateCartItem(int customer_id, int product_id, int qty) override {
+        InProcessLock lock(database.mutex);
+        if (!isExistingCartItem(customer_id, product_id)) {
+            throw std::runtime_error("Cart item with customer_id(" + std::to_string(customer_id) + ") and product_id(" + std::to_string(product_id) + ") isn't in customer's cart!");
+        }
+        database.setCartItemQty(customer_id, product_id, qty);
+    }
+
+    UpsertResult setCartItemQty(int customer_id, int product_id, int qty) override {
+        InProcessLock lock(database.mutex);
+        return upsertCartItem(customer_id, product_id, qty);
+    }
+
+    UpsertResult incrementCartItemQty(int customer_id, int product_id, int qty) override {
+        InProcessLock lock(database.mutex);
+        return upsertCartItem(customer_id, product_id, database.findCartItemQty(customer_id, product_id) + qty);
+    }
+
+    void deleteCartItem(int customer_id, int product_id) override {
+        InProcessLock lock(database.mutex);
+        database.eraseCartItem(customer_id, product_id);
+    }
+
+    void deleteByProductID(int product_id) override {
+        InProcessLock lock(database.mutex);
+        database.eraseCartItemsWhere([product_id](int cartProductID) { return cartProductID == product_id; });
+    }
+
+    void deleteByCustomerID(int customer_id) override {
+        InProcessLock lock(database.mutex);
+        database.eraseCart(customer_id);
+    }
+
+    void deleteBySupplierID(int supplier_id) override {
+        InProcessLock lock(database.mutex);
+        database.eraseCartItemsWhere([this, supplier_id](int product_id) {
+            InProcessDatabase::ProductRow* product = database.products.find(product_id);
+            return product != nullptr && product->supplier_id == supplier_id;
+        });
+    }
+
+private:
+    InProcessDatabase& database;
+
+    // Whether the customer and the product exist, for the foreign keys
+    bool isValidKey(int customer_id, int product_id) {
+        return database.customers.find(customer_id) != nullptr && database.products.find(product_id) != nullptr;
+    }
+
+    // Sets the item's quantity, adding it to the cart if it isn't there; the caller holds the lock
+    UpsertResult upsertCartItem(int customer_id, int product_id, int qty) {
+        if (!isValidKey(customer_id, product_id)) {
+            throw std::runtime_error("Failed to add or update cart item!");
+        }
+        UpsertResult result = isExistingCartItem(customer_id, product_id) ? UpsertResult::Updated : UpsertResult::Inserted;
+        database.setCartItemQty(customer_id, product_id, qty);
+        return result;
+    }
+};
+
+
+class InProcessTransactionStore : public TransactionStore {
+public:
+    explicit InProcessTransactionStore(InProcessDatabase& database) : database(database) {}
+
+    Transaction createTransaction(int customer_id, float total) override {
+        InProcessLock lock(database.mutex);
+        if (database.customers.find(customer_id) == nullptr) {
+            throw std::runtime_error("Failed to insert new transaction!");
+        }
+        InProcessDatabase::TransactionRow row = { customer_id, InProcessDatabase::toMoney(total), InProcessDatabase::currentDate() };
+        int transaction_id = database.transactions.insert(row);
+        return toTransaction(transaction_id, row);
+    }
+
+    std::vector<Transaction> getAllTransactions() override {
+        InProcessLock lock(database.mutex);
+        std::vector<Transaction> transactions;
+        transactions.reserve(database.transactions.size());
+        database.transactions.forEach([&transactions](int id, InProcessDatabase::TransactionRow& row) { transactions.push_back(toTransaction(id, row)); });
+        return transactions;
+    }
+
+    RowStream<Transaction> streamAll() override {
+        return InProcessCursor<Transaction>::stream(getAllTransactions());
+    }
+
+    int getTransactionCount() override {
+        InProcessLock lock(database.mutex);
+        return static_cast<int>(database.transactions.size());
+    }
+
+    std::vector<Transaction> getTransactionPage(int afterID, int pageSize) override {
+        InProcessLock lock(database.mutex);
+        std::vector<Transaction> transactions;
+        database.transactions.forEachAfter(afterID, pageSize < 0 ? 0 : static_cast<size_t>(pageSize), [](const InProcessDatabase::TransactionRow&) { return true; },
+            [&transactions](int id, InProcessDatabase::TransactionRow& row) { transactions.push_back(toTransaction(id, row)); });
+        return transactions;
+    }
+
+    Transaction getTransactionByID(int transaction_id) override {
+        std::vector<Transaction> transactions = findTransaction(transaction_id);
+        if (transactions.empty()) {
+            throw std::runtime_error("Transaction with ID(" + std::to_string(transaction_id) + ") wasn't found!");
+        }
+        return transactions[0];
+    }
+
+    void batchGetTransactionByID(ReadBatch& batch, int transaction_id, std::vector<Transaction>& transactions) override {
+        InProcessReadBatch::from(batch).add([this, transaction_id, &transactions]() { transactions = findTransaction(transaction_id); });
+    }
+
+    void nullifyCustomerID(int customer_id) override {
+        InProcessLock lock(database.mutex);
+        std::vector<int> transactionIDs;
+        database.transactions.forEach([customer_id, &transactionIDs](int id, InProcessDatabase::TransactionRow& row) {
+            if (row.customer_id == customer_id) {
+                transactionIDs.push_back(id);
+            }
+        });
+        for (size_t i = 0; i < transactionIDs.size(); i++) {
+            database.transactions.update(transactionIDs[i])->customer_id = 0;
+        }
+    }
+
+private:
+    InProcessDatabase& database;
+
+    static Transaction toTransaction(int transaction_id, const InProcessDatabase::TransactionRow& row) {
+        return Transaction(transaction_id, row.customer_id, row.total, row.order_date);
+    }
+
+    std::vector<Transaction> findTransaction(int transaction_id) {
+        InProcessLock lock(database.mutex);
+        std::vector<Transaction> transactions;
+        if (InProcessDatabase::TransactionRow* transaction = database.transactions.find(transaction_id)) {
+            transactions.push_back(toTransaction(transaction_id, *transaction));
+        }
+        return transactions;
+    }
+};
+
+
+class InProcessOrderItemStore : public OrderItemStore {
+public:
+    explicit InProcessOrderItemStore(InProcessDatabase& database) : database(database) {}
+
+    OrderItem createOrderItem(int transaction_id, int product_id, int qty) override {
+        InProcessLock lock(database.mutex);
+        if (!isValidKey(transaction_id, product_id)) {
+            throw std::runtime_error("Failed to insert order item!");
+        }
+        int order_item_id = database.insertOrderItem({ transaction_id, product_id, qty });
+        return OrderItem(order_item_id, transaction_id, product_id, qty);
+    }
+
+    std::vector<OrderItem> getOrderItems(int transaction_id) override {
+        InProcessLock lock(database.mutex);
+        std::vector<int> orderItemIDs = database.findOrderItemIDs(transaction_id);
+        std::vector<OrderItem> orderItems;
+        orderItems.reserve(orderItemIDs.size());
+        for (size_t i = 0; i < orderItemIDs.size(); i++) {
+            if (InProcessDatabase::OrderItemRow* orderItem = database.orderItems.find(orderItemIDs[i])) {
+                orderItems.push_back(toOrderItem(orderItemIDs[i], *orderItem));
+            }
+        }
+        return orderItems;
+    }
+
+    RowStream<OrderItem> streamAll() override {
+        InProcessLock lock(database.mutex);
+        std::vector<OrderItem> orderItems;
+        orderItems.reserve(database.orderItems.size());
+        database.orderItems.forEach([&orderItems](int id, InProcessDatabase::OrderItemRow& row) { orderItems.push_back(toOrderItem(id, row)); });
+        return InProcessCursor<OrderItem>::stream(std::move(orderItems));
+    }
+
+    void batchGetOrderItems(ReadBatch& batch, int transaction_id, std::vector<OrderItem>& orderItems) override {
+        InProcessReadBatch::from(batch).add([this, transaction_id, &orderItems]() { orderItems = getOrderItems(transaction_id); });
+    }
+
+    void batchCreateOrderItem(std::vector<std::tuple<int, int, int>> orderItems) override {
+        InProcessLock lock(database.mutex);
+        for (size_t i = 0; i < orderItems.size(); i++) {
+            if (!isValidKey(std::get<0>(orderItems[i]), std::get<1>(orderItems[i]))) {
+                throw std::runtime_error("Failed to insert order items!");
+            }
+        }
+        for (size_t i = 0; i < orderItems.size(); i++) {
+            database.insertOrderItem({ std::get<0>(orderItems[i]), std::get<1>(orderItems[i]), std::get<2>(orderItems[i]) });
+        }
+    }
+
+    void nullifyProductID(int product_id) override {
+        InProcessLock lock(database.mutex);
+        nullifyWhere([product_id](int orderProductID) { return orderProductID == product_id; });
+    }
+
+    void nullifyProductIDBySupplierID(int supplier_id) override {
+        InProcessLock lock(database.mutex);
+        nullifyWhere([this, supplier_id](int product_id) {
+            InProcessDatabase::ProductRow* product = database.products.find(product_id);
+            return product != nullptr && product->supplier_id == supplier_id;
+        });
+    }
+
+private:
+    InProcessDatabase& database;
+
+    static OrderItem toOrderItem(int order_item_id, const InProcessDatabase::OrderItemRow& row) {
+        return OrderItem(order_item_id, row.transaction_id, row.product_id, row.qty);
+    }
+
+    // Whether the transaction and the product exist, for the foreign keys
+    bool isValidKey(int transaction_id, int product_id) {
+        return database.transactions.find(transaction_id) != nullptr && database.products.find(product_id) != nullptr;
+    }
+
+    // Sets product_id to NULL (0) on every order item whose product matches predicate; the caller holds the lock
+    void nullifyWhere(std::function<bool(int product_id)> predicate) {
+        std::vector<int> orderItemIDs;
+        database.orderItems.forEach([&predicate, &orderItemIDs](int id, InProcessDatabase::OrderItemRow& row) {
+            if (row.product_id != 0 && predicate(row.product_id)) {
+                orderItemIDs.push_back(id);
+            }
+        });
+        for (size_t i = 0; i < orderItemIDs.size(); i++) {
+            database.orderItems.update(orderItemIDs[i])->product_id = 0;
+        }
+    }
+};
+
+
+/*
++ InProcessCheckoutStore: Checks out a cart the same way CheckoutManager's procedure does, step for step, in one
+    InProcessTransaction. The statuses are checked in the procedure's order, and a failed checkout changes nothing.
+*/
+class InProcessCheckoutStore : public CheckoutStore {
+public:
+    explicit InProcessCheckoutStore(InProcessDatabase& database) : database(database) {}
+
+    CheckoutResult checkout(int customer_id, int usedPoints) override {
+        InProcessTransaction transaction(database);
+        CheckoutResult result;
+        result.orderDate = InProcessDatabase::currentDate();
+
+        InProcessDatabase::CustomerRow* customer = database.customers.update(customer_id);
+        if (customer == nullptr) {
+            result.status = Status::CustomerNotFound;
+            return result;
+        }
+        result.points = customer->points;
+
+        const std::map<int, int>* cart = database.findCart(customer_id);
+        if (cart == nullptr) {
+            result.status = Status::EmptyCart;
+            return result;
+        }
+        if (usedPoints < 0 || usedPoints > customer->points) {
+            result.status = Status::InsufficientPoints;
+            return result;
+        }
+
+        // Check every product has enough stock before taking any of it
+        for (std::map<int, int>::const_iterator item = cart->begin(); item != cart->end(); ++item) {
+            InProcessDatabase::ProductRow* product = database.products.find(item->first);
+            if (product == nullptr || product->qty < item->second) {
+                result.status = Status::InsufficientStock;
+                result.productID = item->first;
+                return result;
+            }
+        }
+
+        // Take the stock and add up the total
+        double total = 0;
+        std::vector<std::pair<int, int>> items(cart->begin(), cart->end());
+        for (size_t i = 0; i < items.size(); i++) {
+            InProcessDatabase::ProductRow* product = database.products.update(items[i].first);
+            product->qty -= items[i].second;
+            total += static_cast<double>(items[i].second) * product->price;
+        }
+        total = total > usedPoints ? total - usedPoints : 0;
+
+        // Record the transaction and its order items, and clear the cart
+        InProcessDatabase::TransactionRow transactionRow = { customer_id, InProcessDatabase::toMoney(total), result.orderDate };
+        result.transactionID = database.transactions.insert(transactionRow);
+        for (size_t i = 0; i < items.size(); i++) {
+            database.insertOrderItem({ result.transactionID, items[i].first, items[i].second });
+        }
+        database.eraseCart(customer_id);
+
+        // One point for every 10 dollars spent, same as the procedure
+        result.total = transactionRow.total;
+        result.points = customer->points - usedPoints + static_cast<int>(std::floor(result.total / 10));
+        customer->points = result.points;
+        transaction.commit();
+        return result;
+    }
+
+private:
+    InProcessDatabase& database;
+};
+
+
+class InProcessBackend : public StorageBackend {
+public:
+    InProcessBackend()
+        : customerStore(database),
+        supplierStore(database),
+        productStore(database),
+        cartItemStore(database),
+        transactionStore(database),
+        orderItemStore(database),
+        checkoutStore(database) {}
+
+    InProcessBackend(const InProcessBackend&) = delete;
+    InProcessBackend& operator=(const InProcessBackend&) = delete;
+
+    CustomerStore& getCustomerStore() override {
+        return customerStore;
+    }
+
+    SupplierStore& getSupplierStore() override {
+        return supplierStore;
+    }
+
+    ProductStore& getProductStore() override {
+        return productStore;
+    }
+
+    CartItemStore& getCartItemStore() override {
+        return cartItemStore;
+    }
+
+    TransactionStore& getTransactionStore() override {
+        return transactionStore;
+    }
+
+    OrderItemStore& getOrderItemStore() override {
+        return orderItemStore;
+    }
+
+    CheckoutStore& getCheckoutStore() override {
+        return checkoutStore;
+    }
+
+    std::unique_ptr<StorageTransaction> beginTransaction() override {
+        return std::unique_ptr<StorageTransaction>(new BackendTransaction(database));
+    }
+
+    std::unique_ptr<ReadBatch> newReadBatch() override {
+        return std::unique_ptr<ReadBatch>(new InProcessReadBatch());
+    }
+
+    // Everything takes the one database lock, so nothing can deadlock
+    bool wasDeadlockVictim() override {
+        return false;
+    }
+
+    void clearLastError() override {}
+
+    // There are no connections to hold
+    std::unique_ptr<ConnectionHold> holdConnection() override {
+        return std::unique_ptr<ConnectionHold>();
+    }
+
+private:
+    // An InProcessTransaction behind the StorageTransaction interface
+    class BackendTransaction : public StorageTransaction {
+    public:
+        explicit BackendTransaction(InProcessDatabase& database) : transaction(database) {}
+
+        void commit() override {
+            transaction.commit();
+        }
+
+    private:
+        InProcessTransaction transaction;
+    };
+
+    InProcessDatabase database; // First, so it's made before the stores that use it
+    InProcessCustomerStore customerStore;
+    InProcessSupplierStore supplierStore;
+    InProcessProductStore productStore;
+    InProcessCartItemStore cartItemStore;
+    InProcessTransactionStore transactionStore;
+    InProcessOrderItemStore orderItemStore;
+    InProcessCheckoutStore checkoutStore;
+};
+
+#endif
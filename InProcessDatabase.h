@@ -0,0 +1,449 @@
+#ifndef InProcessDatabase_H
+#define InProcessDatabase_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <mutex>
+#include <stdexcept>
+#include <cmath>
+#include <ctime>
+
+/*
++ InProcessDatabase: The tables behind InProcessBackend, kept in this process's memory.
+
+- Each table is a hash map from its ID to its row, plus the IDs in order, so lookups by ID are one hash probe and
+  pages (keyset pagination, like the managers do) are a binary search and a walk. IDs are handed out like IDENTITY
+  columns: they start at 1, only go up, and aren't given back when an insert is rolled back.
+- The lookups RetailApp does on something other than an ID have a hash index too: cart items by customer, order items
+  by transaction, and suppliers by name (which also keeps the names unique).
+- One (recursive) mutex guards everything. A transaction holds it from start to finish, so transactions run one at a
+  time, which is as strict as SERIALIZABLE; everything else holds it for one store call.
+- Rolling back is done with an undo log: while a transaction is open, every change adds a function that puts things
+  back. Nested transactions mark where they started in the log, so they can undo just their part, like a savepoint.
+
+NOTE: Nothing is ever written to disk; the data is gone when the database is destroyed.
+*/
+class InProcessDatabase {
+public:
+    // The undo log; Table and the change functions below add to it, and InProcessTransaction drives it
+    class UndoLog {
+    public:
+        bool isRecording() const {
+            return !marks.empty();
+        }
+
+        // Adds a function that undoes a change just made; ignored when no transaction is open
+        void add(std::function<void()> undo) {
+            if (isRecording()) {
+                entries.push_back(std::move(undo));
+            }
+        }
+
+        void begin() {
+            marks.push_back(entries.size());
+        }
+
+        // A nested transaction's changes stay in the log, for the outer one to keep or undo
+        void commit() {
+            marks.pop_back();
+            if (marks.empty()) {
+                entries.clear();
+            }
+        }
+
+        // Undoes the changes made since the innermost begin(), newest first
+        void rollback() {
+            size_t mark = marks.back();
+            while (entries.size() > mark) {
+                std::function<void()> undo = std::move(entries.back());
+                entries.pop_back();
+                undo();
+            }
+            marks.pop_back();
+        }
+
+    private:
+        std::vector<std::function<void()>> entries;
+        std::vector<size_t> marks; // Where each open transaction starts in entries, outermost first
+    };
+
+    // A table of rows keyed by an IDENTITY-like ID; changes go through insert, update and erase, so they can be undone
+    template<typename Row>
+    class Table {
+    public:
+        explicit Table(UndoLog& undoLog) : undoLog(undoLog), nextID(1) {}
+
+        size_t size() const {
+            return rows.size();
+        }
+
+        // The row with id, or null if there isn't one
+        Row* find(int id) {
+            typename std::unordered_map<int, Row>::iterator row = rows.find(id);
+            return row == rows.end() ? nullptr : &row->second;
+        }
+
+        // Calls function(id, row) for up to limit rows with an ID greater than afterID, in order, that match predicate
+        template<typename Predicate, typename Function>
+        void forEachAfter(int afterID, size_t limit, Predicate predicate, Function function) {
+            size_t count = 0;
+            for (std::vector<int>::iterator id = std::upper_bound(ids.begin(), ids.end(), afterID); id != ids.end() && count < limit; ++id) {
+                Row& row = rows.at(*id);
+                if (predicate(row)) {
+                    function(*id, row);
+                    count++;
+                }
+            }
+        }
+
+        // Calls function(id, row) for every row, in order
+        template<typename Function>
+        void forEach(Function function) {
+            forEachAfter(0, ids.size(), [](const Row&) { return true; }, function);
+        }
+
+        // Adds row with the next ID, and returns that ID
+        int insert(Row row) {
+            int id = nextID++;
+            put(id, std::move(row));
+            undoLog.add([this, id]() { remove(id); });
+            return id;
+        }
+
+        // The row with id, to be changed in place, or null if there isn't one; the row as it was is kept for a rollback
+        Row* update(int id) {
+            Row* row = find(id);
+            if (row != nullptr && undoLog.isRecording()) {
+                Row before = *row;
+                undoLog.add([this, id, before]() { rows[id] = before; });
+            }
+            return row;
+        }
+
+        // Deletes the row with id; returns false if there wasn't one
+        bool erase(int id) {
+            typename std::unordered_map<int, Row>::iterator row = rows.find(id);
+            if (row == rows.end()) {
+                return false;
+            }
+            if (undoLog.isRecording()) {
+                Row before = std::move(row->second);
+                undoLog.add([this, id, before]() { put(id, before); });
+            }
+            remove(id);
+            return true;
+        }
+
+    private:
+        UndoLog& undoLog;
+        std::unordered_map<int, Row> rows;
+        std::vector<int> ids; // Every ID in rows, in order
+        int nextID;
+
+        void put(int id, Row row) {
+            rows[id] = std::move(row);
+            if (ids.empty() || ids.back() < id) {
+                ids.push_back(id);
+            }
+            else {
+                ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+            }
+        }
+
+        void remove(int id) {
+            rows.erase(id);
+            std::vector<int>::iterator position = std::lower_bound(ids.begin(), ids.end(), id);
+            if (position != ids.end() && *position == id) {
+                ids.erase(position);
+            }
+        }
+    };
+
+    struct CustomerRow {
+        std::string fname;
+        std::string lname;
+        std::string email;
+        int points;
+    };
+
+    struct SupplierRow {
+        std::string s_name;
+        std::string description;
+        std::string email;
+        std::string address;
+    };
+
+    struct ProductRow {
+        int supplier_id;
+        std::string p_name;
+        std::string description;
+        float price;
+        int qty;
+    };
+
+    struct TransactionRow {
+        int customer_id; // 0 for NULL, once the customer is deleted
+        float total;
+        std::string order_date;
+    };
+
+    struct OrderItemRow {
+        int transaction_id;
+        int product_id; // 0 for NULL, once the product is deleted
+        int qty;
+    };
+
+    std::recursive_mutex mutex; // Guards everything below; see InProcessTransaction for holding it across calls
+    UndoLog undoLog;
+    Table<CustomerRow> customers;
+    Table<SupplierRow> suppliers;
+    Table<ProductRow> products;
+    Table<TransactionRow> transactions;
+    Table<OrderItemRow> orderItems;
+
+    InProcessDatabase()
+        : customers(undoLog),
+        suppliers(undoLog),
+        products(undoLog),
+        transactions(undoLog),
+        orderItems(undoLog) {}
+
+    InProcessDatabase(const InProcessDatabase&) = delete;
+    InProcessDatabase& operator=(const InProcessDatabase&) = delete;
+
+    // ********** Suppliers, with the name index **********
+
+    // The supplier named s_name, or 0 if there isn't one
+    int findSupplierByName(const std::string& s_name) const {
+        std::unordered_map<std::string, int>::const_iterator supplier = supplierIDsByName.find(s_name);
+        return supplier == supplierIDsByName.end() ? 0 : supplier->second;
+    }
+
+    int insertSupplier(SupplierRow row) {
+        std::string s_name = row.s_name;
+        int supplier_id = suppliers.insert(std::move(row));
+        setSupplierName(s_name, supplier_id);
+        return supplier_id;
+    }
+
+    void updateSupplierName(int supplier_id, const std::string& s_name) {
+        SupplierRow* supplier = suppliers.update(supplier_id);
+        if (supplier == nullptr) {
+            return;
+        }
+        setSupplierName(supplier->s_name, 0);
+        setSupplierName(s_name, supplier_id);
+        supplier->s_name = s_name;
+    }
+
+    bool eraseSupplier(int supplier_id) {
+        SupplierRow* supplier = suppliers.find(supplier_id);
+        if (supplier == nullptr) {
+            return false;
+        }
+        setSupplierName(supplier->s_name, 0);
+        return suppliers.erase(supplier_id);
+    }
+
+    // ********** Cart items, keyed by (customer_id, product_id) **********
+
+    // The customer's cart as product_id -> qty, or null if it's empty
+    const std::map<int, int>* findCart(int customer_id) const {
+        std::unordered_map<int, std::map<int, int>>::const_iterator cart = carts.find(customer_id);
+        return cart == carts.end() ? nullptr : &cart->second;
+    }
+
+    // Quantity of product_id in the customer's cart, or 0 if it isn't there
+    int findCartItemQty(int customer_id, int product_id) const {
+        const std::map<int, int>* cart = findCart(customer_id);
+        if (cart == nullptr) {
+            return 0;
+        }
+        std::map<int, int>::const_iterator item = cart->find(product_id);
+        return item == cart->end() ? 0 : item->second;
+    }
+
+    // Adds the product to the customer's cart, or changes its quantity if it's already there
+    void setCartItemQty(int customer_id, int product_id, int qty) {
+        int before = findCartItemQty(customer_id, product_id);
+        bool existed = hasCartItem(customer_id, product_id);
+        carts[customer_id][product_id] = qty;
+        undoLog.add([this, customer_id, product_id, before, existed]() {
+            if (existed) {
+                carts[customer_id][product_id] = before;
+            }
+            else {
+                removeCartItem(customer_id, product_id);
+            }
+        });
+    }
+
+    bool eraseCartItem(int customer_id, int product_id) {
+        if (!hasCartItem(customer_id, product_id)) {
+            return false;
+        }
+        int before = findCartItemQty(customer_id, product_id);
+        removeCartItem(customer_id, product_id);
+        undoLog.add([this, customer_id, product_id, before]() { carts[customer_id][product_id] = before; });
+        return true;
+    }
+
+    void eraseCart(int customer_id) {
+        const std::map<int, int>* cart = findCart(customer_id);
+        if (cart == nullptr) {
+            return;
+        }
+        std::map<int, int> before = *cart;
+        carts.erase(customer_id);
+        undoLog.add([this, customer_id, before]() { carts[customer_id] = before; });
+    }
+
+    // Removes every cart item whose product matches predicate; this one has to look at every cart
+    void eraseCartItemsWhere(std::function<bool(int product_id)> predicate) {
+        std::vector<std::pair<int, int>> matches;
+        for (std::unordered_map<int, std::map<int, int>>::iterator cart = carts.begin(); cart != carts.end(); ++cart) {
+            for (std::map<int, int>::iterator item = cart->second.begin(); item != cart->second.end(); ++item) {
+                if (predicate(item->first)) {
+                    matches.push_back(std::make_pair(cart->first, item->first));
+                }
+            }
+        }
+        for (size_t i = 0; i < matches.size(); i++) {
+            eraseCartItem(matches[i].first, matches[i].second);
+        }
+    }
+
+    // Whether any cart has the product in it
+    bool isProductInAnyCart(int product_id) const {
+        for (std::unordered_map<int, std::map<int, int>>::const_iterator cart = carts.begin(); cart != carts.end(); ++cart) {
+            if (cart->second.count(product_id) > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // ********** Order items, with the transaction index **********
+
+    int insertOrderItem(OrderItemRow row) {
+        int transaction_id = row.transaction_id;
+        int order_item_id = orderItems.insert(std::move(row));
+        orderItemIDsByTransaction[transaction_id].push_back(order_item_id);
+        undoLog.add([this, transaction_id]() {
+            std::vector<int>& ids = orderItemIDsByTransaction[transaction_id];
+            ids.pop_back();
+            if (ids.empty()) {
+                orderItemIDsByTransaction.erase(transaction_id);
+            }
+        });
+        return order_item_id;
+    }
+
+    // IDs of the transaction's order items, in the order they were made
+    std::vector<int> findOrderItemIDs(int transaction_id) const {
+        std::unordered_map<int, std::vector<int>>::const_iterator ids = orderItemIDsByTransaction.find(transaction_id);
+        return ids == orderItemIDsByTransaction.end() ? std::vector<int>() : ids->second;
+    }
+
+    // ********** Helpers **********
+
+    // Rounds to cents, like the DECIMAL(8, 2) price and total columns
+    static float toMoney(double amount) {
+        return static_cast<float>(std::round(amount * 100.0) / 100.0);
+    }
+
+    // Today's date in yyyy-mm-dd form, like the DATE column (and DBConn::getCurrentDate)
+    static std::string currentDate() {
+        time_t now = time(nullptr);
+        struct tm localTime;
+#ifdef _WIN32
+        localtime_s(&localTime, &now);
+#else
+        localtime_r(&now, &localTime);
+#endif
+        char buffer[20];
+        strftime(buffer, sizeof(buffer), "%Y-%m-%d", &localTime);
+        return std::string(buffer);
+    }
+
+private:
+    std::unordered_map<std::string, int> supplierIDsByName;
+    std::unordered_map<int, std::map<int, int>> carts; // customer_id -> (product_id -> qty); no entry for an empty cart
+    std::unordered_map<int, std::vector<int>> orderItemIDsByTransaction;
+
+    // Points s_name at supplier_id in the name index, or drops it for 0
+    void setSupplierName(const std::string& s_name, int supplier_id) {
+        int before = findSupplierByName(s_name);
+        if (supplier_id == 0) {
+            supplierIDsByName.erase(s_name);
+        }
+        else {
+            supplierIDsByName[s_name] = supplier_id;
+        }
+        undoLog.add([this, s_name, before]() {
+            if (before == 0) {
+                supplierIDsByName.erase(s_name);
+            }
+            else {
+                supplierIDsByName[s_name] = before;
+            }
+        });
+    }
+
+    bool hasCartItem(int customer_id, int product_id) const {
+        const std::map<int, int>* cart = findCart(customer_id);
+        return cart != nullptr && cart->count(product_id) > 0;
+    }
+
+    void removeCartItem(int customer_id, int product_id) {
+        std::unordered_map<int, std::map<int, int>>::iterator cart = carts.find(customer_id);
+        if (cart == carts.end()) {
+            return;
+        }
+        cart->second.erase(product_id);
+        if (cart->second.empty()) {
+            carts.erase(cart);
+        }
+    }
+};
+
+
+/*
++ InProcessTransaction: A transaction on an InProcessDatabase. It holds the database's mutex until it's committed or
+    destroyed, and is rolled back if it's destroyed first. Nested ones (on the same thread) undo only their own part.
+*/
+class InProcessTransaction {
+public:
+    explicit InProcessTransaction(InProcessDatabase& database) : lock(database.mutex), database(database), isDone(false) {
+        database.undoLog.begin();
+    }
+
+    InProcessTransaction(const InProcessTransaction&) = delete;
+    InProcessTransaction& operator=(const InProcessTransaction&) = delete;
+
+    ~InProcessTransaction() {
+        if (!isDone) {
+            database.undoLog.rollback();
+        }
+    }
+
+    void commit() {
+        if (isDone) {
+            throw std::runtime_error("Transaction was already committed or rolled back!");
+        }
+        isDone = true;
+        database.undoLog.commit();
+    }
+
+private:
+    std::unique_lock<std::recursive_mutex> lock; // First, so it's released last
+    InProcessDatabase& database;
+    bool isDone;
+};
+
+#endif
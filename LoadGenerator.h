@@ -0,0 +1,504 @@
+#ifndef LoadGenerator_H
+#define LoadGenerator_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <exception>
+#include <ostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+#include "StorageBackend.h"
+#include "QueryMetrics.h"
+#include "SeededRandom.h"
+
+/*
++ LoadGenerator: Runs a crowd of shoppers against a backend at once, to see how the checkout path holds up under
+    a sale: how many actions a second it takes, how slow it gets, and whether stock stays right.
+
+        LoadGenerator::Config config;
+        config.shoppers = 64;
+        config.actionsPerSecond = 2000;
+        config.seconds = 30;
+        LoadGenerator generator(backend, config);
+        LoadGenerator::Results results = generator.run(std::cout);
+        LoadGenerator::printReport(results, std::cout);
+
+- run seeds the (empty) tables first: a customer per shopper, and products products with stock units each. Stock
+  is low enough by default that the popular products sell out partway through, so shoppers race for the last units.
+- Each shopper is a thread with its own session, like RetailApp's currentCustomerID: who they are and what they
+  think is in their cart. They go through visits: browse (pages of products and single products), add one or more
+  products to the cart, sometimes change or remove one, and then check out or leave the cart for the next visit.
+  Which products they look at and buy is Zipf-skewed (productSkew), so everyone fights over the same few rows.
+- When checkout says a product is out of stock, the shopper takes it out of their cart and checks out again.
+- actionsPerSecond is the target for all the shoppers together. Each action has a time it's due, and its latency
+  is counted from then, not from when it actually started, so a backend that falls behind shows up in the
+  percentiles instead of just slowing the shoppers down (coordinated omission). 0 runs every shopper flat out.
+- A call that loses a deadlock (see StorageBackend::wasDeadlockVictim) is retried up to maxRetries times, after a
+  short random wait; anything else that throws counts as a failed action.
+- After the run, every product's stock is checked against what was sold (the order items): oversold is more sold
+  than there was, and mismatched is stock that didn't go down by what was sold.
+
+NOTE: With SQL Server, the pool needs a connection per shopper, or shoppers wait on each other in acquire().
+NOTE: Shoppers use their own random streams (see SeededRandom), but which of them gets the last unit of something
+    depends on timing, so two runs with the same seed won't come out exactly the same.
+*/
+class LoadGenerator {
+public:
+    struct Config {
+        uint64_t seed = 1;
+        int shoppers = 16;
+        double actionsPerSecond = 0; // For all the shoppers together; 0 is as fast as they can go
+        double seconds = 10;
+        int products = 1000;
+        int stock = 200;             // Each product's starting stock
+        double productSkew = 1.0;    // Zipf exponent; 0 is uniform, and the bigger it is the more the top few dominate
+        int pageSize = 20;
+        double browsesPerVisit = 4;  // On average, and at least one
+        int maxItemsPerVisit = 3;    // Products added to the cart per visit, 1 to this many
+        double updateChance = 0.3;   // Chance of changing or removing something in the cart before deciding
+        double checkoutChance = 0.6; // Chance a visit ends in a checkout; the rest leave their cart for next time
+        int maxRetries = 3;          // Times a deadlock victim is retried before it counts as failed
+    };
+
+    enum class Action { Browse = 0, AddToCart, UpdateCart, Checkout };
+    static const int ACTION_COUNT = 4;
+    static const int STATUS_COUNT = 5; // CheckoutStore::Status values
+
+    struct ActionStats {
+        unsigned long long count = 0;  // Every one that ran, failed or not
+        unsigned long long failed = 0; // Threw something that wasn't retried, or still lost a deadlock after maxRetries
+        LatencyHistogram latency;      // Nanoseconds from when it was due until it finished, retries included
+
+        void merge(const ActionStats& other) {
+            count += other.count;
+            failed += other.failed;
+            latency.merge(other.latency);
+        }
+    };
+
+    struct Results {
+        double seconds = 0;
+        ActionStats actions[ACTION_COUNT];
+        unsigned long long checkouts[STATUS_COUNT] = {}; // By status
+        unsigned long long deadlocks = 0;   // Calls that lost a deadlock, retried or not
+        unsigned long long retries = 0;
+        unsigned long long lateActions = 0; // Started more than one action's time after they were due
+        std::string firstError;             // What the first failed action threw
+
+        long long unitsSold = 0;
+        int oversoldProducts = 0;
+        long long oversoldUnits = 0;
+        int mismatchedProducts = 0;
+
+        unsigned long long totalActions() const {
+            unsigned long long total = 0;
+            for (int i = 0; i < ACTION_COUNT; i++) {
+                total += actions[i].count;
+            }
+            return total;
+        }
+
+        // Adds another shopper's counts to these; the stock check is only done once, on the merged results
+        void merge(const Results& other) {
+            for (int i = 0; i < ACTION_COUNT; i++) {
+                actions[i].merge(other.actions[i]);
+            }
+            for (int i = 0; i < STATUS_COUNT; i++) {
+                checkouts[i] += other.checkouts[i];
+            }
+            deadlocks += other.deadlocks;
+            retries += other.retries;
+            lateActions += other.lateActions;
+            if (firstError.empty()) {
+                firstError = other.firstError;
+            }
+        }
+
+        bool stockIsRight() const {
+            return oversoldProducts == 0 && mismatchedProducts == 0;
+        }
+    };
+
+    LoadGenerator(StorageBackend& backend, Config config)
+        : backend(backend),
+        customerStore(backend.getCustomerStore()),
+        supplierStore(backend.getSupplierStore()),
+        productStore(backend.getProductStore()),
+        cartItemStore(backend.getCartItemStore()),
+        orderItemStore(backend.getOrderItemStore()),
+        checkoutStore(backend.getCheckoutStore()),
+        config(config),
+        actionsDone(0) {}
+
+    LoadGenerator(const LoadGenerator&) = delete;
+    LoadGenerator& operator=(const LoadGenerator&) = delete;
+
+    // Seeds the tables, runs the shoppers for config.seconds (printing how far along it is to progress), and checks the stock
+    Results run(std::ostream& progress) {
+        validateConfig();
+        progress << "Seeding " << config.shoppers << " customers and " << config.products << " products..." << std::endl;
+        seed();
+
+        progress << "Running " << config.shoppers << " shoppers for " << config.seconds << "s" << std::endl;
+        typedef std::chrono::steady_clock Clock;
+        const Clock::time_point start = Clock::now();
+        const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.seconds));
+        std::vector<Results> shopperResults(static_cast<size_t>(config.shoppers));
+        std::exception_ptr failure;
+        std::mutex mutex;
+        std::vector<std::thread> shoppers;
+        for (int s = 0; s < config.shoppers; s++) {
+            shoppers.push_back(std::thread([this, s, start, end, &shopperResults, &failure, &mutex]() {
+                try {
+                    runShopper(s, start, end, shopperResults[static_cast<size_t>(s)]);
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                }
+            }));
+        }
+
+        // Every 10% of the way through, say how many actions a second the shoppers got through since last time
+        unsigned long long lastActions = 0;
+        Clock::time_point lastReport = start;
+        for (int step = 1; step <= 10; step++) {
+            std::this_thread::sleep_until(start + (end - start) * step / 10);
+            Clock::time_point now = Clock::now();
+            unsigned long long actions = actionsDone.load();
+            double seconds = std::chrono::duration<double>(now - lastReport).count();
+            progress << "  " << step * 10 << "%: " << actions << " actions (" << std::fixed << std::setprecision(0)
+                << (actions - lastActions) / std::max(seconds, 0.001) << "/s)" << std::defaultfloat << std::endl;
+            lastActions = actions;
+            lastReport = now;
+        }
+        for (size_t i = 0; i < shoppers.size(); i++) {
+            shoppers[i].join();
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+
+        Results results;
+        results.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        for (size_t i = 0; i < shopperResults.size(); i++) {
+            results.merge(shopperResults[i]);
+        }
+        checkStock(results);
+        return results;
+    }
+
+    static const char* actionName(Action action) {
+        switch (action) {
+        case Action::Browse: return "browse";
+        case Action::AddToCart: return "add to cart";
+        case Action::UpdateCart: return "update cart";
+        case Action::Checkout: return "checkout";
+        }
+        return "unknown";
+    }
+
+    static void printReport(const Results& results, std::ostream& out) {
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        const unsigned long long orders = results.checkouts[static_cast<int>(CheckoutStore::Status::Success)];
+        out << std::fixed << std::setprecision(1) << "<Load test seconds(" << results.seconds << ")>" << std::endl;
+        out << "  actions(" << results.totalActions() << "), actions/s(" << results.totalActions() / results.seconds
+            << "), orders(" << orders << "), orders/s(" << orders / results.seconds << ")" << std::endl;
+        for (int i = 0; i < ACTION_COUNT; i++) {
+            const ActionStats& stats = results.actions[i];
+            out << "  " << std::left << std::setw(12) << actionName(static_cast<Action>(i)) << std::right << std::setprecision(3)
+                << " count(" << stats.count << "), failed(" << stats.failed << "), p50(" << stats.latency.percentile(50) / 1000000.0
+                << "ms), p99(" << stats.latency.percentile(99) / 1000000.0 << "ms), p999(" << stats.latency.percentile(99.9) / 1000000.0
+                << "ms)" << std::endl;
+        }
+        out << "  Checkouts: succeeded(" << orders
+            << "), out of stock(" << results.checkouts[static_cast<int>(CheckoutStore::Status::InsufficientStock)]
+            << "), empty cart(" << results.checkouts[static_cast<int>(CheckoutStore::Status::EmptyCart)]
+            << "), other(" << results.checkouts[static_cast<int>(CheckoutStore::Status::InsufficientPoints)]
+                + results.checkouts[static_cast<int>(CheckoutStore::Status::CustomerNotFound)] << ")" << std::endl;
+        out << "  Contention: deadlocks(" << results.deadlocks << "), retries(" << results.retries
+            << "), late actions(" << results.lateActions << ")" << std::endl;
+        out << "  Stock: units sold(" << results.unitsSold << "), oversold products(" << results.oversoldProducts
+            << "), oversold units(" << results.oversoldUnits << "), mismatched products(" << results.mismatchedProducts << ")" << std::endl;
+        if (!results.firstError.empty()) {
+            out << "  First error: " << results.firstError << std::endl;
+        }
+        out << "</Load test>" << std::endl;
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+private:
+    // A shopper's state between actions
+    struct Session {
+        int customer_id;
+        SeededRandom random;
+        std::vector<int> cart;  // Products the shopper put in their cart
+        int soldOutProductID;   // The product checkout last said was out of stock, for the next cart update to remove
+        std::deque<Action> plan; // What's left of this visit
+
+        Session(int customer_id, uint64_t seed) : customer_id(customer_id), random(seed), soldOutProductID(0) {}
+    };
+
+    StorageBackend& backend;
+    CustomerStore& customerStore;
+    SupplierStore& supplierStore;
+    ProductStore& productStore;
+    CartItemStore& cartItemStore;
+    OrderItemStore& orderItemStore;
+    CheckoutStore& checkoutStore;
+    Config config;
+
+    std::vector<int> customerIDs;      // One per shopper
+    std::vector<int> productIDs;       // In id order, for paging
+    std::vector<int> productsByRank;   // Most popular first; productPopularity picks a rank
+    ZipfDistribution productPopularity;
+    std::atomic<unsigned long long> actionsDone;
+
+    void validateConfig() const {
+        if (config.shoppers < 1 || config.products < 1 || config.seconds <= 0) {
+            throw std::runtime_error("The load generator needs at least one shopper and one product, and some time to run!");
+        }
+        if (config.stock < 0 || config.pageSize < 1 || config.browsesPerVisit < 1 || config.maxItemsPerVisit < 1 || config.maxRetries < 0) {
+            throw std::runtime_error("The load generator's stock, page size, browses, items per visit and retries can't be that low!");
+        }
+    }
+
+    void seed() {
+        uint64_t setupSeed = SeededRandom::mix(config.seed, 0);
+        SeededRandom random(setupSeed);
+
+        std::string s_name = "Load Test Supplier";
+        std::string description = "Supplies the load test";
+        std::string email = "supplier@example.com";
+        std::string address = "1 Load Test Street";
+        int supplier_id = supplierStore.createSupplier(s_name, description, email, address).getSupplierID();
+
+        std::vector<std::tuple<std::string, std::string, std::string, int>> customerRows;
+        for (int i = 0; i < config.shoppers; i++) {
+            customerRows.push_back(std::make_tuple("Shopper", std::to_string(i), "shopper" + std::to_string(i) + "@example.com", 0));
+        }
+        std::vector<Customer> customers = customerStore.batchCreateCustomer(customerRows);
+        for (size_t i = 0; i < customers.size(); i++) {
+            customerIDs.push_back(customers[i].getCustomerID());
+        }
+
+        std::vector<std::tuple<int, std::string, std::string, float, int>> productRows;
+        for (int i = 0; i < config.products; i++) {
+            productRows.push_back(std::make_tuple(supplier_id, "Product " + std::to_string(i), "Load test product " + std::to_string(i),
+                static_cast<float>(random.nextInt(100, 10000)) / 100.0f, config.stock));
+        }
+        std::vector<Product> products = productStore.batchCreateProduct(productRows);
+        for (size_t i = 0; i < products.size(); i++) {
+            productIDs.push_back(products[i].getProductID());
+        }
+        std::sort(productIDs.begin(), productIDs.end());
+
+        // The most popular products are spread over the id range, so paging doesn't always start near them
+        productsByRank = productIDs;
+        random.shuffle(productsByRank);
+        productPopularity = ZipfDistribution(productsByRank.size(), config.productSkew);
+    }
+
+    void runShopper(int shopper, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, Results& results) {
+        typedef std::chrono::steady_clock Clock;
+        Session session(customerIDs[static_cast<size_t>(shopper)], SeededRandom::mix(config.seed, 1, static_cast<uint64_t>(shopper)));
+
+        // Each shopper gets an even share of the target rate, and they start staggered so they don't all go at once
+        Clock::duration pace = Clock::duration::zero();
+        if (config.actionsPerSecond > 0) {
+            pace = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config.shoppers / config.actionsPerSecond));
+        }
+        Clock::time_point due = start + pace * shopper / config.shoppers;
+
+        while (true) {
+            if (pace == Clock::duration::zero()) {
+                due = Clock::now();
+            }
+            if (due >= end) {
+                break;
+            }
+            if (pace != Clock::duration::zero()) {
+                std::this_thread::sleep_until(due);
+                if (Clock::now() - due > pace) {
+                    results.lateActions++;
+                }
+            }
+
+            if (session.plan.empty()) {
+                planVisit(session);
+            }
+            Action action = session.plan.front();
+            session.plan.pop_front();
+            if (action == Action::UpdateCart && session.cart.empty()) {
+                action = Action::Browse; // Nothing to update, so they look around some more instead
+            }
+
+            bool succeeded = perform(session, action, results);
+            ActionStats& stats = results.actions[static_cast<int>(action)];
+            stats.count++;
+            if (!succeeded) {
+                stats.failed++;
+            }
+            stats.latency.add(static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - due).count()));
+            actionsDone++;
+            due += pace;
+        }
+    }
+
+    // Lines up the actions for the shopper's next visit
+    void planVisit(Session& session) {
+        int browses = 1 + session.random.nextGeometric(1.0 / config.browsesPerVisit);
+        for (int i = 0; i < browses; i++) {
+            session.plan.push_back(Action::Browse);
+        }
+        int items = session.random.nextInt(1, config.maxItemsPerVisit);
+        for (int i = 0; i < items; i++) {
+            session.plan.push_back(Action::AddToCart);
+        }
+        if (session.random.nextBool(config.updateChance)) {
+            session.plan.push_back(Action::UpdateCart);
+        }
+        if (session.random.nextBool(config.checkoutChance)) {
+            session.plan.push_back(Action::Checkout);
+        }
+    }
+
+    int popularProduct(Session& session) const {
+        return productsByRank[productPopularity(session.random)];
+    }
+
+    // Does one action for the shopper; returns false if it failed
+    bool perform(Session& session, Action action, Results& results) {
+        switch (action) {
+        case Action::Browse:
+            if (session.random.nextBool(0.5)) {
+                int afterID = session.random.pick(productIDs) - 1;
+                return withRetries(session, results, [&]() { productStore.getProductPage(afterID, config.pageSize, true); });
+            }
+            else {
+                int product_id = popularProduct(session);
+                return withRetries(session, results, [&]() { productStore.getProductByID(product_id); });
+            }
+
+        case Action::AddToCart: {
+            int product_id = popularProduct(session);
+            if (!withRetries(session, results, [&]() { cartItemStore.incrementCartItemQty(session.customer_id, product_id, 1); })) {
+                return false;
+            }
+            if (std::find(session.cart.begin(), session.cart.end(), product_id) == session.cart.end()) {
+                session.cart.push_back(product_id);
+            }
+            return true;
+        }
+
+        case Action::UpdateCart: {
+            // Take out what checkout said is sold out, or else change (or sometimes remove) something at random
+            std::vector<int>::iterator item = std::find(session.cart.begin(), session.cart.end(), session.soldOutProductID);
+            session.soldOutProductID = 0;
+            if (item == session.cart.end()) {
+                item = session.cart.begin() + session.random.nextInt(0, static_cast<int>(session.cart.size()) - 1);
+                if (!session.random.nextBool(0.25)) {
+                    int product_id = *item;
+                    int qty = session.random.nextInt(1, 3);
+                    return withRetries(session, results, [&]() { cartItemStore.setCartItemQty(session.customer_id, product_id, qty); });
+                }
+            }
+            int product_id = *item;
+            if (!withRetries(session, results, [&]() { cartItemStore.deleteCartItem(session.customer_id, product_id); })) {
+                return false;
+            }
+            session.cart.erase(item);
+            return true;
+        }
+
+        case Action::Checkout: {
+            CheckoutStore::CheckoutResult result;
+            if (!withRetries(session, results, [&]() { result = checkoutStore.checkout(session.customer_id, 0); })) {
+                return false;
+            }
+            int status = static_cast<int>(result.status);
+            if (status >= 0 && status < STATUS_COUNT) {
+                results.checkouts[status]++;
+            }
+            if (result.status == CheckoutStore::Status::Success) {
+                session.cart.clear();
+            }
+            else if (result.status == CheckoutStore::Status::InsufficientStock) {
+                // Like a real shopper: take it out of the cart and try again
+                session.soldOutProductID = result.productID;
+                session.plan.push_front(Action::Checkout);
+                session.plan.push_front(Action::UpdateCart);
+            }
+            return true;
+        }
+        }
+        return false;
+    }
+
+    // Runs call, again after a short random wait each time it loses a deadlock (up to maxRetries times); returns false if it failed
+    template<typename Call>
+    bool withRetries(Session& session, Results& results, Call call) {
+        for (int attempt = 0; ; attempt++) {
+            // Otherwise a deadlock from an earlier call on a held connection would make this one look like a victim too
+            backend.clearLastError();
+            try {
+                call();
+                return true;
+            }
+            catch (const std::exception& ex) {
+                if (backend.wasDeadlockVictim()) {
+                    results.deadlocks++;
+                    if (attempt < config.maxRetries) {
+                        results.retries++;
+                        std::this_thread::sleep_for(std::chrono::milliseconds(session.random.nextInt(1, 10 << attempt)));
+                        continue;
+                    }
+                }
+                if (results.firstError.empty()) {
+                    results.firstError = ex.what();
+                }
+                return false;
+            }
+        }
+    }
+
+    // Checks every product's stock against what the order items say was sold
+    void checkStock(Results& results) {
+        std::map<int, long long> sold;
+        for (OrderItem& orderItem : orderItemStore.streamAll()) {
+            sold[orderItem.getProductID()] += orderItem.getQty();
+        }
+        std::map<int, int> quantities;
+        for (Product& product : productStore.streamAll()) {
+            quantities[product.getProductID()] = product.getQuantity();
+        }
+
+        for (size_t i = 0; i < productIDs.size(); i++) {
+            long long unitsSold = sold[productIDs[i]];
+            results.unitsSold += unitsSold;
+            if (unitsSold > config.stock) {
+                results.oversoldProducts++;
+                results.oversoldUnits += unitsSold - config.stock;
+            }
+            if (quantities[productIDs[i]] != config.stock - unitsSold) {
+                results.mismatchedProducts++;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef OdbcBackend_H
+#define OdbcBackend_H
+
+#include <memory>
+#include <utility>
+
+#include "StorageBackend.h"
+#include "ConnectionPool.h"
+#include "TransactionScope.h"
+#include "QueryBatch.h"
+#include "CustomerManager.h"
+#include "SupplierManager.h"
+#include "ProductManager.h"
+#include "CartItemManager.h"
+#include "TransactionManager.h"
+#include "OrderItemManager.h"
+#include "CheckoutManager.h"
+
+/*
++ OdbcBackend: The SQL Server StorageBackend. The managers are its stores, transactions are TransactionScopes, and
+    read batches are QueryBatches.
+
+        OdbcBackend backend(connectionPool, customerManager, supplierManager, productManager, cartItemManager,
+            transactionManager, orderItemManager, checkoutManager);
+        RetailApp myStore(backend);
+
+NOTE: The backend doesn't own the managers or the pool; set them up (initTable, enableCache, ...) like before, and
+    keep them alive for as long as the backend.
+*/
+class OdbcBackend : public StorageBackend {
+public:
+    OdbcBackend(
+        ConnectionPool& connectionPool,
+        CustomerManager& customerManager,
+        SupplierManager& supplierManager,
+        ProductManager& productManager,
+        CartItemManager& cartItemManager,
+        TransactionManager& transactionManager,
+        OrderItemManager& orderItemManager,
+        CheckoutManager& checkoutManager
+    ) : connectionPool(connectionPool),
+        customerManager(customerManager),
+        supplierManager(supplierManager),
+        productManager(productManager),
+        cartItemManager(cartItemManager),
+        transactionManager(transactionManager),
+        orderItemManager(orderItemManager),
+        checkoutManager(checkoutManager) {}
+
+    CustomerStore& getCustomerStore() override {
+        return customerManager;
+    }
+
+    SupplierStore& getSupplierStore() override {
+        return supplierManager;
+    }
+
+    ProductStore& getProductStore() override {
+        return productManager;
+    }
+
+    CartItemStore& getCartItemStore() override {
+        return cartItemManager;
+    }
+
+    TransactionStore& getTransactionStore() override {
+        return transactionManager;
+    }
+
+    OrderItemStore& getOrderItemStore() override {
+        return orderItemManager;
+    }
+
+    CheckoutStore& getCheckoutStore() override {
+        return checkoutManager;
+    }
+
+    std::unique_ptr<StorageTransaction> beginTransaction() override {
+        return std::unique_ptr<StorageTransaction>(new OdbcTransaction(connectionPool));
+    }
+
+    std::unique_ptr<ReadBatch> newReadBatch() override {
+        return std::unique_ptr<ReadBatch>(new QueryBatch(connectionPool));
+    }
+
+    bool wasDeadlockVictim() override {
+        return DBConn::lastErrorNumber() == DBConn::DEADLOCK_VICTIM_ERROR;
+    }
+
+    // acquire() only clears it for a new lease, which an attempt inside a held connection or transaction doesn't get
+    void clearLastError() override {
+        DBConn::lastErrorNumber() = 0;
+    }
+
+    std::unique_ptr<ConnectionHold> holdConnection() override {
+        return std::unique_ptr<ConnectionHold>(new OdbcConnectionHold(connectionPool.acquire()));
+    }
+
+    ConnectionPool& getConnectionPool() {
+        return connectionPool;
+    }
+
+private:
+    // A lease behind the ConnectionHold interface; the managers on this thread share it, since leases are re-entrant
+    class OdbcConnectionHold : public ConnectionHold {
+    public:
+        explicit OdbcConnectionHold(DBConnLease dbConn) : dbConn(std::move(dbConn)) {}
+
+    private:
+        DBConnLease dbConn;
+    };
+
+    // A TransactionScope behind the StorageTransaction interface
+    class OdbcTransaction : public StorageTransaction {
+    public:
+        explicit OdbcTransaction(ConnectionPool& connectionPool) : scope(connectionPool) {}
+
+        void commit() override {
+            scope.commit();
+        }
+
+    private:
+        TransactionScope scope;
+    };
+
+    ConnectionPool& connectionPool;
+    CustomerManager& customerManager;
+    SupplierManager& supplierManager;
+    ProductManager& productManager;
+    CartItemManager& cartItemManager;
+    TransactionManager& transactionManager;
+    OrderItemManager& orderItemManager;
+    CheckoutManager& checkoutManager;
+};
+
+#endif
@@ -31,6 +31,10 @@ public:
 		return product_id;
 	}
 
+	int getQty() {
+		return qty;
+	}
+
 	
 	friend std::ostream& operator<<(std::ostream& os, const OrderItem& orderItem) {
 		os << "<Order Item ID: " << orderItem.order_item_id << ", transaction_id: " << orderItem.transaction_id << ", product_id: " << orderItem.product_id << ", qty:" << orderItem.qty << "/>";
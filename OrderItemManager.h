@@ -4,39 +4,44 @@
 #include <vector>
 #include <tuple>
 
-#include "DBConn.h"
+#include "ConnectionPool.h"
+#include "WorkloadRecorder.h"
+#include "RowMapper.h"
+#include "QueryBatch.h"
+#include "StorageBackend.h"
 #include "OrderItem.h"
 
 
-class OrderItemManager {
+// The SQL Server OrderItemStore (see StorageBackend.h)
+class OrderItemManager : public OrderItemStore {
 private:
-	DBConn& dbConn;
+	ConnectionPool& connectionPool;
 	std::string tableName;
 	std::string transactionTableName;
 	std::string productTableName;
 
-	OrderItem createOrderItemFromRow(SQLINTEGER order_item_id, SQLINTEGER transaction_id, SQLINTEGER product_id, SQLINTEGER qty) {
-		int intOrderItemID = static_cast<int>(order_item_id);
-		int intTransactionID = static_cast<int>(transaction_id);
-		int intProductID = static_cast<int>(product_id);
-		int intQty = static_cast<int>(qty);
+	/*
+	- Columns of the order items table, in order: order_item_id, transaction_id, product_id, qty
 
-		OrderItem orderItem(intOrderItemID, intTransactionID, intProductID, intQty);
-		return orderItem;
-	}
+	NOTE: product_id is nullified when its product is deleted, so it's read with a NULL indicator (and comes back as 0).
+		Without the indicator we'd be feeding a NULL into an integer, which causes the problems explained in RowMapper.h.
+	*/
+	typedef RowMapper<OrderItem, IntColumn, IntColumn, NullableIntColumn, IntColumn> OrderItemRowMapper;
 
 public:
 	OrderItemManager(
-		DBConn& dbConn,
+		ConnectionPool& connectionPool,
 		std::string tableName,
 		std::string transactionTableName,
 		std::string productTableName
-	) : dbConn(dbConn),
+	) : connectionPool(connectionPool),
 		tableName(tableName),
 		transactionTableName(transactionTableName),
 		productTableName(productTableName) {}
 
 	void initTable() {
+		QueryCaller queryCaller("OrderItemManager::initTable");
+		DBConnLease dbConn = connectionPool.acquire();
 		std::string query = "CREATE TABLE " + tableName + " ( "
 			"order_item_id INT NOT NULL IDENTITY PRIMARY KEY, "
 			"transaction_id INT NOT NULL, "
@@ -45,61 +50,19 @@ public:
 			"FOREIGN KEY (transaction_id) REFERENCES " + transactionTableName + " (transaction_id), "
 			"FOREIGN KEY (product_id) REFERENCES " + productTableName + " (product_id)"
 			");";
-		if (!dbConn.executeSQL(query)) {
+		if (!dbConn->executeSQL(query)) {
 			throw std::runtime_error("Failed to initialize '" + tableName + "' table!");
 		}
 	}
 
 	std::vector<OrderItem> fetchOrderItems(std::string query) {
-		std::vector<OrderItem> orderItems;
+		DBConnLease dbConn = connectionPool.acquire();
 
 		// Execute query to fetch order items
-		if (!dbConn.executeSQL(query)) {
+		if (!dbConn->executeSQL(query)) {
 			throw std::runtime_error("Failed to query order items!");
 		}
-
-		// Create buffers to get the row data
-		SQLINTEGER order_item_id = 0;
-		SQLINTEGER transaction_id = 0;
-
-		/*
-		- product_id can be null, so let's ensure we handle binding the column properly in that case by using an indicator. By doing this we check if the column is null, if it 
-		is, then we don't feed product_id the data from that column because we don't want to feed an integer a null value. This would cause problems with how we feed data which 
-		is explained in our TransactionManager.
-		
-		
-		*/
-		SQLINTEGER product_id = 0;
-		SQLLEN product_id_indicator = 0;
-
-		SQLINTEGER qty = 0;
-
-		// Bind columns so that the buffers get the data when we do dbConn.fetchRow()
-		dbConn.bindColumn(1, SQL_INTEGER, &order_item_id, sizeof(order_item_id));
-		dbConn.bindColumn(2, SQL_INTEGER, &transaction_id, sizeof(transaction_id));
-		dbConn.bindColumn(3, SQL_INTEGER, &product_id, sizeof(product_id), &product_id_indicator);
-		dbConn.bindColumn(4, SQL_INTEGER, &qty, sizeof(qty));
-
-		while (true) {
-			SQLRETURN retcode = dbConn.fetchRow();
-
-			// If no more rows to be fetched, exit the loop
-			if (retcode == SQL_NO_DATA) {
-				break;
-			} else if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO && product_id != 0) {
-				dbConn.closeCursor(); // ensure we close cursor before throwing an error 
-				throw std::runtime_error("Failed to fetch a given customer!");
-			}
-
-			// Create product object using row data
-			OrderItem orderItem = createOrderItemFromRow(order_item_id, transaction_id, product_id, qty);
-
-			// Put product object into array
-			orderItems.push_back(orderItem);
-		}
-
-		dbConn.closeCursor();
-		return orderItems;
+		return OrderItemRowMapper::read(*dbConn, "Failed to fetch a given order item!");
 	}
 
 
@@ -107,14 +70,17 @@ public:
 	/*
 	- Create an order item for an existing transaction row.
 	*/
-	OrderItem createOrderItem(int transaction_id, int product_id, int qty) {
-		std::string query = "INSERT INTO " + tableName + " (transaction_id, product_id, qty) VALUES(" + std::to_string(transaction_id) + "," + std::to_string(product_id) + "," + std::to_string(qty) + ");";
+	OrderItem createOrderItem(int transaction_id, int product_id, int qty) override {
+		QueryCaller queryCaller("OrderItemManager::createOrderItem");
+		WorkloadCall workloadCall(queryCaller, transaction_id, product_id, qty);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "INSERT INTO " + tableName + " (transaction_id, product_id, qty) OUTPUT INSERTED.order_item_id VALUES (?, ?, ?);";
 		
-		if (!dbConn.executeSQL(query)) {
+		int order_item_id = 0;
+		if (!dbConn->executeInsert(query, { transaction_id, product_id, qty }, order_item_id)) {
 			throw std::runtime_error("Failed to insert order item!");
 		}
 
-		int order_item_id = dbConn.getLastInsertedID();
 		OrderItem orderItem(order_item_id, transaction_id, product_id, qty);
 
 		return orderItem;
@@ -122,53 +88,81 @@ public:
 
 
 	// Gets all order items for a specific transaction
-	std::vector<OrderItem> getOrderItems(int transaction_id) {
+	std::vector<OrderItem> getOrderItems(int transaction_id) override {
+		QueryCaller queryCaller("OrderItemManager::getOrderItems");
+		WorkloadCall workloadCall(queryCaller, transaction_id);
 		std::string query = "SELECT * FROM " + tableName + " WHERE transaction_id=" + std::to_string(transaction_id) + ";";
 		return fetchOrderItems(query);
 	}
 
+	// Streams every order item in the table, one at a time, for reports over all orders (see RowStream)
+	RowStream<OrderItem> streamAll() override {
+		QueryCaller queryCaller("OrderItemManager::streamAll");
+		DBConnLease dbConn = connectionPool.acquire();
+		if (!dbConn->executeSQL("SELECT * FROM " + tableName + ";")) {
+			throw std::runtime_error("Failed to query order items!");
+		}
+		return OrderItemRowMapper::stream(std::move(dbConn), "Failed to fetch a given order item!");
+	}
+
+	// Adds the query for a transaction's order items to batch; orderItems gets them once the batch is executed
+	void batchGetOrderItems(ReadBatch& batch, int transaction_id, std::vector<OrderItem>& orderItems) override {
+		std::string query = "SELECT * FROM " + tableName + " WHERE transaction_id=?;";
+		QueryBatch::from(batch).add(query, { transaction_id }, [&orderItems](DBConn& dbConn) {
+			orderItems = OrderItemRowMapper::read(dbConn, "Failed to fetch a given order item!");
+		});
+	}
+
 
 	/*
 	+ Handles creating/inserting multiple order item rows.
+
+	NOTE: The rows are sent as parameter arrays for one prepared INSERT (see DBConn::executeBulk), so the statement 
+		is the same no matter how many items are in the order, and orders with over 1000 items work too.
 	*/
-	void batchCreateOrderItem(std::vector<std::tuple<int, int, int>> orderItems) {
+	void batchCreateOrderItem(std::vector<std::tuple<int, int, int>> orderItems) override {
+		QueryCaller queryCaller("OrderItemManager::batchCreateOrderItem");
+		DBConnLease dbConn = connectionPool.acquire();
 		if (orderItems.empty()) {
 			return; // No items to insert
 		}
 
-		// Build the query string with multiple INSERT statements
-		std::string query = "INSERT INTO " + tableName + " (transaction_id, product_id, qty) VALUES ";
+		// One row of (transaction_id, product_id, qty) parameters per order item
+		std::vector<std::vector<SQLParam>> rows;
+		rows.reserve(orderItems.size());
 		for (size_t i = 0; i < orderItems.size(); ++i) {
-			query += "(" + std::to_string(std::get<0>(orderItems[i])) + ", "
-				+ std::to_string(std::get<1>(orderItems[i])) + ", "
-				+ std::to_string(std::get<2>(orderItems[i])) + ")";
-			if (i != orderItems.size() - 1) {
-				query += ",";
-			}
+			rows.push_back({ std::get<0>(orderItems[i]), std::get<1>(orderItems[i]), std::get<2>(orderItems[i]) });
 		}
 
 		// Execute the query
-		if (!dbConn.executeSQL(query)) {
+		std::string query = "INSERT INTO " + tableName + " (transaction_id, product_id, qty) VALUES (?, ?, ?);";
+		if (!dbConn->executeBulk(query, rows)) {
 			throw std::runtime_error("Failed to insert order items!");
 		}
 	}
 
 	// Nullifies product_id column for all order items that have a given product_id; good when a single product is deleted
-	void nullifyProductID(int product_id) {
+	void nullifyProductID(int product_id) override {
+		QueryCaller queryCaller("OrderItemManager::nullifyProductID");
+		WorkloadCall workloadCall(queryCaller, product_id);
+		DBConnLease dbConn = connectionPool.acquire();
 		std::string query = "UPDATE " + tableName + " SET product_id = NULL WHERE product_id=" + std::to_string(product_id) + ";";
 
-		if (!dbConn.executeSQL(query)) {
+		if (!dbConn->executeSQL(query)) {
 			throw std::runtime_error("Failed to update order items and nullify product_id!");
 		}
 	}
 
 	// Nullifies product_id column for all products that have a given supplier; good when supplier is deleted and we need to nullify all product_id values that were associated with it
-	void nullifyProductIDBySupplierID(int supplier_id) {
+	void nullifyProductIDBySupplierID(int supplier_id) override {
+		QueryCaller queryCaller("OrderItemManager::nullifyProductIDBySupplierID");
+		WorkloadCall workloadCall(queryCaller, supplier_id);
+		DBConnLease dbConn = connectionPool.acquire();
 		
 		std::string query = "UPDATE " + tableName + " SET " + tableName + ".product_id = NULL "
 			"WHERE product_id IN (SELECT " + productTableName + ".product_id FROM " + productTableName + " WHERE supplier_id=" + std::to_string(supplier_id) + ");";
 
-		if (!dbConn.executeSQL(query)) {
+		if (!dbConn->executeSQL(query)) {
 			throw std::runtime_error("Failed to update order items and nullify product_id via supplier_id");
 		}
 
@@ -0,0 +1,165 @@
+#ifndef PageSource_H
+#define PageSource_H
+
+#include <vector>
+#include <functional>
+#include <future>
+
+/*
++ PageSource: Hands out the rows of a table one page at a time, fetching only the page that's being looked at,
+    rather than loading every row into a vector first. Used by the paginated menus in utils.h.
+
+- Pages are fetched by key (keyset pagination): the next page is "the first pageSize rows with an ID greater than the
+  last ID on this page", which the server answers with an index seek, no matter how deep into the table we are.
+  We remember the key each page started after, so going back a page is a seek as well.
+- The total number of rows (for the "Page x / y" text) is counted once, the first time it's needed.
+- While a page is being shown, the next one is fetched in the background, so moving forward doesn't have to wait on
+  the database. Only the current page and the next one are ever held in memory.
+
+NOTE: Keys start after 0, since every table's ID is an IDENTITY column that starts at 1.
+*/
+template<typename T>
+class PageSource {
+public:
+    /*
+    - PageFetcher: Returns up to pageSize rows with a key greater than afterKey, ordered by key.
+    - KeyGetter: Returns the key (ID) of a row.
+    - Counter: Returns the total number of rows.
+    */
+    typedef std::function<std::vector<T>(int afterKey, int pageSize)> PageFetcher;
+    typedef std::function<int(T&)> KeyGetter;
+    typedef std::function<int()> Counter;
+
+    PageSource(int pageSize, PageFetcher fetchPage, KeyGetter getKey, Counter countItems)
+        : pageSize(pageSize < 1 ? 1 : pageSize),
+        fetchPage(fetchPage),
+        getKey(getKey),
+        countItems(countItems),
+        totalItems(-1),
+        pageNumber(1),
+        isPageLoaded(false),
+        prefetchAfterKey(0) {
+        pageAfterKeys.push_back(0);
+    }
+
+    PageSource(PageSource&&) = default;
+    PageSource& operator=(PageSource&&) = default;
+
+    // Waits for a prefetch that's still running, since it uses fetchPage
+    ~PageSource() {
+        if (nextPage.valid()) {
+            nextPage.wait();
+        }
+    }
+
+    int getPageSize() const {
+        return pageSize;
+    }
+
+    // Page number (starting at 1) of the current page
+    int getPageNumber() const {
+        return pageNumber;
+    }
+
+    // Total number of rows; counted the first time it's called
+    int getTotalItems() {
+        if (totalItems < 0) {
+            totalItems = countItems();
+        }
+        return totalItems;
+    }
+
+    int getPageCount() {
+        int count = (getTotalItems() + pageSize - 1) / pageSize;
+        return count < 1 ? 1 : count;
+    }
+
+    // Rows of the current page
+    std::vector<T>& getPage() {
+        if (!isPageLoaded) {
+            page = fetchPage(pageAfterKeys[pageNumber - 1], pageSize);
+            isPageLoaded = true;
+            startPrefetch();
+        }
+        return page;
+    }
+
+    // Moves to the next page; returns false (and stays put) if this is the last page
+    bool next() {
+        std::vector<T>& current = getPage();
+        if (static_cast<int>(current.size()) < pageSize) {
+            return false;
+        }
+
+        int afterKey = getKey(current.back());
+        std::vector<T> nextRows = takePrefetched(afterKey);
+        if (nextRows.empty()) {
+            return false;
+        }
+
+        if (static_cast<int>(pageAfterKeys.size()) <= pageNumber) {
+            pageAfterKeys.push_back(afterKey);
+        }
+        else {
+            pageAfterKeys[pageNumber] = afterKey;
+        }
+        pageNumber++;
+        page = std::move(nextRows);
+        startPrefetch();
+        return true;
+    }
+
+    // Moves to the previous page; returns false if this is the first page
+    bool previous() {
+        if (pageNumber <= 1) {
+            return false;
+        }
+        pageNumber--;
+        isPageLoaded = false;
+        getPage();
+        return true;
+    }
+
+private:
+    int pageSize;
+    PageFetcher fetchPage;
+    KeyGetter getKey;
+    Counter countItems;
+    int totalItems; // -1 until counted
+
+    int pageNumber;
+    std::vector<T> page;
+    bool isPageLoaded;
+    std::vector<int> pageAfterKeys; // pageAfterKeys[i] is the key page i + 1 starts after
+
+    std::future<std::vector<T>> nextPage; // Prefetch of the page after the current one
+    int prefetchAfterKey;
+
+    // Starts fetching the page after the current one in the background, if there could be one
+    void startPrefetch() {
+        if (nextPage.valid()) {
+            nextPage.wait();
+        }
+        nextPage = std::future<std::vector<T>>();
+        if (static_cast<int>(page.size()) < pageSize) {
+            return;
+        }
+        prefetchAfterKey = getKey(page.back());
+        nextPage = std::async(std::launch::async, fetchPage, prefetchAfterKey, pageSize);
+    }
+
+    // Gets the page after afterKey from the prefetch if we have it, otherwise fetches it now
+    std::vector<T> takePrefetched(int afterKey) {
+        if (nextPage.valid() && prefetchAfterKey == afterKey) {
+            try {
+                return nextPage.get();
+            }
+            catch (...) {
+                // The prefetch failed; try again below, so the error (if it happens again) is thrown here
+            }
+        }
+        return fetchPage(afterKey, pageSize);
+    }
+};
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef Product_H
 #define Product_H
 #include <string>
+#include <utility>
 #include <ostream>
 
 class Product {
@@ -11,25 +12,44 @@ private:
 	std::string description;
 	float price;
 	int qty;
+
+	// False for products fetched without their description (see ProductManager's summary queries)
+	bool isDescriptionLoaded;
 public:
 
 	// Default constructor
-	Product() : product_id(0), supplier_id(0), p_name(""), description(""), price(0.0f), qty(0) {}
+	Product() : product_id(0), supplier_id(0), p_name(""), description(""), price(0.0f), qty(0), isDescriptionLoaded(true) {}
+
 
+	Product(
+		int product_id,
+		int supplier_id,
+		std::string p_name,
+		std::string description,
+		float price,
+		int qty
+	) : product_id(product_id),
+		supplier_id(supplier_id),
+		p_name(std::move(p_name)),
+		description(std::move(description)),
+		price(price),
+		qty(qty),
+		isDescriptionLoaded(true) {}
 
+	// Product without its description; use ProductStore::getProductDescription and setDescription if it's needed
 	Product(
 		int product_id,
 		int supplier_id,
-		std::string& p_name,
-		std::string& description,
+		std::string p_name,
 		float price,
 		int qty
 	) : product_id(product_id),
 		supplier_id(supplier_id),
-		p_name(p_name),
-		description(description),
+		p_name(std::move(p_name)),
+		description(""),
 		price(price),
-		qty(qty) {}
+		qty(qty),
+		isDescriptionLoaded(false) {}
 
 	const int getProductID() {
 		return product_id;
@@ -43,10 +63,22 @@ public:
 		return p_name;
 	}
 
+	// Empty if the product was fetched without its description; check hasDescription first
 	const std::string& getDescription() {
 		return description;
 	}
 
+	// False if the product came from a summary query, and its description still has to be loaded
+	bool hasDescription() const {
+		return isDescriptionLoaded;
+	}
+
+	// For filling in the description of a product from a summary query
+	void setDescription(std::string description) {
+		this->description = std::move(description);
+		isDescriptionLoaded = true;
+	}
+
 	const float getPrice() {
 		return price;
 	}
@@ -0,0 +1,229 @@
+#ifndef ProductCache_H
+#define ProductCache_H
+
+#include <vector>
+#include <mutex>
+#include <ostream>
+#include <cstdint>
+
+#include "Product.h"
+
+/*
++ ProductCache: A fixed-size, in-memory cache of products keyed by product_id, used by ProductManager so that reading the
+    same product over and over (showing a cart, updating a cart item, etc.) doesn't go to the database every time.
+
+- Lookups use an open-addressing hash table (linear probing), so a lookup is a few array reads with no allocations.
+  The table has at least twice as many slots as the cache holds products, which keeps the probe chains short.
+- When the cache is full, a product is evicted with the CLOCK algorithm: every product has a 'referenced' bit that's set
+  when it's read, and the clock hand sweeps over the products, clearing bits until it finds one that hasn't been read
+  since the last sweep. It's close to LRU, without having to reorder a list on every read.
+- Hits, misses, and evictions are counted so we can tell if the cache is worth it, or too small.
+
+NOTE: Products that get written have to be invalidated (erase). Since a read from the database can race with a write,
+    every invalidation bumps a version number. A reader grabs the version before it queries the database, and put()
+    ignores the product if anything was invalidated since, so a stale product can't sneak back into the cache.
+*/
+class ProductCache {
+public:
+    struct Stats {
+        unsigned long long hits = 0;
+        unsigned long long misses = 0;
+        unsigned long long evictions = 0;
+        size_t size = 0;
+        size_t capacity = 0;
+    };
+
+    ProductCache(size_t capacity) : capacity(capacity < 1 ? 1 : capacity), hand(0), version(0) {
+        // Round the number of slots up to a power of two that's at least twice the capacity
+        slotBits = 1;
+        while ((static_cast<size_t>(1) << slotBits) < this->capacity * 2) {
+            slotBits++;
+        }
+        slots.assign(static_cast<size_t>(1) << slotBits, EMPTY_SLOT);
+        entries.resize(this->capacity);
+        for (size_t i = this->capacity; i > 0; i--) {
+            freeEntries.push_back(static_cast<int>(i - 1));
+        }
+    }
+
+    // Copies the product with product_id into product and returns true, if it's cached
+    bool get(int product_id, Product& product) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t slot = findSlot(product_id);
+        if (slots[slot] == EMPTY_SLOT) {
+            stats.misses++;
+            return false;
+        }
+        Entry& entry = entries[slots[slot]];
+        entry.referenced = true;
+        product = entry.product;
+        stats.hits++;
+        return true;
+    }
+
+    // Version to pass to put(); get it before reading the product from the database
+    uint64_t getVersion() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return version;
+    }
+
+    // Caches product, unless something was invalidated after readVersion was taken
+    void put(Product product, uint64_t readVersion) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (readVersion != version) {
+            return;
+        }
+
+        const int product_id = product.getProductID();
+        size_t slot = findSlot(product_id);
+        if (slots[slot] != EMPTY_SLOT) {
+            Entry& entry = entries[slots[slot]];
+            entry.product = product;
+            entry.referenced = true;
+            return;
+        }
+
+        // Make room if we're full; evicting can move other slots around, so find the slot again after
+        if (freeEntries.empty()) {
+            evict();
+            slot = findSlot(product_id);
+        }
+
+        int entryIndex = freeEntries.back();
+        freeEntries.pop_back();
+        Entry& entry = entries[entryIndex];
+        entry.productID = product_id;
+        entry.product = product;
+        entry.referenced = true;
+        entry.isUsed = true;
+        slots[slot] = entryIndex;
+    }
+
+    // Removes the product from the cache; call this whenever the product is changed or deleted
+    void erase(int product_id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        version++;
+        size_t slot = findSlot(product_id);
+        if (slots[slot] != EMPTY_SLOT) {
+            removeSlot(slot);
+        }
+    }
+
+    // Removes every product, for writes that could touch any of them (like deleting a supplier's products)
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        version++;
+        slots.assign(slots.size(), EMPTY_SLOT);
+        freeEntries.clear();
+        for (size_t i = capacity; i > 0; i--) {
+            entries[i - 1].isUsed = false;
+            entries[i - 1].product = Product();
+            freeEntries.push_back(static_cast<int>(i - 1));
+        }
+    }
+
+    Stats getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats snapshot = stats;
+        snapshot.size = capacity - freeEntries.size();
+        snapshot.capacity = capacity;
+        return snapshot;
+    }
+
+    void printStats(std::ostream& os) {
+        Stats snapshot = getStats();
+        unsigned long long lookups = snapshot.hits + snapshot.misses;
+        double hitRate = lookups == 0 ? 0.0 : 100.0 * snapshot.hits / lookups;
+        os << "<ProductCache size(" << snapshot.size << "/" << snapshot.capacity << "), hits(" << snapshot.hits << "), misses("
+            << snapshot.misses << "), hit rate(" << hitRate << "%), evictions(" << snapshot.evictions << ")/>";
+    }
+
+private:
+    struct Entry {
+        int productID = 0;
+        Product product;
+        bool referenced = false; // Set when read, cleared by the clock hand
+        bool isUsed = false;
+    };
+
+    enum { EMPTY_SLOT = -1 };
+
+    size_t capacity;
+    size_t slotBits;
+    std::vector<int> slots;       // Hash table of indexes into entries, EMPTY_SLOT if empty
+    std::vector<Entry> entries;
+    std::vector<int> freeEntries; // Indexes of entries that aren't holding a product
+    size_t hand;                  // Clock hand; index into entries
+    uint64_t version;
+    Stats stats;
+    std::mutex mutex;
+
+    // Home slot of a product_id; multiplicative hashing (Fibonacci hashing) spreads out sequential IDs
+    size_t homeSlot(int product_id) const {
+        uint32_t hash = static_cast<uint32_t>(product_id) * 2654435769u;
+        return static_cast<size_t>(hash >> (32 - slotBits));
+    }
+
+    size_t nextSlot(size_t slot) const {
+        return (slot + 1) & (slots.size() - 1);
+    }
+
+    // Returns the slot holding product_id, or the empty slot where it would go
+    size_t findSlot(int product_id) const {
+        size_t slot = homeSlot(product_id);
+        while (slots[slot] != EMPTY_SLOT && entries[slots[slot]].productID != product_id) {
+            slot = nextSlot(slot);
+        }
+        return slot;
+    }
+
+    /*
+    - Empties a slot, and frees its entry.
+
+    NOTE: With linear probing we can't just empty the slot, since a product further along the probe chain would then
+        look like it's missing. So we shift later products in the chain back into the gap (backward shift deletion).
+    */
+    void removeSlot(size_t slot) {
+        int entryIndex = slots[slot];
+        entries[entryIndex].isUsed = false;
+        entries[entryIndex].product = Product();
+        freeEntries.push_back(entryIndex);
+
+        size_t gap = slot;
+        size_t next = nextSlot(gap);
+        slots[gap] = EMPTY_SLOT;
+        while (slots[next] != EMPTY_SLOT) {
+            size_t home = homeSlot(entries[slots[next]].productID);
+
+            // The product at 'next' can move into the gap if its home slot isn't between the gap and itself
+            bool canMove = gap <= next ? (home <= gap || home > next) : (home <= gap && home > next);
+            if (canMove) {
+                slots[gap] = slots[next];
+                slots[next] = EMPTY_SLOT;
+                gap = next;
+            }
+            next = nextSlot(next);
+        }
+    }
+
+    // Evicts one product with the clock algorithm
+    void evict() {
+        while (true) {
+            Entry& entry = entries[hand];
+            size_t current = hand;
+            hand = (hand + 1) % capacity;
+            if (!entry.isUsed) {
+                continue;
+            }
+            if (entry.referenced) {
+                entry.referenced = false;
+                continue;
+            }
+            removeSlot(findSlot(entries[current].productID));
+            stats.evictions++;
+            return;
+        }
+    }
+};
+
+#endif
@@ -5,49 +5,109 @@
 #include <vector>
 #include <map>
 #include <tuple>
-
-#include "DBConn.h"
+#include <memory>
+#include <ostream>
+
+#include "ConnectionPool.h"
+#include "WorkloadRecorder.h"
+#include "PageSource.h"
+#include "RowMapper.h"
+#include "ProductCache.h"
+#include "StorageBackend.h"
 #include "Product.h"
 #include "CartItem.h"
 
-class ProductManager {
+// The SQL Server ProductStore (see StorageBackend.h); the column length limits and validators are in ProductStore
+class ProductManager : public ProductStore {
 private:
-	DBConn& dbConn;
+	ConnectionPool& connectionPool;
 	std::string tableName; // Table name for products, such as 'products' table
 	std::string supplierTableName; // Table name for the 'suppliers' table in which products reference with suppiler_id
-	static const int MAX_P_NAME_LENGTH = 50;
-	static const int MAX_DESCRIPTION_LENGTH = 2000;
+	std::unique_ptr<ProductCache> cache; // Cache for getProductByID; null until enableCache is called
+
+	/*
+	- Columns for the summary queries: everything but description. The list screens only show the ID, name, price, and quantity,
+	  so there's no reason to send every product's VARCHAR(2000) description over the network and bind a 2001 byte buffer for 
+	  each row. Products fetched this way don't have a description (hasDescription is false); screens that show it load it
+	  with getProductDescription.
+	*/
+	std::string summaryColumns = "product_id, supplier_id, p_name, price, qty";
 
+	// Drops a product from the cache after it's changed or deleted, so the next read gets it from the database
+	void invalidateCachedProduct(int product_id) {
+		if (cache) {
+			cache->erase(product_id);
+		}
+	}
 
-	// Helper function that takes SQL row data and creates product object from it.
-	Product createProductFromRow(SQLINTEGER product_id, SQLINTEGER supplier_id, SQLCHAR* p_name, SQLCHAR* description, SQLFLOAT price, SQLINTEGER qty) {
-		// Null terminate the string values
-		p_name[MAX_P_NAME_LENGTH] = '\0';
-		description[MAX_DESCRIPTION_LENGTH] = '\0';
+	// Columns of the products table, in order: product_id, supplier_id, p_name, description, price, qty
+	typedef RowMapper<Product, IntColumn, IntColumn, StringColumn<MAX_P_NAME_LENGTH>, StringColumn<MAX_DESCRIPTION_LENGTH>,
+		FloatColumn, IntColumn> ProductRowMapper;
 
-		// Convert SQL data-types to regular data-types
-		int intProductID = static_cast<int>(product_id);
-		int intSupplierID = static_cast<int>(supplier_id);
-		std::string p_name_str(reinterpret_cast<char*>(p_name));
-		std::string descriptionStr(reinterpret_cast<char*>(description));
-		float floatPrice = static_cast<float>(price);
-		int intQty = static_cast<int>(qty);
+	// Columns of the summary queries (summaryColumns), in order: product_id, supplier_id, p_name, price, qty
+	typedef RowMapper<Product, IntColumn, IntColumn, StringColumn<MAX_P_NAME_LENGTH>, FloatColumn, IntColumn> ProductSummaryRowMapper;
 
-		return Product(intProductID, intSupplierID, p_name_str, descriptionStr, floatPrice, intQty);
+	// Reads the rows of the current result set into a vector of products; expects the query to have selected every column of the products table
+	std::vector<Product> readProducts(DBConn& dbConn) {
+		return ProductRowMapper::read(dbConn, "Failed to fetch a given product!");
+	}
+
+	// Like readProducts, but for the summary queries, which select summaryColumns instead of every column
+	std::vector<Product> readProductSummaries(DBConn& dbConn) {
+		return ProductSummaryRowMapper::read(dbConn, "Failed to fetch a given product!");
 	}
-	
 
 public:
 	ProductManager(
-		DBConn& dbConn,
+		ConnectionPool& connectionPool,
 		std::string& tableName,
 		std::string& supplierTableName
-	) : dbConn(dbConn),
+	) : connectionPool(connectionPool),
 		tableName(tableName),
 		supplierTableName(supplierTableName) {}
 
+	/*
+	- Turns on the product cache, holding up to capacity products. After this, getProductByID reads through the cache,
+	  and the update/delete functions invalidate whatever they change.
+
+	NOTE: Only writes that go through this manager are seen. If something else changes the products table
+		(like the checkout procedure taking stock), call invalidateCachedProducts for those products.
+	NOTE: Inside a transaction the cache is skipped: reads go to the database, and nothing read or created there
+		is cached, since the transaction could still roll back and leave the cache with a product that never existed.
+	*/
+	void enableCache(size_t capacity) {
+		cache.reset(new ProductCache(capacity));
+	}
+
+	bool isCacheEnabled() const {
+		return cache != nullptr;
+	}
+
+	// Drops the given products from the cache, for when they were changed outside of this manager
+	void invalidateCachedProducts(const std::vector<int>& productIDs) override {
+		for (size_t i = 0; i < productIDs.size(); i++) {
+			invalidateCachedProduct(productIDs[i]);
+		}
+	}
+
+	// Returns the cache's hit/miss counters; all zeros if the cache isn't enabled
+	ProductCache::Stats getCacheStats() {
+		return cache ? cache->getStats() : ProductCache::Stats();
+	}
+
+	void printCacheStats(std::ostream& os) {
+		if (cache) {
+			cache->printStats(os);
+		}
+		else {
+			os << "<ProductCache disabled/>";
+		}
+	}
+
 	// Initialize table for holding products
 	void initTable() {
+		QueryCaller queryCaller("ProductManager::initTable");
+		DBConnLease dbConn = connectionPool.acquire();
 		std::string query = "CREATE TABLE " + tableName + " ( "
 			"product_id INT NOT NULL IDENTITY PRIMARY KEY, "
 			"supplier_id INT NOT NULL, "
@@ -57,131 +117,178 @@ public:
 			"qty INT NOT NULL CHECK (qty >= 0), "
 			"FOREIGN KEY (supplier_id) REFERENCES " + supplierTableName + " (supplier_id)"
 			");";
-		if (!dbConn.executeSQL(query)) {
+		if (!dbConn->executeSQL(query)) {
 			throw std::runtime_error("Failed to initialize '" + tableName + "' table!");
 		}
 	}
 
-	// Validates p_name is within length constraints
-	void validateProductName(std::string& p_name) {
-		if (p_name.length() > MAX_P_NAME_LENGTH) {
-			throw std::runtime_error("Product p_name exceeds maximum length of " + std::to_string(MAX_P_NAME_LENGTH) + " characters!");
+	// Given a query string, fetch a vector of products
+	std::vector<Product> fetchProducts(const std::string query) {
+		DBConnLease dbConn = connectionPool.acquire();
+		// execute SQL Query
+		if (!dbConn->executeSQL(query)) {
+			throw std::runtime_error("Failed to fetch products!");
 		}
+		return readProducts(*dbConn);
 	}
 
-	// Validates description is within length constraints
-	void validateDescription(std::string& description) {
-		if (description.length() > MAX_DESCRIPTION_LENGTH) {
-			throw std::runtime_error("Product description exceeds maximum length of " + std::to_string(MAX_DESCRIPTION_LENGTH) + " characters!");
+	// Given a parameterized query and the values for its placeholders, fetch a vector of products using a prepared statement
+	std::vector<Product> fetchProducts(const std::string& query, std::vector<SQLParam> params) {
+		DBConnLease dbConn = connectionPool.acquire();
+		if (!dbConn->executePrepared(query, std::move(params))) {
+			throw std::runtime_error("Failed to fetch products!");
 		}
+		return readProducts(*dbConn);
 	}
 
-	// Validates price isn't negative
-	void validatePrice(float price) {
-		if (price < 0) {
-			throw std::runtime_error("Product price can't be negative!");
+	// Given a query that selects summaryColumns, fetch a vector of products without their descriptions
+	std::vector<Product> fetchProductSummaries(const std::string query) {
+		DBConnLease dbConn = connectionPool.acquire();
+		if (!dbConn->executeSQL(query)) {
+			throw std::runtime_error("Failed to fetch products!");
 		}
+		return readProductSummaries(*dbConn);
 	}
 
-	// Validates quantity isn't negative
-	void validateQty(int qty) {
-		if (qty < 0) {
-			throw std::runtime_error("Product quantity can't be negative!");
+	// Given a parameterized query that selects summaryColumns, and the values for its placeholders, fetch a vector of products without their descriptions
+	std::vector<Product> fetchProductSummaries(const std::string& query, std::vector<SQLParam> params) {
+		DBConnLease dbConn = connectionPool.acquire();
+		if (!dbConn->executePrepared(query, std::move(params))) {
+			throw std::runtime_error("Failed to fetch products!");
 		}
+		return readProductSummaries(*dbConn);
 	}
 
-	// Given a query string, fetch a vector of products
-	std::vector<Product> fetchProducts(const std::string query) {
-		std::vector<Product> products;
+	/*
+	- Returns the description of a product; use it to fill in (setDescription) a product from a summary query.
 
-		// execute SQL Query
-		if (!dbConn.executeSQL(query)) {
-			throw std::runtime_error("Failed to fetch products!");
+	NOTE: The description isn't bound to a buffer, it's read with DBConn::getData, so only its actual length is copied.
+	*/
+	std::string getProductDescription(int product_id) override {
+		QueryCaller queryCaller("ProductManager::getProductDescription");
+		WorkloadCall workloadCall(queryCaller, product_id);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "SELECT description FROM " + tableName + " WHERE product_id=?;";
+		if (!dbConn->executePrepared(query, { product_id })) {
+			throw std::runtime_error("Failed to fetch description of product with id '" + std::to_string(product_id) + "'!");
 		}
 
-		// Create buffers/variables that will capture row data
-		SQLINTEGER product_id = 0;
-		SQLINTEGER supplier_id = 0;
-		SQLCHAR p_name[MAX_P_NAME_LENGTH + 1] = {};
-		SQLCHAR description[MAX_DESCRIPTION_LENGTH + 1] = {};
-		SQLFLOAT price = 0;
-		SQLINTEGER qty = 0;
-
-		// Bind columns, allowing them to get data
-		dbConn.bindColumn(1, SQL_INTEGER, &product_id, sizeof(product_id));
-		dbConn.bindColumn(2, SQL_INTEGER, &supplier_id, sizeof(supplier_id));
-		dbConn.bindColumn(3, SQL_C_CHAR, p_name, sizeof(p_name));
-		dbConn.bindColumn(4, SQL_C_CHAR, description, sizeof(description));
-		dbConn.bindColumn(5, SQL_C_DOUBLE, &price, sizeof(price));
-		dbConn.bindColumn(6, SQL_INTEGER, &qty, sizeof(qty));
-
-		while (true) {
-			SQLRETURN retcode = dbConn.fetchRow();
-
-			// If no more rows to be fetched, exit the loop
-			if (retcode == SQL_NO_DATA) {
-				break;
-			}
-			// Else if we failed to fetch data
-			else if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
-				dbConn.closeCursor(); // ensure we close cursor before throwing an error 
-				throw std::runtime_error("Failed to fetch a given customer!");
-			}
-
-			// Create product object using row data
-			Product product = createProductFromRow(product_id, supplier_id, p_name, description, price, qty);
-
-			// Put product object into array
-			products.push_back(product);
+		SQLRETURN retcode = dbConn->fetchRow();
+		if (retcode == SQL_NO_DATA) {
+			dbConn->closeCursor();
+			throw std::runtime_error("No product found with ID " + std::to_string(product_id));
 		}
 
-		// Close the cursor and return vector of products
-		dbConn.closeCursor();
-		return products;
+		std::string description;
+		bool succeeded = (retcode == SQL_SUCCESS || retcode == SQL_SUCCESS_WITH_INFO) && dbConn->getData(1, description);
+		dbConn->closeCursor();
+		if (!succeeded) {
+			throw std::runtime_error("Failed to fetch description of product with id '" + std::to_string(product_id) + "'!");
+		}
+		return description;
 	}
 
-	// Returns a vector of all products in the table
-	std::vector<Product> getAllProducts() {
+	// Returns a vector of all products in the table; descriptions are loaded on demand
+	std::vector<Product> getAllProducts() override {
+		QueryCaller queryCaller("ProductManager::getAllProducts");
+		WorkloadCall workloadCall(queryCaller);
 		// Query to get all products
-		std::string query = "SELECT * FROM " + tableName + ";";
+		std::string query = "SELECT " + summaryColumns + " FROM " + tableName + ";";
 
 		// Run function to return a vector
-		std::vector<Product> products = fetchProducts(query);
+		std::vector<Product> products = fetchProductSummaries(query);
 		return products;
 	}
 
-	// Returns a vector of all available (qty > 0) products in the table
-	std::vector<Product> getAvailableProducts() {
+	/*
+	- Streams every product in the table, one at a time, for reports and exports over the whole table (see RowStream)
+
+	NOTE: Unlike getAllProducts, every column is selected, descriptions included. A lazy description would be loaded
+		with another query in the middle of the loop, which can't run while the stream's cursor is open on the connection.
+	*/
+	RowStream<Product> streamAll() override {
+		QueryCaller queryCaller("ProductManager::streamAll");
+		DBConnLease dbConn = connectionPool.acquire();
+		if (!dbConn->executeSQL("SELECT * FROM " + tableName + ";")) {
+			throw std::runtime_error("Failed to query products!");
+		}
+		return ProductRowMapper::stream(std::move(dbConn), "Failed to fetch a given product!");
+	}
+
+	// Returns a vector of all available (qty > 0) products in the table; descriptions are loaded on demand
+	std::vector<Product> getAvailableProducts() override {
+		QueryCaller queryCaller("ProductManager::getAvailableProducts");
+		WorkloadCall workloadCall(queryCaller);
 		// Query to get all products that have a quantity greater than 0
-		std::string query = "SELECT * FROM " + tableName + " WHERE qty > 0;";
+		std::string query = "SELECT " + summaryColumns + " FROM " + tableName + " WHERE qty > 0;";
 
 		// Run function to get vector of products, then return those products
-		std::vector<Product> products = fetchProducts(query);
+		std::vector<Product> products = fetchProductSummaries(query);
 		return products;
 	}
 
-	// Returns a Product object when passed a product_id
-	Product getProductByID(int product_id) {
-		// Query to select all products from table
-		std::string query = "SELECT * FROM " + tableName + " WHERE product_id=" + std::to_string(product_id) + ";";
+	// Returns the number of products; if onlyAvailable is true, only counts products that are in stock
+	int getProductCount(bool onlyAvailable = false) override {
+		QueryCaller queryCaller("ProductManager::getProductCount");
+		WorkloadCall workloadCall(queryCaller, onlyAvailable);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "SELECT COUNT(*) FROM " + tableName + (onlyAvailable ? " WHERE qty > 0;" : ";");
+		int count = 0;
+		if (!dbConn->executeScalar(query, {}, count)) {
+			throw std::runtime_error("Failed to count products!");
+		}
+		return count;
+	}
+
+	/*
+	- Returns up to pageSize products with a product_id greater than afterID, ordered by product_id; onlyAvailable skips products that aren't in stock
+	- Like the other list queries, the products don't have their descriptions (see getProductDescription).
+	*/
+	std::vector<Product> getProductPage(int afterID, int pageSize, bool onlyAvailable = false) override {
+		QueryCaller queryCaller("ProductManager::getProductPage");
+		WorkloadCall workloadCall(queryCaller, afterID, pageSize, onlyAvailable);
+		std::string query = "SELECT TOP (?) " + summaryColumns + " FROM " + tableName + " WHERE product_id > ?" + (onlyAvailable ? " AND qty > 0" : "") + " ORDER BY product_id;";
+		return fetchProductSummaries(query, { pageSize, afterID });
+	}
+
+	// Returns a Product object when passed a product_id; comes from the cache if it's enabled and has the product
+	Product getProductByID(int product_id) override {
+		QueryCaller queryCaller("ProductManager::getProductByID");
+		WorkloadCall workloadCall(queryCaller, product_id);
+		Product product;
+		bool useCache = cache && !connectionPool.inTransaction();
+		if (useCache && cache->get(product_id, product)) {
+			return product;
+		}
+
+		// Grab the cache version before reading, so the product isn't cached if it's changed while we're reading it
+		uint64_t cacheVersion = useCache ? cache->getVersion() : 0;
+
+		// Query to select the product; product_id is bound as a parameter so the prepared statement gets reused on every lookup
+		std::string query = "SELECT * FROM " + tableName + " WHERE product_id=?;";
 
 		// If vector is empty, then product_id doesn't reference a product, throw an error.
-		std::vector<Product> products = fetchProducts(query);
+		std::vector<Product> products = fetchProducts(query, { product_id });
 		if (products.empty()) {
 			throw std::runtime_error("No product found with ID " + std::to_string(product_id));
 		}
 
 		// We're expecting a vector with one product, so index it out.
-		Product product = products[0];
+		product = products[0];
+		if (useCache) {
+			cache->put(product, cacheVersion);
+		}
 		return product;
 	}
 	
 
 	// Function should return a map with key product_id, and value quantity in stock for that product
-	std::map<int, int> getProductQuantities(std::vector<int> productIDs) {
+	std::map<int, int> getProductQuantities(std::vector<int> productIDs) override {
+		QueryCaller queryCaller("ProductManager::getProductQuantities");
+		WorkloadCall workloadCall(queryCaller, productIDs);
 
 		// Construct a query that finds all products in products table where ID is in the vector
-		std::string query = "SELECT * FROM " + tableName + " WHERE product_id IN (";
+		std::string query = "SELECT " + summaryColumns + " FROM " + tableName + " WHERE product_id IN (";
 		for (size_t i = 0; i < productIDs.size(); i++) {
 			if (i > 0) {
 				query += ",";
@@ -191,7 +298,7 @@ public:
 		query += ")";
 
 		// Fetch those products as a vector; create map that we'll return
-		std::vector<Product> products = fetchProducts(query);
+		std::vector<Product> products = fetchProductSummaries(query);
 		std::map<int, int> productQuantityMap;
 
 		// Iterate through vector, the key will be product_id and value will be its quantity in stock
@@ -212,7 +319,9 @@ public:
 	NOTE: We assume that quantity validation has already been done here.
 	
 	*/
-	void batchUpdateProductQty(std::vector<std::tuple<int, int>> productQuantities) {
+	void batchUpdateProductQty(std::vector<std::tuple<int, int>> productQuantities) override {
+		QueryCaller queryCaller("ProductManager::batchUpdateProductQty");
+		DBConnLease dbConn = connectionPool.acquire();
 		if (productQuantities.empty()) {
 			return; // No products to update
 		}
@@ -227,86 +336,165 @@ public:
 			query += "UPDATE " + tableName + " SET qty=" + std::to_string(qty)
 				+ " WHERE product_id=" + std::to_string(product_id) + ";";
 		}
-		// Execute the query
-		if (!dbConn.executeSQL(query)) {
+		// Invalidate before checking if it worked, since some of the updates may have gone through
+		bool succeeded = dbConn->executeSQL(query);
+		for (size_t i = 0; i < productQuantities.size(); ++i) {
+			invalidateCachedProduct(std::get<0>(productQuantities[i]));
+		}
+		if (!succeeded) {
 			throw std::runtime_error("Failed to update product quantities!");
 		}
 
 		// Close cursor to prevent invalid cursor state
-		dbConn.closeCursor();
+		dbConn->closeCursor();
 	}
 
 
 	// Creates a new product in the database and returns the object representation of that product
-	Product createProduct(int supplier_id, std::string p_name, std::string description, float price, int qty) {
+	Product createProduct(int supplier_id, std::string p_name, std::string description, float price, int qty) override {
+		QueryCaller queryCaller("ProductManager::createProduct");
+		WorkloadCall workloadCall(queryCaller, supplier_id, p_name, description, price, qty);
+		DBConnLease dbConn = connectionPool.acquire();
 
-		// Escape string related data	
-		std::string escaped_p_name = dbConn.escapeSQL(p_name);
-		std::string escapedDescription = dbConn.escapeSQL(description);
-
-		// Construct INSERT query for inserting a new product
-		std::string query = "INSERT INTO " + tableName + " (supplier_id, p_name, description, price, qty) VALUES ('" + std::to_string(supplier_id) + "', '" + escaped_p_name + "', '" + escapedDescription + "', '" + std::to_string(price) + "', '" + std::to_string(qty) + "');";
+		// Construct INSERT query for inserting a new product; the values are bound as parameters so they don't need to be escaped
+		// The OUTPUT clause returns the new product_id from the insert, so we don't need a second query for it
+		std::string query = "INSERT INTO " + tableName + " (supplier_id, p_name, description, price, qty) OUTPUT INSERTED.product_id VALUES (?, ?, ?, ?, ?);";
 
 		// Attempt to execute insert query
-		if (!dbConn.executeSQL(query)) {
+		int product_id = 0;
+		if (!dbConn->executeInsert(query, { supplier_id, p_name, description, price, qty }, product_id)) {
 			throw std::runtime_error("Failed to create with supplier_id(" + std::to_string(supplier_id) + "), and p_name '" + p_name + "'!");
 		}
 
-		// Get the ID of the product, create an object representation, and return the product
-		const int product_id = dbConn.getLastInsertedID();
+		// Create an object representation, and return the product
 		Product product(product_id, supplier_id, p_name, description, price, qty);
+		if (cache && !dbConn->inTransaction()) {
+			cache->put(product, cache->getVersion());
+		}
 		return product;
 	}
 
+	/*
+	+ Creates many products at once, such as when importing a catalog, and returns them with their new IDs. Each tuple
+	is in the form (supplier_id, p_name, description, price, qty).
+
+	NOTE: All of the rows go to the server as one bulk insert (see DBConn::executeBulkInsert), and each row's product_id
+		comes back from the insert itself, so there's no extra round trip per product.
+	*/
+	std::vector<Product> batchCreateProduct(std::vector<std::tuple<int, std::string, std::string, float, int>> productRows) override {
+		QueryCaller queryCaller("ProductManager::batchCreateProduct");
+		DBConnLease dbConn = connectionPool.acquire();
+		std::vector<Product> products;
+		if (productRows.empty()) {
+			return products; // No products to insert
+		}
+
+		// Validate every product before inserting any of them
+		std::vector<std::vector<SQLParam>> rows;
+		rows.reserve(productRows.size());
+		for (size_t i = 0; i < productRows.size(); i++) {
+			validateProductName(std::get<1>(productRows[i]));
+			validateDescription(std::get<2>(productRows[i]));
+			validatePrice(std::get<3>(productRows[i]));
+			validateQty(std::get<4>(productRows[i]));
+			rows.push_back({ std::get<0>(productRows[i]), std::get<1>(productRows[i]), std::get<2>(productRows[i]), std::get<3>(productRows[i]), std::get<4>(productRows[i]) });
+		}
+
+		std::string query = "INSERT INTO " + tableName + " (supplier_id, p_name, description, price, qty) OUTPUT INSERTED.product_id VALUES (?, ?, ?, ?, ?);";
+		std::vector<int> ids;
+		if (!dbConn->executeBulkInsert(query, rows, ids)) {
+			throw std::runtime_error("Failed to create " + std::to_string(productRows.size()) + " products!");
+		}
+
+		// Create Product objects with their new IDs
+		products.reserve(productRows.size());
+		for (size_t i = 0; i < productRows.size(); i++) {
+			products.push_back(Product(ids[i], std::get<0>(productRows[i]), std::get<1>(productRows[i]), std::get<2>(productRows[i]), std::get<3>(productRows[i]), std::get<4>(productRows[i])));
+		}
+		return products;
+	}
+
 	// Updates a product's name
-	void updateName(int product_id, std::string p_name) {
+	void updateName(int product_id, std::string p_name) override {
+		QueryCaller queryCaller("ProductManager::updateName");
+		WorkloadCall workloadCall(queryCaller, product_id, p_name);
+		DBConnLease dbConn = connectionPool.acquire();
 		validateProductName(p_name);
-		p_name = dbConn.escapeSQL(p_name);
-		std::string query = "UPDATE " + tableName + " SET p_name='" + p_name + "' WHERE product_id=" + std::to_string(product_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+		std::string query = "UPDATE " + tableName + " SET p_name=? WHERE product_id=?;";
+		bool succeeded = dbConn->executePrepared(query, { std::move(p_name), product_id });
+		invalidateCachedProduct(product_id);
+		if (!succeeded) {
 			throw std::runtime_error("Failed to update product with id '" + std::to_string(product_id) + "'!");
 		}
 	}
 
 	// Updates a product's description
-	void updateDescription(int product_id, std::string description) {
+	void updateDescription(int product_id, std::string description) override {
+		QueryCaller queryCaller("ProductManager::updateDescription");
+		WorkloadCall workloadCall(queryCaller, product_id, description);
+		DBConnLease dbConn = connectionPool.acquire();
 		validateDescription(description);
-		description = dbConn.escapeSQL(description);
-		std::string query = "UPDATE " + tableName + " SET description='" + description + "' WHERE product_id=" + std::to_string(product_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+		std::string query = "UPDATE " + tableName + " SET description=? WHERE product_id=?;";
+		bool succeeded = dbConn->executePrepared(query, { std::move(description), product_id });
+		invalidateCachedProduct(product_id);
+		if (!succeeded) {
 			throw std::runtime_error("Failed to update product with id '" + std::to_string(product_id) + "'!");
 		}
 	}
 
 	// Updates a product's price
-	void updatePrice(int product_id, float price) {
+	void updatePrice(int product_id, float price) override {
+		QueryCaller queryCaller("ProductManager::updatePrice");
+		WorkloadCall workloadCall(queryCaller, product_id, price);
+		DBConnLease dbConn = connectionPool.acquire();
 		validatePrice(price);
-		std::string query = "UPDATE " + tableName + " SET price=" + std::to_string(price) + " WHERE product_id=" + std::to_string(product_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+		std::string query = "UPDATE " + tableName + " SET price=? WHERE product_id=?;";
+		bool succeeded = dbConn->executePrepared(query, { price, product_id });
+		invalidateCachedProduct(product_id);
+		if (!succeeded) {
 			throw std::runtime_error("Failed to update product with id '" + std::to_string(product_id) + "'!");
 		}
 	}
 
 	// Updates quantity on a product
-	void updateQuantity(int product_id, int qty) {
+	void updateQuantity(int product_id, int qty) override {
+		QueryCaller queryCaller("ProductManager::updateQuantity");
+		WorkloadCall workloadCall(queryCaller, product_id, qty);
+		DBConnLease dbConn = connectionPool.acquire();
 		validateQty(qty);
-		std::string query = "UPDATE " + tableName + " SET qty=" + std::to_string(qty) + " WHERE product_id=" + std::to_string(product_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+		std::string query = "UPDATE " + tableName + " SET qty=? WHERE product_id=?;";
+		bool succeeded = dbConn->executePrepared(query, { qty, product_id });
+		invalidateCachedProduct(product_id);
+		if (!succeeded) {
 			throw std::runtime_error("Failed to update product with id '" + std::to_string(product_id) + "'!");
 		}
 	}
 
 	// Deletes a product
-	void deleteProduct(int product_id) {
-		std::string query = "DELETE " + tableName + " WHERE product_id=" + std::to_string(product_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+	void deleteProduct(int product_id) override {
+		QueryCaller queryCaller("ProductManager::deleteProduct");
+		WorkloadCall workloadCall(queryCaller, product_id);
+		DBConnLease dbConn = connectionPool.acquire();
+		std::string query = "DELETE " + tableName + " WHERE product_id=?;";
+		bool succeeded = dbConn->executePrepared(query, { product_id });
+		invalidateCachedProduct(product_id);
+		if (!succeeded) {
 			throw std::runtime_error("Failed to delete product with id '" + std::to_string(product_id) + "'. It may not exist!");
 		}
 	};
 
-	void deleteBySupplierID(int supplier_id) {
+	void deleteBySupplierID(int supplier_id) override {
+		QueryCaller queryCaller("ProductManager::deleteBySupplierID");
+		WorkloadCall workloadCall(queryCaller, supplier_id);
+		DBConnLease dbConn = connectionPool.acquire();
 		std::string query = "DELETE " + tableName + " WHERE supplier_id=" + std::to_string(supplier_id) + ";";
-		if (!dbConn.executeSQL(query)) {
+		bool succeeded = dbConn->executeSQL(query);
+
+		// We don't know which products the supplier had, so clear the whole cache
+		if (cache) {
+			cache->clear();
+		}
+		if (!succeeded) {
 			throw std::runtime_error("Failed to delete product with supplier_id '" + std::to_string(supplier_id) + "'. It may not exist!");
 		}
 	}
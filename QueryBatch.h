@@ -0,0 +1,100 @@
+#ifndef QueryBatch_H
+#define QueryBatch_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+#include "ConnectionPool.h"
+#include "SQLParam.h"
+#include "StorageBackend.h"
+
+/*
++ QueryBatch: Collects SELECTs from different managers, and sends them to the server as one batch, so a screen
+    that needs several things (like a transaction and its order items) gets them in one round trip instead of one each.
+
+        QueryBatch batch(connectionPool);
+        std::vector<Transaction> transactions;
+        std::vector<OrderItem> orderItems;
+        transactionManager.batchGetTransactionByID(batch, transaction_id, transactions);
+        orderItemManager.batchGetOrderItems(batch, transaction_id, orderItems);
+        batch.execute(); // both vectors are filled in now
+
+- Each query is added with its parameters and a reader. execute() joins the queries (and their parameters, in order),
+  runs them together, then calls each reader on its query's result set, moving on with SQLMoreResults.
+- Each query must be one SELECT ending with ';' that returns exactly one result set.
+
+NOTE: The readers are called while the batch is still open, so they should only read the current result set
+    (like with a RowMapper), and not run queries of their own.
+NOTE: This is OdbcBackend's ReadBatch, so the managers' batchGet functions take a ReadBatch and use from() to get back here.
+*/
+class QueryBatch : public ReadBatch {
+public:
+    typedef std::function<void(DBConn&)> ResultReader;
+
+    QueryBatch(ConnectionPool& connectionPool) : connectionPool(connectionPool) {}
+
+    // The QueryBatch behind batch; throws if batch came from some other backend
+    static QueryBatch& from(ReadBatch& batch) {
+        QueryBatch* queryBatch = dynamic_cast<QueryBatch*>(&batch);
+        if (queryBatch == nullptr) {
+            throw std::runtime_error("A SQL Server manager was given a read batch from another storage backend!");
+        }
+        return *queryBatch;
+    }
+
+    void add(const std::string& sqlQuery, std::vector<SQLParam> queryParams, ResultReader reader) {
+        batchQuery += sqlQuery;
+        batchQuery += "\n";
+        for (size_t i = 0; i < queryParams.size(); i++) {
+            params.push_back(std::move(queryParams[i]));
+        }
+        readers.push_back(std::move(reader));
+    }
+
+    size_t size() const {
+        return readers.size();
+    }
+
+    // Runs the batch and calls each reader on its result set; the batch is emptied either way
+    void execute() override {
+        std::string sqlQuery;
+        std::vector<SQLParam> sqlParams;
+        std::vector<ResultReader> resultReaders;
+        sqlQuery.swap(batchQuery);
+        sqlParams.swap(params);
+        resultReaders.swap(readers);
+        if (resultReaders.empty()) {
+            return;
+        }
+
+        DBConnLease dbConn = connectionPool.acquire();
+        if (!dbConn->executeBatch(sqlQuery, std::move(sqlParams))) {
+            throw std::runtime_error("Failed to execute query batch!");
+        }
+
+        try {
+            for (size_t i = 0; i < resultReaders.size(); i++) {
+                if (i > 0 && !dbConn->nextResultSet()) {
+                    throw std::runtime_error("Query batch returned fewer result sets than queries!");
+                }
+                resultReaders[i](*dbConn);
+            }
+        }
+        catch (...) {
+            dbConn->endBatch();
+            throw;
+        }
+        dbConn->endBatch();
+    }
+
+private:
+    ConnectionPool& connectionPool;
+    std::string batchQuery;
+    std::vector<SQLParam> params;
+    std::vector<ResultReader> readers;
+};
+
+#endif
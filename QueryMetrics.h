@@ -0,0 +1,333 @@
+#ifndef QueryMetrics_H
+#define QueryMetrics_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <ostream>
+#include <iomanip>
+
+/*
++ LatencyHistogram: Counts latencies (in microseconds) in log-linear buckets, like an HDR histogram, so percentiles can be
+    read back without keeping every sample.
+
+- Values under 16us get a bucket each. After that, every power of two is split into 16 buckets, so a percentile is
+  never off by more than 1/16 (about 6%) of its value, and the whole range up to days fits in a few hundred buckets.
+- percentile() returns the highest value that falls in the bucket the percentile lands in.
+*/
+class LatencyHistogram {
+public:
+    LatencyHistogram() : counts(BUCKET_COUNT, 0), total(0) {}
+
+    void add(unsigned long long micros) {
+        counts[bucketOf(micros)]++;
+        total++;
+    }
+
+    // Adds other's latencies to these, like when each thread kept its own histogram
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < counts.size(); i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+    }
+
+    // p is from 0 to 100, like 99 for the 99th percentile; returns 0 if nothing was added
+    unsigned long long percentile(double p) const {
+        if (total == 0) {
+            return 0;
+        }
+        unsigned long long rank = static_cast<unsigned long long>(p / 100.0 * total + 0.5);
+        if (rank < 1) {
+            rank = 1;
+        }
+        unsigned long long seen = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return highestValueOf(i);
+            }
+        }
+        return highestValueOf(counts.size() - 1);
+    }
+
+private:
+    enum {
+        SUB_BUCKET_BITS = 4,
+        SUB_BUCKETS = 1 << SUB_BUCKET_BITS,
+        MAX_EXPONENT = 40, // 2^40us is about 12 days; anything longer goes in the last bucket
+        BUCKET_COUNT = SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS
+    };
+
+    std::vector<unsigned long long> counts;
+    unsigned long long total;
+
+    static size_t bucketOf(unsigned long long value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<size_t>(value);
+        }
+        int exponent = 0;
+        while ((value >> (exponent + 1)) != 0) {
+            exponent++;
+        }
+        if (exponent > MAX_EXPONENT) {
+            return BUCKET_COUNT - 1;
+        }
+        // The SUB_BUCKET_BITS bits after the leading one pick the bucket within this power of two
+        size_t subBucket = static_cast<size_t>((value >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+        return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * SUB_BUCKETS + subBucket;
+    }
+
+    static unsigned long long highestValueOf(size_t bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        int shift = static_cast<int>((bucket - SUB_BUCKETS) / SUB_BUCKETS);
+        unsigned long long subBucket = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+        unsigned long long lowest = (SUB_BUCKETS + subBucket) << shift;
+        return lowest + (1ULL << shift) - 1;
+    }
+};
+
+
+/*
++ QueryMetrics: Records how long each kind of statement takes, so we can find the hot queries among the managers
+    without attaching a profiler. Turn it on with ConnectionPool::setQueryMetrics; every DBConn then records into it.
+
+- Statements are grouped by their fingerprint: the SQL text with literals replaced by '?', whitespace collapsed,
+  and lists of values collapsed (see fingerprint()). So "WHERE transaction_id=5" and "WHERE transaction_id=6" are
+  the same shape, and so are IN lists of any length.
+- For each shape we keep the number of calls (and how many failed), total/min/max latency, a latency histogram for
+  percentiles, the rows fetched, and the bytes of parameters bound.
+- A call's latency is the time spent in the driver for it: executing, plus every fetch of its result set. Time the
+  caller spends between fetches (building objects and such) isn't counted.
+- printReport dumps the shapes, most total time first, and startReporting prints that every so often from a
+  background thread.
+
+NOTE: One mutex guards everything, and it's only held to add a finished call, which is nothing next to a round trip
+    to the server. Fingerprints are made before taking it.
+*/
+class QueryMetrics {
+public:
+    struct ShapeStats {
+        std::string fingerprint;
+        unsigned long long calls = 0;
+        unsigned long long failures = 0;
+        unsigned long long totalMicros = 0;
+        unsigned long long minMicros = 0;
+        unsigned long long maxMicros = 0;
+        unsigned long long rowsFetched = 0;
+        unsigned long long bytesBound = 0;
+        LatencyHistogram histogram;
+
+        double getAverageMicros() const {
+            return calls == 0 ? 0.0 : static_cast<double>(totalMicros) / calls;
+        }
+
+        // The histogram's percentile, kept between min and max since a bucket can reach past the values in it
+        unsigned long long getPercentileMicros(double p) const {
+            return std::max(minMicros, std::min(maxMicros, histogram.percentile(p)));
+        }
+    };
+
+    QueryMetrics() : isReporting(false) {}
+
+    QueryMetrics(const QueryMetrics&) = delete;
+    QueryMetrics& operator=(const QueryMetrics&) = delete;
+
+    ~QueryMetrics() {
+        stopReporting();
+    }
+
+    /*
+    + Returns the shape of sqlQuery: string and number literals become '?', runs of whitespace become one space, and a
+      list like "?, ?, ?" becomes "?, ...".
+
+    NOTE: Digits that are part of a name (like Order_Items2 or a savepoint called scope_1) are left alone.
+    */
+    static std::string fingerprint(const std::string& sqlQuery) {
+        std::string shape;
+        shape.reserve(sqlQuery.size());
+        const size_t size = sqlQuery.size();
+        size_t i = 0;
+        while (i < size) {
+            char c = sqlQuery[i];
+            if (c == '\'') {
+                // String literal; '' inside of one is an escaped quote
+                i++;
+                while (i < size) {
+                    if (sqlQuery[i] == '\'') {
+                        if (i + 1 < size && sqlQuery[i + 1] == '\'') {
+                            i += 2;
+                            continue;
+                        }
+                        break;
+                    }
+                    i++;
+                }
+                i++;
+                addPlaceholder(shape);
+            }
+            else if (isDigit(c) && (shape.empty() || !isNameChar(shape.back()))) {
+                while (i < size && (isDigit(sqlQuery[i]) || sqlQuery[i] == '.')) {
+                    i++;
+                }
+                addPlaceholder(shape);
+            }
+            else if (c == '?') {
+                i++;
+                addPlaceholder(shape);
+            }
+            else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                while (i < size && (sqlQuery[i] == ' ' || sqlQuery[i] == '\t' || sqlQuery[i] == '\n' || sqlQuery[i] == '\r')) {
+                    i++;
+                }
+                if (!shape.empty() && i < size) {
+                    shape += ' ';
+                }
+            }
+            else {
+                shape += c;
+                i++;
+            }
+        }
+        return shape;
+    }
+
+    // Adds one finished call to its shape's numbers
+    void record(const std::string& fingerprint, unsigned long long micros, unsigned long long rowsFetched, unsigned long long bytesBound, bool failed) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ShapeStats& shape = shapes[fingerprint];
+        if (shape.calls == 0) {
+            shape.fingerprint = fingerprint;
+            shape.minMicros = micros;
+        }
+        shape.calls++;
+        if (failed) {
+            shape.failures++;
+        }
+        shape.totalMicros += micros;
+        shape.minMicros = std::min(shape.minMicros, micros);
+        shape.maxMicros = std::max(shape.maxMicros, micros);
+        shape.rowsFetched += rowsFetched;
+        shape.bytesBound += bytesBound;
+        shape.histogram.add(micros);
+    }
+
+    // Copies of every shape's numbers, most total time first
+    std::vector<ShapeStats> getSnapshot() {
+        std::vector<ShapeStats> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            snapshot.reserve(shapes.size());
+            for (std::map<std::string, ShapeStats>::const_iterator it = shapes.begin(); it != shapes.end(); ++it) {
+                snapshot.push_back(it->second);
+            }
+        }
+        std::sort(snapshot.begin(), snapshot.end(), [](const ShapeStats& a, const ShapeStats& b) { return a.totalMicros > b.totalMicros; });
+        return snapshot;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        shapes.clear();
+    }
+
+    // Prints the top shapes by total time (all of them if top is 0); times are in milliseconds
+    void printReport(std::ostream& os, size_t top = 0) {
+        std::vector<ShapeStats> snapshot = getSnapshot();
+        if (top == 0 || top > snapshot.size()) {
+            top = snapshot.size();
+        }
+        os << "<QueryMetrics shapes(" << snapshot.size() << ")>" << std::endl;
+        std::ios::fmtflags flags = os.flags();
+        std::streamsize precision = os.precision();
+        os << std::fixed << std::setprecision(3);
+        for (size_t i = 0; i < top; i++) {
+            const ShapeStats& shape = snapshot[i];
+            os << "  calls(" << shape.calls << "), failures(" << shape.failures << "), total(" << shape.totalMicros / 1000.0
+                << "), avg(" << shape.getAverageMicros() / 1000.0 << "), min(" << shape.minMicros / 1000.0
+                << "), p50(" << shape.getPercentileMicros(50) / 1000.0 << "), p95(" << shape.getPercentileMicros(95) / 1000.0
+                << "), p99(" << shape.getPercentileMicros(99) / 1000.0 << "), max(" << shape.maxMicros / 1000.0
+                << "), rows(" << shape.rowsFetched << "), bytes bound(" << shape.bytesBound << ")" << std::endl
+                << "    " << shape.fingerprint << std::endl;
+        }
+        os.flags(flags);
+        os.precision(precision);
+        os << "</QueryMetrics>" << std::endl;
+    }
+
+    // Prints the report to os every interval from a background thread, until stopReporting (or the destructor)
+    void startReporting(std::ostream& os, std::chrono::milliseconds interval, size_t top = 10) {
+        stopReporting();
+        isReporting = true;
+        reporter = std::thread([this, &os, interval, top]() {
+            std::unique_lock<std::mutex> lock(reportMutex);
+            while (!reportStopped.wait_for(lock, interval, [this] { return !isReporting; })) {
+                printReport(os, top);
+            }
+        });
+    }
+
+    void stopReporting() {
+        {
+            std::lock_guard<std::mutex> lock(reportMutex);
+            isReporting = false;
+        }
+        reportStopped.notify_all();
+        if (reporter.joinable()) {
+            reporter.join();
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::map<std::string, ShapeStats> shapes; // Keyed by fingerprint
+
+    std::mutex reportMutex;
+    std::condition_variable reportStopped;
+    bool isReporting;
+    std::thread reporter;
+
+    static bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    static bool isNameChar(char c) {
+        return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '@' || c == '#' || c == '$';
+    }
+
+    // Adds a '?', unless it continues a list of them: "?, ?" becomes "?, ...", and "?, ..., ?" stays "?, ..."
+    static void addPlaceholder(std::string& shape) {
+        static const std::string collapsed = "?, ...";
+
+        // Look back past "<spaces>,<spaces>" for the end of the list so far
+        size_t end = shape.size();
+        while (end > 0 && shape[end - 1] == ' ') {
+            end--;
+        }
+        if (end > 0 && shape[end - 1] == ',') {
+            end--;
+            while (end > 0 && shape[end - 1] == ' ') {
+                end--;
+            }
+            if (end >= collapsed.size() && shape.compare(end - collapsed.size(), collapsed.size(), collapsed) == 0) {
+                shape.erase(end);
+                return;
+            }
+            if (end > 0 && shape[end - 1] == '?') {
+                shape.erase(end);
+                shape += ", ...";
+                return;
+            }
+        }
+        shape += '?';
+    }
+};
+
+#endif
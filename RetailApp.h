@@ -5,14 +5,12 @@
 #include <vector>
 #include <tuple>
 #include <map>
+#include <future>
+#include <memory>
 
-// Include managers for managing different tables
-#include "CustomerManager.h"
-#include "SupplierManager.h"
-#include "ProductManager.h"
-#include "CartItemManager.h"
-#include "TransactionManager.h"
-#include "OrderItemManager.h"
+// Include the storage interfaces for the different tables
+#include "StorageBackend.h"
+#include "CheckoutQueue.h"
 
 // Include object representations of rows in our database
 #include "Customer.h"
@@ -27,12 +25,15 @@
 
 class RetailApp {
 private:
-	CustomerManager& customerManager;
-	SupplierManager& supplierManager;
-	ProductManager& productManager;
-	CartItemManager& cartItemManager;
-	TransactionManager& transactionManager;
-	OrderItemManager& orderItemManager;
+	StorageBackend& backend; // For transactions, read batches and async reads that span several managers
+	CustomerStore& customerManager;
+	SupplierStore& supplierManager;
+	ProductStore& productManager;
+	CartItemStore& cartItemManager;
+	TransactionStore& transactionManager;
+	OrderItemStore& orderItemManager;
+	CheckoutStore& checkoutManager;
+	CheckoutQueue* checkoutQueue = nullptr; // If set, checkouts go through the group-commit queue instead of straight to checkoutManager
 
 
 	/*
@@ -47,26 +48,28 @@ private:
 	Customer currentCustomer;
 
 public:
-	RetailApp(
-		CustomerManager& customerManager, 
-		SupplierManager& supplierManager,
-		ProductManager& productManager,
-		CartItemManager& cartItemManager,
-		TransactionManager& transactionManager,
-		OrderItemManager& orderItemManager
-		) : 
-		customerManager(customerManager),
-		supplierManager(supplierManager), 
-		productManager(productManager),
-		cartItemManager(cartItemManager),
-		transactionManager(transactionManager),
-		orderItemManager(orderItemManager) {}
-
+	// Runs the store on backend: an OdbcBackend for SQL Server, or an InProcessBackend to keep everything in memory
+	RetailApp(StorageBackend& backend) :
+		backend(backend),
+		customerManager(backend.getCustomerStore()),
+		supplierManager(backend.getSupplierStore()),
+		productManager(backend.getProductStore()),
+		cartItemManager(backend.getCartItemStore()),
+		transactionManager(backend.getTransactionStore()),
+		orderItemManager(backend.getOrderItemStore()),
+		checkoutManager(backend.getCheckoutStore()) {}
+
+
+	// Sends checkouts through a group-commit queue (see CheckoutQueue); pass nullptr to go back to checking out directly
+	void setCheckoutQueue(CheckoutQueue* queue) {
+		checkoutQueue = queue;
+	}
 
 	// ********** Functions for customer related operations ********** 	
 
 	// Displays and starts the customer menu
 	void handleCustomerMenu() {
+		QueryCaller queryCaller("RetailApp::handleCustomerMenu");
 		int choice;
 
 		do {
@@ -124,6 +127,7 @@ public:
 
 	// Prompts input for creating a customer 
 	void handleCreateCustomer() {		
+		QueryCaller queryCaller("RetailApp::handleCreateCustomer");
 		std::string fname, lname, email;
 		int points = 0;
 		
@@ -152,16 +156,17 @@ public:
 		customer menu if the ID didn't correlate to a customer in the database.
 	*/
 	void handleUpdateCustomer() {
+		QueryCaller queryCaller("RetailApp::handleUpdateCustomer");
 
 		// Fetch all customers
-		std::vector<Customer> customers = customerManager.getAllCustomers();
-		if (customers.size() == 0) {
+		PageSource<Customer> customers = customerManager.getCustomerPages(5);
+		if (customers.getTotalItems() == 0) {
 			std::cout << "No customers available to update!" << std::endl;
 			return;
 		}
 
 		// Prompt user to pick customer to update from a paginated menu
-		Customer customer = selectPaginatedItems<Customer>(customers, 5, "Customer Menu List", "Enter list number for customer we're updating");
+		Customer customer = selectPaginatedItems<Customer>(customers, "Customer Menu List", "Enter list number for customer we're updating");
 
 		// IF they didn't pick a customer, stop function early
 		if (!customer) {
@@ -221,16 +226,17 @@ public:
 
 	// Handles prompting input to delete a customer
 	void handleDeleteCustomer() {
+		QueryCaller queryCaller("RetailApp::handleDeleteCustomer");
 
 		// Fetch all customers
-		std::vector<Customer> customers = customerManager.getAllCustomers();
-		if (customers.size() == 0) {
+		PageSource<Customer> customers = customerManager.getCustomerPages(5);
+		if (customers.getTotalItems() == 0) {
 			std::cout << "No customers available to delete!" << std::endl;
 			return;
 		}
 
 		// Prompt user to pick customer to delete from a paginated menu
-		Customer customer = selectPaginatedItems<Customer>(customers, 5, "Customer Menu List", "Enter list number for customer we're removing");
+		Customer customer = selectPaginatedItems<Customer>(customers, "Customer Menu List", "Enter list number for customer we're removing");
 
 		// IF they didn't pick a customer, stop function early
 		if (!customer) {
@@ -241,12 +247,11 @@ public:
 		const int customer_id = customer.getCustomerID();
 
 		/*
-		- If the customer we are deleting is also the currently selected customer
-		- reset currentCustomerID back to 0 to indicate no customer is currently selected.
+		- Do all of the deletes in one transaction. If one of them fails, the transaction rolls back the ones before it
+		when it's destroyed, so we don't end up with a customer whose cart was emptied but is still there. It's also
+		one log flush at commit rather than one per statement.
 		*/
-		if (customer.getCustomerID() == currentCustomerID) {
-			currentCustomerID = 0;
-		}
+		std::unique_ptr<StorageTransaction> transaction = backend.beginTransaction();
 		
 		// Delete all cart items that reference the customer that's going to be deleted
 		cartItemManager.deleteByCustomerID(customer_id);
@@ -256,11 +261,21 @@ public:
 
 		// Delete customer, and on success display that the customer was successfully deleted.
 		customerManager.deleteCustomer(customer_id);
+		transaction->commit();
+
+		/*
+		- If the customer we deleted is also the currently selected customer
+		- reset currentCustomerID back to 0 to indicate no customer is currently selected.
+		*/
+		if (customer.getCustomerID() == currentCustomerID) {
+			currentCustomerID = 0;
+		}
 		std::cout << "Customer Deleted: " << customer << std::endl;
 	}
 
 	// Handles prompting input for customer_id and searching for said customer in database
 	void handleGetCustomerByID() {
+		QueryCaller queryCaller("RetailApp::handleGetCustomerByID");
 		// Prompt input on the ID of the customer that we will search for; ensure it's a valid integer. 
 		int customer_id = getValidNumericInput<int>("Enter a ID customer you want to see: ");
 		
@@ -271,28 +286,29 @@ public:
 
 	// Handles displaying all rows in customers table (if any)
 	void displayAllCustomers() {
-		std::vector<Customer> customers = customerManager.getAllCustomers();
+		PageSource<Customer> customers = customerManager.getCustomerPages(5);
 
 		// If no customers, display message and stop function execution early.
-		if (customers.size() == 0) {
+		if (customers.getTotalItems() == 0) {
 			std::cout << "No customers to display!" << std::endl;
 			return;
 		}
 
 		// Call function to display paginated list of customers
-		navigatePaginatedItems<Customer>(customers, 5, "Customer Menu List");
+		navigatePaginatedItems<Customer>(customers, "Customer Menu List");
 	}
 
 	// Updates the current customer we're managing
 	void handleSelectCustomer() {
-		std::vector<Customer> customers = customerManager.getAllCustomers();
-		if (customers.size() == 0) {
+		QueryCaller queryCaller("RetailApp::handleSelectCustomer");
+		PageSource<Customer> customers = customerManager.getCustomerPages(5);
+		if (customers.getTotalItems() == 0) {
 			std::cout << "No customers available to select!" << std::endl;
 			return;
 		}
 
 		// Prompt user to pick customer to select from a paginated menu
-		Customer customer = selectPaginatedItems<Customer>(customers, 5, "Customer Menu List", "Enter list number for customer we're selecting");
+		Customer customer = selectPaginatedItems<Customer>(customers, "Customer Menu List", "Enter list number for customer we're selecting");
 
 		// IF they didn't pick a customer, stop function early
 		if (!customer) {
@@ -313,6 +329,7 @@ public:
 
 	// Displays and starts the supplier menu
 	void handleSupplierMenu() {
+		QueryCaller queryCaller("RetailApp::handleSupplierMenu");
 		int choice;
 
 		do {
@@ -367,6 +384,7 @@ public:
 	
 	// Handles prompting input for creating a supplier
 	void handleCreateSupplier() {		
+		QueryCaller queryCaller("RetailApp::handleCreateSupplier");
 		// Ignore to newline
 		std::cin.ignore();
 
@@ -392,16 +410,17 @@ public:
 
 	// Handles prompting input for updating the attributes of a supplier
 	void handleUpdateSupplier() {
+		QueryCaller queryCaller("RetailApp::handleUpdateSupplier");
 
 		// Fetch all suppliers
-		std::vector<Supplier> suppliers = supplierManager.getAllSuppliers();
-		if (suppliers.size() == 0) {
+		PageSource<Supplier> suppliers = supplierManager.getSupplierPages(5);
+		if (suppliers.getTotalItems() == 0) {
 			std::cout << "No suppliers available to update!" << std::endl;
 			return;
 		}
 
 		// Prompt user to pick supplier to update from a paginated menu
-		Supplier supplier = selectPaginatedItems<Supplier>(suppliers, 5, "Supplier Menu List", "Enter list number for supplier we're updating");
+		Supplier supplier = selectPaginatedItems<Supplier>(suppliers, "Supplier Menu List", "Enter list number for supplier we're updating");
 
 		// IF they didn't pick a supplier, stop function early
 		if (!supplier) {
@@ -470,15 +489,16 @@ public:
 
 	// Prompts input for deleting a supplier 
 	void handleDeleteSupplier() {
+		QueryCaller queryCaller("RetailApp::handleDeleteSupplier");
 		// Fetch all suppliers
-		std::vector<Supplier> suppliers = supplierManager.getAllSuppliers();
-		if (suppliers.size() == 0) {
+		PageSource<Supplier> suppliers = supplierManager.getSupplierPages(5);
+		if (suppliers.getTotalItems() == 0) {
 			std::cout << "No suppliers available to delete!" << std::endl;
 			return;
 		}
 
 		// Prompt user to pick supplier to update from a paginated menu
-		Supplier supplier = selectPaginatedItems<Supplier>(suppliers, 5, "Supplier Menu List", "Enter list number for supplier we're deleting");
+		Supplier supplier = selectPaginatedItems<Supplier>(suppliers, "Supplier Menu List", "Enter list number for supplier we're deleting");
 
 		// IF they didn't pick a supplier, stop function early
 		if (!supplier) {
@@ -488,6 +508,9 @@ public:
 		// extract supplier_id
 		const int supplier_id = supplier.getSupplierID();
 
+		// Delete everything that goes with the supplier in one transaction; all of it happens, or none of it does
+		std::unique_ptr<StorageTransaction> transaction = backend.beginTransaction();
+
 		// Delete all cart items that reference a product, where the product has a supplier_id of the deleted supplier
 		cartItemManager.deleteBySupplierID(supplier_id);
 
@@ -499,11 +522,13 @@ public:
 
 		// Then delete the supplier, which will also delete the supplier name
 		supplierManager.deleteSupplier(supplier_id);
+		transaction->commit();
 		std::cout << "Supplier Deleted: " << supplier << std::endl;
 	}
 	
 	// Prompts input for supplier ID and then displaying that supplier
 	void handleGetSupplierByID() {
+		QueryCaller queryCaller("RetailApp::handleGetSupplierByID");
 		// Prompt input on the ID of the supplier that we will search for; ensure it's a valid integer. 
 		int supplier_id = getValidNumericInput<int>("Enter the ID of the supplier you want to display: ");
 		
@@ -523,15 +548,15 @@ public:
 	// Display all suppliers in the database
 	void displayAllSuppliers() {
 		// Get all suppliers from the database
-		std::vector<Supplier> suppliers = supplierManager.getAllSuppliers();
+		PageSource<Supplier> suppliers = supplierManager.getSupplierPages(5);
 
 		// Check to see if vector is empty; if so then stop execution early
-		if (suppliers.size() == 0) {
+		if (suppliers.getTotalItems() == 0) {
 			std::cout << "No suppliers to display!" << std::endl;
 			return;
 		}
 
-		navigatePaginatedItems<Supplier>(suppliers, 5, "Supplier Menu List");
+		navigatePaginatedItems<Supplier>(suppliers, "Supplier Menu List");
 		
 	}
 
@@ -539,6 +564,7 @@ public:
 
 	// Handles displaying and managing the product menu
 	void handleProductMenu() {
+		QueryCaller queryCaller("RetailApp::handleProductMenu");
 		int choice;
 		do {
 			try {
@@ -592,6 +618,7 @@ public:
 
 	// Prompts input for creating a new product
 	void handleCreateProduct() {
+		QueryCaller queryCaller("RetailApp::handleCreateProduct");
 		// Ignore to newline so our getlines work
 		std::cin.ignore();
 
@@ -633,16 +660,17 @@ public:
 
 	// Prompts input for updating an existing product 
 	void handleUpdateProduct() {
+		QueryCaller queryCaller("RetailApp::handleUpdateProduct");
 
 		// Fetch all products
-		std::vector<Product> products = productManager.getAllProducts();
-		if (products.size() == 0) {
+		PageSource<Product> products = productManager.getProductPages(5);
+		if (products.getTotalItems() == 0) {
 			std::cout << "No products available to update!" << std::endl;
 			return;
 		}
 
 		// Prompt user to pick product to update from a paginated menu
-		Product product = selectPaginatedItems<Product>(products, 5, "Product Menu List", "Enter list number for product we're updating");
+		Product product = selectPaginatedItems<Product>(products, "Product Menu List", "Enter list number for product we're updating");
 
 		// IF they didn't pick a product, stop function early
 		if (!product) {
@@ -706,16 +734,17 @@ public:
 
 	// Prompts input for deleting an existing product
 	void handleDeleteProduct() {
+		QueryCaller queryCaller("RetailApp::handleDeleteProduct");
 
 		// Fetch all products
-		std::vector<Product> products = productManager.getAllProducts();
-		if (products.size() == 0) {
+		PageSource<Product> products = productManager.getProductPages(5);
+		if (products.getTotalItems() == 0) {
 			std::cout << "No products available to delete!" << std::endl;
 			return;
 		}
 
 		// Prompt user to pick product to update from a paginated menu
-		Product product = selectPaginatedItems<Product>(products, 5, "Product Menu List", "Enter list number for product we're deleting");
+		Product product = selectPaginatedItems<Product>(products, "Product Menu List", "Enter list number for product we're deleting");
 
 		// IF they didn't pick a product, stop function early
 		if (!product) {
@@ -725,6 +754,9 @@ public:
 		// extract supplier_id
 		const int product_id = product.getProductID();
 
+		// Delete the product and its references in one transaction
+		std::unique_ptr<StorageTransaction> transaction = backend.beginTransaction();
+
 		// Delete all cart items that reference the product being deleted
 		cartItemManager.deleteByProductID(product_id);
 
@@ -733,16 +765,21 @@ public:
 
 		// Then delete the product
 		productManager.deleteProduct(product_id);
+		transaction->commit();
 		std::cout << "Deleted Product: " << product << std::endl;
 	}
 
 	// Handles prompting input for product_id and displaying detailed product information 
 	void handleGetProductByID() {
+		QueryCaller queryCaller("RetailApp::handleGetProductByID");
 		// Prompt input on the ID of the customer that we will search for; ensure it's a valid integer. 
 		int product_id = getValidNumericInput<int>("Enter the ID of the product you want to display: ");
 
 		// Fetch the customer and print them
 		Product product = productManager.getProductByID(product_id);
+		if (!product.hasDescription()) {
+			product.setDescription(productManager.getProductDescription(product_id));
+		}
 
 		std::cout << "Found Product: " << std::endl;
 		std::cout << product << std::endl;
@@ -751,16 +788,16 @@ public:
 
 	// Handles displaying all products in the database
 	void displayAllProducts() {
-		std::vector<Product> products = productManager.getAllProducts();
+		PageSource<Product> products = productManager.getProductPages(5);
 
 		// Check to see if vector is empty; if so then stop execution early
-		if (products.size() == 0) {
+		if (products.getTotalItems() == 0) {
 			std::cout << "No products to display!" << std::endl;
 			return;
 		}
 
 		// There are suppliers, so display them.
-		navigatePaginatedItems<Product>(products, 5, "Product Menu List");
+		navigatePaginatedItems<Product>(products, "Product Menu List");
 	}
 
 	// ********** Functions for Shopping-Cart related operations ********** 
@@ -770,6 +807,7 @@ public:
 	NOTE: currentCustomerID has to be defined and reference a currently existing customer before proceeding any further into the cart menu. This is because all of the operations are going to be related to a given customer's shopping cart.
 	*/
 	void handleCartMenu() {
+		QueryCaller queryCaller("RetailApp::handleCartMenu");
 		int choice;
 
 		// Verify that currentCustomerID is defined and references a customer in the database
@@ -778,7 +816,18 @@ public:
 			return;
 		}
 
-		currentCustomer = customerManager.getCustomerByID(currentCustomerID);
+		// Get the customer and their cart in one round trip, so we can also show how full their cart already is
+		std::unique_ptr<ReadBatch> batch = backend.newReadBatch();
+		std::vector<Customer> customers;
+		std::vector<CartItem> cartItems;
+		customerManager.batchGetCustomerByID(*batch, currentCustomerID, customers);
+		cartItemManager.batchGetCustomerCartItems(*batch, currentCustomerID, cartItems);
+		batch->execute();
+		if (customers.empty()) {
+			throw std::runtime_error("Customer with ID '" + std::to_string(currentCustomerID) + "' wasn't found!");
+		}
+		currentCustomer = customers[0];
+		std::cout << "Items in cart: " << cartItems.size() << std::endl;
 
 		do {
 			try {
@@ -832,16 +881,17 @@ public:
 
 	// Handles input for adding a new product to cart
 	void handleAddToCart() {
+		QueryCaller queryCaller("RetailApp::handleAddToCart");
 		// Only fetch products are in stock and available; 
 		// If there are no items available to be put in the cart, return early
-		std::vector<Product> products = productManager.getAvailableProducts();
-		if (products.size() == 0) {
+		PageSource<Product> products = productManager.getProductPages(5, true);
+		if (products.getTotalItems() == 0) {
 			std::cout << "No available items to add to cart!" << std::endl;
 			return;
 		}
 
 		// prompt user to potentially pick a product to add to cart
-		Product product = selectPaginatedItems<Product>(products, 5, "Product Menu", "Enter list number of product you're adding");
+		Product product = selectPaginatedItems<Product>(products, "Product Menu", "Enter list number of product you're adding");
 		
 		// If user didn't pick a product to be added to cart
 		if (!product) {
@@ -874,6 +924,7 @@ public:
 
 	// Handles input for removing a product from the cart 
 	void handleRemoveFromCart() {
+		QueryCaller queryCaller("RetailApp::handleRemoveFromCart");
 
 		// Get a customer's cart items
 		std::vector<CartItem> cartItems = cartItemManager.getCustomerCartItems(currentCustomerID);
@@ -897,6 +948,7 @@ public:
 
 	// Handles input for updating an item's quantity when in cart
 	void handleUpdateCartItem() {
+		QueryCaller queryCaller("RetailApp::handleUpdateCartItem");
 		// Get a customer's cart items
 		std::vector<CartItem> cartItems = cartItemManager.getCustomerCartItems(currentCustomerID);
 		if (cartItems.size() == 0) {
@@ -960,6 +1012,10 @@ public:
 
 	// Handles checking out the cart
 	void handleCheckout() {
+		QueryCaller queryCaller("RetailApp::handleCheckout");
+
+		// Fetch the customer on another thread (and connection) while we fetch their cart items, since neither needs the other
+		std::future<Customer> customerFuture = backend.runAsync([this]() { return customerManager.getCustomerByID(currentCustomerID); });
 
 		// Fetch cart items for the customer
 		std::vector<CartItem> cartItems = cartItemManager.getCustomerCartItems(currentCustomerID);
@@ -968,48 +1024,20 @@ public:
 			return;
 		}
 
-		// Get vector of product ID values for products in the customer's cart.
-		std::vector<int> productIDs;
-		for (size_t i = 0; i < cartItems.size(); i++) {
-			int product_id = cartItems[i].getProductID();
-			productIDs.push_back(product_id);
-		}
-
 		/*
-		- productQuantityMap: Get a map of key product_id and value quantity in stock for that product
-		- newProductQuantities: Vector of tuples in form (product_id, qty), where qty is going to be the updated number in stock for the product (num in stock - num in cart)
-		*/
-		std::map<int, int> productQuantityMap = productManager.getProductQuantities(productIDs);
-		std::vector<std::tuple<int, int>> newProductQuantities;
-
+		- Total in your cart. 
 
-		// Total in your cart.
+		NOTE: We don't check the stock here anymore. The checkout procedure only takes stock from products that have
+		enough of it, and tells us which product didn't. Checking here too would just be an extra round trip, and the stock
+		could still change before the checkout runs.
+		*/
 		float total = 0;
-
-		// Check if each cart item's qty (num in cart) doesn't exceed the product's qty (num in stock)
 		for (size_t i = 0; i < cartItems.size(); i++) {
-			int product_id = cartItems[i].getProductID();
-			int numInCart = cartItems[i].getQty();
-			int numInStock = productQuantityMap[product_id];
-			if (numInCart > numInStock) {
-				std::cout << "Product '" << cartItems[i].getProductName() << "' has a quantity (" << numInCart
-					<< ") in your cart that exceeds the available stock (" << numInStock << ")" << std::endl;
-				return;
-			}
-
-			// Calculate the new product qty 
-			int updatedNumInStock = numInStock - numInCart;
-
-			// Add the total for that item
 			total += cartItems[i].getTotal();
-
-			// Push a tuple into newProductQuantities
-			newProductQuantities.push_back(std::make_tuple(product_id, updatedNumInStock));
-
 		}
 
 
-		Customer customer = customerManager.getCustomerByID(currentCustomerID);
+		Customer customer = customerFuture.get();
 		int customerPoints = customer.getPoints();
 		int usedPoints = 0;
 
@@ -1044,8 +1072,11 @@ public:
 		final total. For example, if total is $250 and they spent 100 points, the 
 		final total is now $150. We'll then use this total to calculate the points.
 		As a result, they earn 15 points rather than 25 points, because in reality they only spent $150.
+
+		NOTE: The checkout procedure does the same calculation when it updates their points, this is just to let them know.
 		*/
 		int earnedPoints = calculatePointsFromCost(total);
+		std::cout << "You'll earn '" << earnedPoints << "' points from this order!" << std::endl;
 
 		// Have confirmation that the user wants to checkout their cart
 		char choice = promptYesOrNo("Do you want to confirm your checkout? (y/n): ");
@@ -1055,50 +1086,57 @@ public:
 		}
 
 		/*
-		- Quantities are within limits, and loop calculated cart total. Shopping cart is ready for checkout. Now create new row in transaction table.
+		- Check out the cart in one trip to the database. In one transaction, the procedure takes the stock for each product, creates the 
+		transaction and its order items, clears the cart, and updates the customer's points. If anything goes wrong, none of it happens.
 		*/
-		Transaction transaction = transactionManager.createTransaction(currentCustomerID, total);
-		int transaction_id = transaction.getTransactionID();
+		CheckoutStore::CheckoutResult result = checkoutQueue != nullptr
+			? checkoutQueue->submit(currentCustomerID, usedPoints).get()
+			: checkoutManager.checkout(currentCustomerID, usedPoints);
 
-		/*
-		- Create the individual rows in the order items table that are associated with that transaction. 
-		- orderItems: Vector of tuples in form (transaction_id, product_id, qty) that is used to insert the order items in the database.
-		*/
-		std::vector<std::tuple<int, int, int>> orderItems;
+		// The procedure changes product stock without going through productManager, so drop the cart's products from its cache
+		std::vector<int> cartProductIDs;
 		for (size_t i = 0; i < cartItems.size(); i++) {
-			int product_id = cartItems[i].getProductID();
-			int qty = cartItems[i].getQty();
-			orderItems.push_back(std::make_tuple(transaction_id, product_id, qty));
+			cartProductIDs.push_back(cartItems[i].getProductID());
 		}
-		orderItemManager.batchCreateOrderItem(orderItems);
-
-		// Update the quantities in the products table to reflect new quantities after the customer checked out their cart; it seems batchUpdate could be the issue
-		productManager.batchUpdateProductQty(newProductQuantities);
-
-		// Now just clear the customer's cart; just delete all cart items associated with the customer who just checked out their cart.
-		cartItemManager.deleteByCustomerID(currentCustomerID);
-
-		
-		/*
-		- Calculate the total points the customer should have after checking out and update their points column
-		
-		NOTE: In the most extreme case, the customer spends all of their points, so customerPoints and usedPoints cancel out, making it so updatedCustomerPoints = earnedPoints. Then earnedPoints >= 0, so updatedCustomerPoints won't ever be negative, so you don't need a conditional check here.
-		*/
-		
-		int updatedCustomerPoints = customerPoints + earnedPoints - usedPoints;
-		customerManager.updatePoints(currentCustomerID, updatedCustomerPoints);
+		productManager.invalidateCachedProducts(cartProductIDs);
 
+		if (result.status == CheckoutStore::Status::InsufficientStock) {
+			std::string productName = "with ID " + std::to_string(result.productID);
+			for (size_t i = 0; i < cartItems.size(); i++) {
+				if (cartItems[i].getProductID() == result.productID) {
+					productName = cartItems[i].getProductName();
+				}
+			}
+			std::cout << "Product '" << productName << "' has a quantity in your cart that exceeds the available stock!" << std::endl;
+			return;
+		}
+		else if (result.status == CheckoutStore::Status::EmptyCart) {
+			std::cout << "Cannot checkout since no items in Cart!" << std::endl;
+			return;
+		}
+		else if (result.status == CheckoutStore::Status::InsufficientPoints) {
+			std::cout << "Cannot checkout, you don't have enough points anymore!" << std::endl;
+			return;
+		}
+		else if (result.status == CheckoutStore::Status::CustomerNotFound) {
+			std::cout << "Cannot checkout, customer with ID " << currentCustomerID << " no longer exists!" << std::endl;
+			return;
+		}
+		else if (!result.succeeded()) {
+			std::cout << "Cannot checkout, the checkout failed!" << std::endl;
+			return;
+		}
 
 		/*
 		- Update the points value on the currentCustomer object as well to be in sync with the database
 
 		NOTE: This allows us to correctly show off the customer's current point value, without having to fetch the customer from the database.
 		*/
-		currentCustomer.setPoints(updatedCustomerPoints);
+		currentCustomer.setPoints(result.points);
 
 		
 		// Display that transaction went successfully
-		std::cout << "Successful checkout, transaction: " << transaction << std::endl;
+		std::cout << "Successful checkout, transaction: " << result.getTransaction(currentCustomerID) << std::endl;
 	}
 
 
@@ -1121,6 +1159,7 @@ public:
 
 	// Handles displaying and managing transaction menu
 	void handleTransactionMenu() {
+		QueryCaller queryCaller("RetailApp::handleTransactionMenu");
 		int choice;
 		do {
 			try {
@@ -1160,24 +1199,33 @@ public:
 
 	// Handles displaying a paginated menu for the transactions
 	void displayAllTransactions() {
-		std::vector<Transaction> transactions = transactionManager.getAllTransactions();
-		if (transactions.size() == 0) {
+		PageSource<Transaction> transactions = transactionManager.getTransactionPages(5);
+		if (transactions.getTotalItems() == 0) {
 			std::cout << "No transactions to display!" << std::endl;
 			return;
 		}
 
-		navigatePaginatedItems(transactions, 5, "Transaction Menu List");
+		navigatePaginatedItems(transactions, "Transaction Menu List");
 	}
 
 
 	// Handles displaying a transaction and its associated order items
 	void handleGetTransactionByID() {
+		QueryCaller queryCaller("RetailApp::handleGetTransactionByID");
 
 		int transaction_id = getValidNumericInput<int>("Enter ID of the transaction we're viewing: ");
-		Transaction transaction = transactionManager.getTransactionByID(transaction_id);
 
-		// Then find all order_items associated with the transaction
-		std::vector<OrderItem> orderItems = orderItemManager.getOrderItems(transaction.getTransactionID());
+		// Get the transaction and all order_items associated with it in one round trip
+		std::unique_ptr<ReadBatch> batch = backend.newReadBatch();
+		std::vector<Transaction> transactions;
+		std::vector<OrderItem> orderItems;
+		transactionManager.batchGetTransactionByID(*batch, transaction_id, transactions);
+		orderItemManager.batchGetOrderItems(*batch, transaction_id, orderItems);
+		batch->execute();
+		if (transactions.empty()) {
+			throw std::runtime_error("Transaction with ID(" + std::to_string(transaction_id) + ") wasn't found!");
+		}
+		Transaction& transaction = transactions[0];
 
 		// Display transaction and its associated order items
 		std::cout << "Transaction Info: " << std::endl;
@@ -0,0 +1,281 @@
+#ifndef RowMapper_H
+#define RowMapper_H
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <memory>
+#include <stdexcept>
+
+#include "DBConn.h"
+#include "RowStream.h"
+
+/*
++ Column types for RowMapper. Each one describes a column of a result set: the buffer it's bound to (with room
+    for a block of rows), and how to turn row i of that buffer into the value we construct objects with.
+
+- IntColumn: INT column that's never NULL.
+- NullableIntColumn: INT column that can be NULL, which is read as 0 (a valid ID is always a positive integer).
+- FloatColumn: DECIMAL/FLOAT column, fetched as a double and read as a float.
+- StringColumn<MaxLength>: VARCHAR(MaxLength) column. NULL is read as an empty string.
+- DateColumn: DATE column, read as a "year-month-day" string.
+
+NOTE: StringColumn builds the string straight from the buffer with the length the driver gives us in the
+    indicator, so there's no null terminating, no strlen, and no temporary string per row. The string is returned
+    by value so it gets moved into the object being constructed.
+*/
+class IntColumn {
+public:
+    void allocate(SQLULEN blockSize) {
+        values.resize(blockSize);
+    }
+
+    void bind(DBConn& dbConn, int colNum) {
+        dbConn.bindColumn(colNum, SQL_INTEGER, values.data(), sizeof(SQLINTEGER));
+    }
+
+    int get(SQLULEN row) const {
+        return static_cast<int>(values[row]);
+    }
+
+private:
+    std::vector<SQLINTEGER> values;
+};
+
+class NullableIntColumn {
+public:
+    void allocate(SQLULEN blockSize) {
+        values.resize(blockSize);
+        indicators.resize(blockSize);
+    }
+
+    void bind(DBConn& dbConn, int colNum) {
+        dbConn.bindColumn(colNum, SQL_INTEGER, values.data(), sizeof(SQLINTEGER), indicators.data());
+    }
+
+    /*
+    NOTE: The driver doesn't write anything into values[row] when the row's value is NULL, so it still has
+        whatever was there from the previous block. That's why we check the indicator first.
+    */
+    int get(SQLULEN row) const {
+        return indicators[row] == SQL_NULL_DATA ? 0 : static_cast<int>(values[row]);
+    }
+
+private:
+    std::vector<SQLINTEGER> values;
+    std::vector<SQLLEN> indicators;
+};
+
+class FloatColumn {
+public:
+    void allocate(SQLULEN blockSize) {
+        values.resize(blockSize);
+    }
+
+    void bind(DBConn& dbConn, int colNum) {
+        dbConn.bindColumn(colNum, SQL_C_DOUBLE, values.data(), sizeof(SQLFLOAT));
+    }
+
+    float get(SQLULEN row) const {
+        return static_cast<float>(values[row]);
+    }
+
+private:
+    std::vector<SQLFLOAT> values;
+};
+
+template<int MaxLength>
+class StringColumn {
+public:
+    void allocate(SQLULEN blockSize) {
+        values.resize(blockSize * (MaxLength + 1));
+        indicators.resize(blockSize);
+    }
+
+    void bind(DBConn& dbConn, int colNum) {
+        dbConn.bindColumn(colNum, SQL_C_CHAR, values.data(), MaxLength + 1, indicators.data());
+    }
+
+    // Row i's value starts at i * (MaxLength + 1); a value that was cut off is indicated as longer than the buffer
+    std::string get(SQLULEN row) const {
+        SQLLEN length = indicators[row];
+        if (length == SQL_NULL_DATA) {
+            return std::string();
+        }
+        if (length == SQL_NO_TOTAL || length > MaxLength) {
+            length = MaxLength;
+        }
+        const char* value = reinterpret_cast<const char*>(&values[row * (MaxLength + 1)]);
+        return std::string(value, static_cast<size_t>(length));
+    }
+
+private:
+    std::vector<SQLCHAR> values;
+    std::vector<SQLLEN> indicators;
+};
+
+class DateColumn {
+public:
+    void allocate(SQLULEN blockSize) {
+        values.resize(blockSize);
+    }
+
+    void bind(DBConn& dbConn, int colNum) {
+        dbConn.bindColumn(colNum, SQL_C_DATE, values.data(), sizeof(DATE_STRUCT));
+    }
+
+    std::string get(SQLULEN row) const {
+        const DATE_STRUCT& date = values[row];
+        return std::to_string(date.year) + "-" + std::to_string(date.month) + "-" + std::to_string(date.day);
+    }
+
+private:
+    std::vector<DATE_STRUCT> values;
+};
+
+
+/*
++ RowMapper: Reads every row of the current result set into a vector of T, where the result set's columns
+    are described by Columns (in select list order). This is the fetch loop that every manager used to write
+    out by hand: make the buffers, bind each column, fetch blocks of rows, check each row, and build the objects.
+
+- By default each row is built with T's constructor, taking the columns' values in order, with emplace_back, so
+  nothing is copied. For a constructor that doesn't match the select list, pass a function that takes the
+  values and returns the T (which is then moved into the vector).
+- Rows are fetched in blocks (see DBConn::beginBlockFetch). If a fetch fails, the cursor is closed and
+  errorMessage is thrown.
+- stream() is the same thing, but hands the rows out one at a time through a RowStream instead of reading them all
+  into a vector, for result sets that are too big to hold in memory (like a whole table for a report).
+
+Example:
+    typedef RowMapper<OrderItem, IntColumn, IntColumn, NullableIntColumn, IntColumn> OrderItemRowMapper;
+    std::vector<OrderItem> orderItems = OrderItemRowMapper::read(dbConn, "Failed to fetch a given order item!");
+*/
+template<typename T, typename... Columns>
+class RowMapper {
+public:
+    static std::vector<T> read(DBConn& dbConn, const char* errorMessage) {
+        return read(dbConn, errorMessage, Construct());
+    }
+
+    template<typename MakeRow>
+    static std::vector<T> read(DBConn& dbConn, const char* errorMessage, MakeRow makeRow) {
+        std::vector<T> rows;
+        std::tuple<Columns...> columns;
+        const SQLULEN blockSize = dbConn.beginBlockFetch();
+        prepare(dbConn, columns, blockSize, Indexes());
+
+        SQLULEN rowsFetched;
+        while ((rowsFetched = fetchBlock(dbConn, errorMessage)) > 0) {
+            rows.reserve(rows.size() + rowsFetched);
+            for (SQLULEN i = 0; i < rowsFetched; i++) {
+                addRow(rows, columns, i, makeRow, Indexes());
+            }
+        }
+
+        dbConn.closeCursor();
+        return rows;
+    }
+
+    // Streams the rows of the result set that's open on dbConn; the stream keeps the lease until it's done with the cursor
+    static RowStream<T> stream(DBConnLease dbConn, const char* errorMessage) {
+        return stream(std::move(dbConn), errorMessage, Construct());
+    }
+
+    template<typename MakeRow>
+    static RowStream<T> stream(DBConnLease dbConn, const char* errorMessage, MakeRow makeRow) {
+        return RowStream<T>(std::unique_ptr<RowCursor<T>>(new Cursor<MakeRow>(std::move(dbConn), errorMessage, std::move(makeRow))));
+    }
+
+private:
+    typedef std::index_sequence_for<Columns...> Indexes;
+
+    // Default for makeRow; tells addRow to emplace with T's constructor
+    struct Construct {};
+
+    // Cursor behind stream(): the column buffers for one block, and where we are in that block
+    template<typename MakeRow>
+    class Cursor : public RowCursor<T> {
+    public:
+        Cursor(DBConnLease dbConn, const char* errorMessage, MakeRow makeRow)
+            : dbConn(std::move(dbConn)), errorMessage(errorMessage), makeRow(std::move(makeRow)),
+            rowsFetched(0), nextRow(0), isOpen(true) {
+            prepare(*this->dbConn, columns, this->dbConn->beginBlockFetch(), Indexes());
+        }
+
+        ~Cursor() {
+            if (isOpen) {
+                dbConn->closeCursor();
+            }
+        }
+
+        bool next(std::vector<T>& row) override {
+            row.clear();
+            if (nextRow == rowsFetched) {
+                if (!isOpen) {
+                    return false;
+                }
+                isOpen = false; // fetchBlock closes the cursor itself if it throws
+                rowsFetched = fetchBlock(*dbConn, errorMessage);
+                nextRow = 0;
+                if (rowsFetched == 0) {
+                    dbConn->closeCursor();
+                    return false;
+                }
+                isOpen = true;
+            }
+            addRow(row, columns, nextRow++, makeRow, Indexes());
+            return true;
+        }
+
+    private:
+        DBConnLease dbConn;
+        const char* errorMessage;
+        MakeRow makeRow;
+        std::tuple<Columns...> columns;
+        SQLULEN rowsFetched;
+        SQLULEN nextRow;
+        bool isOpen;
+    };
+
+    // Fetches the next block of rows and returns how many there are, or 0 at the end of the result set
+    static SQLULEN fetchBlock(DBConn& dbConn, const char* errorMessage) {
+        SQLRETURN retcode = dbConn.fetchRow();
+        if (retcode == SQL_NO_DATA) {
+            return 0;
+        }
+        else if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO) {
+            dbConn.closeCursor(); // ensure we close cursor before throwing an error
+            throw std::runtime_error(errorMessage);
+        }
+
+        const SQLULEN rowsFetched = dbConn.getRowsFetched();
+        for (SQLULEN i = 0; i < rowsFetched; i++) {
+            if (dbConn.isRowError(i)) {
+                dbConn.closeCursor();
+                throw std::runtime_error(errorMessage);
+            }
+        }
+        return rowsFetched;
+    }
+
+    template<size_t... I>
+    static void prepare(DBConn& dbConn, std::tuple<Columns...>& columns, SQLULEN blockSize, std::index_sequence<I...>) {
+        // Column numbers start at 1; the array is just there to expand the calls in order
+        int expand[] = { 0, (std::get<I>(columns).allocate(blockSize), std::get<I>(columns).bind(dbConn, static_cast<int>(I) + 1), 0)... };
+        (void)expand;
+    }
+
+    template<size_t... I>
+    static void addRow(std::vector<T>& rows, std::tuple<Columns...>& columns, SQLULEN row, Construct, std::index_sequence<I...>) {
+        rows.emplace_back(std::get<I>(columns).get(row)...);
+    }
+
+    template<typename MakeRow, size_t... I>
+    static void addRow(std::vector<T>& rows, std::tuple<Columns...>& columns, SQLULEN row, MakeRow& makeRow, std::index_sequence<I...>) {
+        rows.push_back(makeRow(std::get<I>(columns).get(row)...));
+    }
+};
+
+#endif
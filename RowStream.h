@@ -0,0 +1,116 @@
+#ifndef RowStream_H
+#define RowStream_H
+
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <cstddef>
+#include <utility>
+
+// An open cursor that hands out the rows of its result set one at a time; RowMapper::stream makes these
+template<typename T>
+class RowCursor {
+public:
+    virtual ~RowCursor() {}
+
+    // Replaces the contents of row with the next row of the result set; returns false once there are no more
+    virtual bool next(std::vector<T>& row) = 0;
+};
+
+
+/*
++ RowStream: Range over the rows of an open cursor, for going through a whole table without reading it all into a vector.
+
+        for (Transaction& transaction : transactionManager.streamAll()) {
+            ...
+        }
+
+- Rows are still fetched in blocks (see DBConn::beginBlockFetch), but there's only ever one block of column
+  buffers and one T at a time: each row is built fresh from the buffers, and the one before it is destroyed first.
+  So with SQL Server, memory stays the same no matter how big the table is.
+- The in-process backend's streams are different: they copy the whole table out when the stream is made (so the
+  database isn't locked while the loop runs), and hand the copies out one by one. Memory there grows with the table.
+- The stream holds its connection until the last row has been read, or it's destroyed (like when the loop breaks
+  early or throws), and closes the cursor either way.
+- It's a single pass input range: begin() starts reading, and a row is only valid until the iterator moves on.
+  Rows are handed out as T& (the entities' getters aren't const), but changing one has no effect on the next.
+
+NOTE: The loop body gets the same connection (leases are re-entrant per thread), and the cursor stays open the whole time,
+    so the body shouldn't run other queries through the managers. Collect what's needed first, or use StorageBackend::runAsync.
+*/
+template<typename T>
+class RowStream {
+public:
+    class iterator {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T* pointer;
+        typedef T& reference;
+
+        iterator() : stream(nullptr) {}
+        explicit iterator(RowStream* stream) : stream(stream) {}
+
+        reference operator*() const {
+            return stream->row.front();
+        }
+
+        pointer operator->() const {
+            return &stream->row.front();
+        }
+
+        // Moves to the next row; becomes the end iterator after the last one
+        iterator& operator++() {
+            if (!stream->advance()) {
+                stream = nullptr;
+            }
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const {
+            return stream == other.stream;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return stream != other.stream;
+        }
+
+    private:
+        RowStream* stream;
+    };
+
+    explicit RowStream(std::unique_ptr<RowCursor<T>> cursor) : cursor(std::move(cursor)), isStarted(false) {}
+
+    RowStream(RowStream&&) = default;
+    RowStream& operator=(RowStream&&) = default;
+
+    iterator begin() {
+        if (!isStarted) {
+            isStarted = true;
+            advance();
+        }
+        return row.empty() ? end() : iterator(this);
+    }
+
+    iterator end() {
+        return iterator();
+    }
+
+private:
+    std::unique_ptr<RowCursor<T>> cursor;
+    std::vector<T> row; // The current row, or empty once we're done; a vector since T may have no default constructor
+    bool isStarted;
+
+    // Reads the next row; once there are none left, the cursor is closed and its connection goes back to the pool
+    bool advance() {
+        if (cursor && cursor->next(row)) {
+            return true;
+        }
+        row.clear();
+        cursor.reset();
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef SQLParam_H
+#define SQLParam_H
+
+#include <sql.h>
+#include <sqlext.h>
+#include <string>
+#include <utility>
+
+/*
++ SQLParam: A single value that gets bound to a '?' placeholder of a prepared statement.
+
+- Since the value is sent to the server as data rather than as part of the SQL text, strings don't
+  need to be escaped with escapeSQL, and the server can reuse the statement's compiled plan no matter
+  what values we pass in.
+
+NOTE: SQLBindParameter only stores pointers to our buffers, so a SQLParam has to stay alive (and not move)
+    until the statement it's bound to has been executed. DBConn takes care of this by holding onto the
+    parameters it bound.
+*/
+class SQLParam {
+public:
+    enum class Type { Integer, Double, String };
+
+    /*
+    - Strings are bound with a fixed column size rather than their actual length. If we used the actual
+      length, then 'abc' and 'abcd' would be sent as VARCHAR(3) and VARCHAR(4), and the server would
+      compile and cache a separate plan for every different length it sees.
+    */
+    static const SQLULEN MAX_VARCHAR_SIZE = 8000;
+
+    SQLParam(int value) : type(Type::Integer), intValue(value), doubleValue(0), indicator(0) {}
+    SQLParam(float value) : type(Type::Double), intValue(0), doubleValue(value), indicator(0) {}
+    SQLParam(double value) : type(Type::Double), intValue(0), doubleValue(value), indicator(0) {}
+    SQLParam(std::string value) : type(Type::String), intValue(0), doubleValue(0), stringValue(std::move(value)), indicator(0) {}
+    SQLParam(const char* value) : SQLParam(std::string(value)) {}
+
+    Type getType() const {
+        return type;
+    }
+
+    int getInt() const {
+        return static_cast<int>(intValue);
+    }
+
+    double getDouble() const {
+        return doubleValue;
+    }
+
+    const std::string& getString() const {
+        return stringValue;
+    }
+
+    // Number of bytes of data the parameter sends to the server
+    size_t getDataLength() const {
+        switch (type) {
+        case Type::Integer:
+            return sizeof(SQLINTEGER);
+        case Type::Double:
+            return sizeof(SQLDOUBLE);
+        default:
+            return stringValue.length();
+        }
+    }
+
+    // Binds the parameter to the '?' at position paramNum (starting at 1) of a prepared statement
+    SQLRETURN bind(SQLHSTMT hStmt, SQLUSMALLINT paramNum) {
+        switch (type) {
+        case Type::Integer:
+            return SQLBindParameter(hStmt, paramNum, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0, &intValue, 0, NULL);
+        case Type::Double:
+            return SQLBindParameter(hStmt, paramNum, SQL_PARAM_INPUT, SQL_C_DOUBLE, SQL_DOUBLE, 15, 0, &doubleValue, 0, NULL);
+        default:
+            indicator = static_cast<SQLLEN>(stringValue.length());
+            return SQLBindParameter(hStmt, paramNum, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, MAX_VARCHAR_SIZE, 0,
+                (SQLPOINTER)stringValue.c_str(), indicator, &indicator);
+        }
+    }
+
+private:
+    Type type;
+    SQLINTEGER intValue;
+    SQLDOUBLE doubleValue;
+    std::string stringValue;
+    SQLLEN indicator; // Length of stringValue in bytes
+};
+
+#endif
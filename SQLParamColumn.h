@@ -0,0 +1,87 @@
+#ifndef SQLParamColumn_H
+#define SQLParamColumn_H
+
+#include <sql.h>
+#include <sqlext.h>
+#include <string>
+#include <vector>
+#include <cstring>
+
+#include "SQLParam.h"
+
+/*
++ SQLParamColumn: The values of one '?' placeholder for every row of a bulk execute (see DBConn::executeBulk).
+
+- A parameter array is bound column-wise, so instead of one SQLParam per row, each placeholder gets one array
+  holding its value for all of the rows. Strings are stored back to back in one char array, where row i's
+  string starts at i * width, and width is the longest string in the column (plus the null terminator).
+- Every value in a column has to be the same type; DBConn::executeBulk checks this before building the columns.
+
+NOTE: Like SQLParam, the driver only keeps pointers to our arrays, so a column has to stay alive (and not move) 
+    until the statement it's bound to has been executed.
+*/
+class SQLParamColumn {
+public:
+    // Builds the column for placeholder colIndex (starting at 0) out of rows[begin] to rows[end - 1]
+    SQLParamColumn(const std::vector<std::vector<SQLParam>>& rows, size_t colIndex, size_t begin, size_t end)
+        : type(rows[begin][colIndex].getType()), width(0) {
+        const size_t rowCount = end - begin;
+
+        switch (type) {
+        case SQLParam::Type::Integer:
+            intValues.resize(rowCount);
+            for (size_t i = 0; i < rowCount; i++) {
+                intValues[i] = static_cast<SQLINTEGER>(rows[begin + i][colIndex].getInt());
+            }
+            break;
+        case SQLParam::Type::Double:
+            doubleValues.resize(rowCount);
+            for (size_t i = 0; i < rowCount; i++) {
+                doubleValues[i] = rows[begin + i][colIndex].getDouble();
+            }
+            break;
+        default:
+            // Size the buffer for the longest string in the column
+            for (size_t i = 0; i < rowCount; i++) {
+                SQLLEN length = static_cast<SQLLEN>(rows[begin + i][colIndex].getString().length());
+                if (length + 1 > width) {
+                    width = length + 1;
+                }
+            }
+            stringValues.assign(rowCount * width, '\0');
+            indicators.resize(rowCount);
+            for (size_t i = 0; i < rowCount; i++) {
+                const std::string& value = rows[begin + i][colIndex].getString();
+                memcpy(&stringValues[i * width], value.c_str(), value.length());
+                indicators[i] = static_cast<SQLLEN>(value.length());
+            }
+            break;
+        }
+    }
+
+    SQLParamColumn(const SQLParamColumn&) = delete;
+    SQLParamColumn& operator=(const SQLParamColumn&) = delete;
+
+    // Binds the column's array to the '?' at position paramNum (starting at 1)
+    SQLRETURN bind(SQLHSTMT hStmt, SQLUSMALLINT paramNum) {
+        switch (type) {
+        case SQLParam::Type::Integer:
+            return SQLBindParameter(hStmt, paramNum, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0, intValues.data(), 0, NULL);
+        case SQLParam::Type::Double:
+            return SQLBindParameter(hStmt, paramNum, SQL_PARAM_INPUT, SQL_C_DOUBLE, SQL_DOUBLE, 15, 0, doubleValues.data(), 0, NULL);
+        default:
+            return SQLBindParameter(hStmt, paramNum, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, SQLParam::MAX_VARCHAR_SIZE, 0,
+                stringValues.data(), width, indicators.data());
+        }
+    }
+
+private:
+    SQLParam::Type type;
+    std::vector<SQLINTEGER> intValues;
+    std::vector<SQLDOUBLE> doubleValues;
+    std::vector<char> stringValues;
+    std::vector<SQLLEN> indicators; // Length of each string in bytes
+    SQLLEN width;                   // Bytes for each string in stringValues, including the null terminator
+};
+
+#endif
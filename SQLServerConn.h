@@ -2,11 +2,15 @@
 #define SQLServerConn_H
 
 #include <iostream>
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <sql.h>
 #include <sqlext.h>
-#include <locale>
-#include <codecvt>
+#include <string>
+#include <stdexcept>
+
+#include "SQLText.h"
 
 class SQLServerConn {
 private:
@@ -31,12 +35,8 @@ public:
         if (SQL_SUCCESS != SQLAllocHandle(SQL_HANDLE_DBC, henv, &hdbc))
             throw std::runtime_error("Failed to allocate connection handle.");
 
-        // Convert std::string to std::wstring, then c_str() can convert connectionStringW into a SQLWCHAR*
-        std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-        std::wstring connectionStringW = converter.from_bytes(connectionString);
-
-        // Connect to SQL Server
-        SQLRETURN retcode = SQLDriverConnectW(hdbc, NULL, (SQLWCHAR*)connectionStringW.c_str(), SQL_NTS, NULL, 0, NULL, SQL_DRIVER_NOPROMPT);
+        // Connect to SQL Server; toSQLWCHAR converts the connection string into the SQLWCHAR* that SQLDriverConnectW wants
+        SQLRETURN retcode = SQLDriverConnectW(hdbc, NULL, (SQLWCHAR*)toSQLWCHAR(connectionString), SQL_NTS, NULL, 0, NULL, SQL_DRIVER_NOPROMPT);
 
         if (retcode != SQL_SUCCESS && retcode != SQL_SUCCESS_WITH_INFO)
             throw std::runtime_error("Failed to connect to SQL Server.");
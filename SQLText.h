@@ -0,0 +1,140 @@
+#ifndef SQLText_H
+#define SQLText_H
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <sql.h>
+#include <sqlext.h>
+#include <string>
+#include <vector>
+
+/*
++ SQLTextMode: How SQL text is handed to the driver. It's picked when the pool opens its connections.
+
+- Wide: Converted to UTF-16 and sent through the W functions (SQLExecDirectW, SQLPrepareW). Works for any text; the default.
+- Narrow: The std::string's bytes are sent as they are through the ANSI functions, with no conversion or copy at all.
+  Our SQL text is plain ASCII (anything the user typed goes in as a parameter), so this is safe for it.
+
+NOTE: With Narrow, text outside of ASCII is read in the client's code page. That's UTF-8 on Linux (unixODBC), and on
+    Windows only when the process runs with the UTF-8 code page, so keep Wide for SQL text that could have anything else.
+*/
+enum class SQLTextMode {
+    Wide,
+    Narrow
+};
+
+/*
++ Converts UTF-8 text into a null terminated UTF-16 string for the W functions.
+
+- The result goes into a buffer that belongs to the calling thread, and is reused by every call, so once it's grown
+  to fit our longest query there's no allocation at all. The pointer is only good until the thread's next call.
+- ASCII (which is all of our SQL text) is copied straight over; anything else is decoded, and a byte that isn't
+  valid UTF-8 becomes U+FFFD.
+
+NOTE: This replaces std::wstring_convert with codecvt_utf8_utf16, which is deprecated, and which made a new converter
+    and a new wide string for every single query.
+*/
+inline const SQLWCHAR* toSQLWCHAR(const std::string& text) {
+    static thread_local std::vector<SQLWCHAR> buffer;
+    buffer.clear();
+    buffer.reserve(text.size() + 1);
+
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t size = text.size();
+    size_t i = 0;
+    while (i < size) {
+        unsigned char lead = bytes[i];
+        if (lead < 0x80) {
+            buffer.push_back(static_cast<SQLWCHAR>(lead));
+            i++;
+            continue;
+        }
+
+        // The lead byte tells us how long the sequence is, and has the top bits of the code point
+        unsigned long codePoint = 0;
+        size_t length = 0;
+        if ((lead & 0xE0) == 0xC0) {
+            codePoint = lead & 0x1F;
+            length = 2;
+        }
+        else if ((lead & 0xF0) == 0xE0) {
+            codePoint = lead & 0x0F;
+            length = 3;
+        }
+        else if ((lead & 0xF8) == 0xF0) {
+            codePoint = lead & 0x07;
+            length = 4;
+        }
+
+        bool isValid = length > 0;
+        for (size_t k = 1; isValid && k < length; k++) {
+            if (i + k >= size || (bytes[i + k] & 0xC0) != 0x80) {
+                isValid = false;
+            }
+            else {
+                codePoint = (codePoint << 6) | (bytes[i + k] & 0x3F);
+            }
+        }
+
+        // Reject overlong encodings, surrogates, and anything past the last code point
+        if (isValid && ((length == 2 && codePoint < 0x80) || (length == 3 && codePoint < 0x800) ||
+            (length == 4 && codePoint < 0x10000) || codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF))) {
+            isValid = false;
+        }
+
+        if (!isValid) {
+            buffer.push_back(static_cast<SQLWCHAR>(0xFFFD));
+            i++;
+            continue;
+        }
+
+        // Code points past the BMP take a surrogate pair
+        if (codePoint >= 0x10000) {
+            codePoint -= 0x10000;
+            buffer.push_back(static_cast<SQLWCHAR>(0xD800 + (codePoint >> 10)));
+            buffer.push_back(static_cast<SQLWCHAR>(0xDC00 + (codePoint & 0x3FF)));
+        }
+        else {
+            buffer.push_back(static_cast<SQLWCHAR>(codePoint));
+        }
+        i += length;
+    }
+
+    buffer.push_back(0);
+    return buffer.data();
+}
+
+/*
+- The ANSI versions of SQLExecDirect and SQLPrepare, for SQLTextMode::Narrow, and of SQLGetDiagRec.
+
+NOTE: On Windows the plain names get mapped to the W functions when UNICODE is defined, so we call the A ones
+    there. unixODBC only has the plain names.
+*/
+inline SQLRETURN execDirectNarrow(SQLHSTMT hStmt, const std::string& sqlQuery) {
+#ifdef _WIN32
+    return SQLExecDirectA(hStmt, (SQLCHAR*)sqlQuery.c_str(), SQL_NTS);
+#else
+    return SQLExecDirect(hStmt, (SQLCHAR*)sqlQuery.c_str(), SQL_NTS);
+#endif
+}
+
+inline SQLRETURN prepareNarrow(SQLHSTMT hStmt, const std::string& sqlQuery) {
+#ifdef _WIN32
+    return SQLPrepareA(hStmt, (SQLCHAR*)sqlQuery.c_str(), SQL_NTS);
+#else
+    return SQLPrepare(hStmt, (SQLCHAR*)sqlQuery.c_str(), SQL_NTS);
+#endif
+}
+
+// The ANSI version of SQLGetDiagRec, so error messages come back as plain chars on both
+inline SQLRETURN getDiagRecNarrow(SQLSMALLINT handleType, SQLHANDLE handle, SQLSMALLINT recordNumber, SQLCHAR* sqlState,
+    SQLINTEGER* nativeError, SQLCHAR* messageText, SQLSMALLINT bufferLength, SQLSMALLINT* textLength) {
+#ifdef _WIN32
+    return SQLGetDiagRecA(handleType, handle, recordNumber, sqlState, nativeError, messageText, bufferLength, textLength);
+#else
+    return SQLGetDiagRec(handleType, handle, recordNumber, sqlState, nativeError, messageText, bufferLength, textLength);
+#endif
+}
+
+#endif
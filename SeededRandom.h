@@ -0,0 +1,162 @@
+#ifndef SeededRandom_H
+#define SeededRandom_H
+
+#include <random>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+/*
++ SeededRandom: Random numbers that come out the same for the same seed, on every compiler and platform.
+
+        SeededRandom random(SeededRandom::mix(seed, chunk)); // One stream per chunk of work
+        int qty = random.nextInt(1, 3);
+        double price = std::exp(2.5 + random.nextNormal());
+
+- std::mt19937_64 is defined exactly by the standard, but the std:: distributions aren't (libstdc++ and MSVC give
+  different numbers), so the values are made from the raw 64 bit output here instead.
+- mix() makes a seed for a sub-stream out of a seed and some ids (like a table and a chunk number), so work can
+  be split up between threads without the results depending on which thread does what.
+*/
+class SeededRandom {
+public:
+    explicit SeededRandom(uint64_t seed) : engine(seed) {}
+
+    // A seed made from seed and id; different ids give unrelated streams (splitmix64)
+    static uint64_t mix(uint64_t seed, uint64_t id) {
+        uint64_t z = seed + 0x9E3779B97F4A7C15ULL * (id + 1);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    static uint64_t mix(uint64_t seed, uint64_t id, uint64_t subID) {
+        return mix(mix(seed, id), subID);
+    }
+
+    uint64_t next() {
+        return engine();
+    }
+
+    // Uniform in [0, 1)
+    double nextDouble() {
+        return static_cast<double>(engine() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // Uniform in [low, high]; the bias for ranges this small next to 2^64 doesn't matter here
+    int nextInt(int low, int high) {
+        uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(high) - low) + 1;
+        return static_cast<int>(low + static_cast<int64_t>(engine() % range));
+    }
+
+    bool nextBool(double probability) {
+        return nextDouble() < probability;
+    }
+
+    // Standard normal (Box-Muller)
+    double nextNormal() {
+        double u = 1.0 - nextDouble(); // (0, 1], so the log is finite
+        return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * nextDouble());
+    }
+
+    // Number of failures before the first success, where each try succeeds with probability p
+    int nextGeometric(double p) {
+        if (p >= 1.0) {
+            return 0;
+        }
+        return static_cast<int>(std::floor(std::log(1.0 - nextDouble()) / std::log(1.0 - p)));
+    }
+
+    // Fisher-Yates, since std::shuffle's order also differs between standard libraries
+    template<typename T>
+    void shuffle(std::vector<T>& items) {
+        for (size_t i = items.size(); i > 1; i--) {
+            std::swap(items[i - 1], items[static_cast<size_t>(engine() % i)]);
+        }
+    }
+
+    // Picks one of items by its position in the vector
+    template<typename T>
+    const T& pick(const std::vector<T>& items) {
+        return items[static_cast<size_t>(engine() % items.size())];
+    }
+
+private:
+    std::mt19937_64 engine;
+};
+
+
+/*
++ WeightedDistribution: Picks an index from 0 to weights.size() - 1, each one as often as its weight.
+
+- The cumulative weights are kept in a vector and searched, so a pick is O(log n) and the table is 8 bytes an
+  index; fine for the million or so values we use it for.
+*/
+class WeightedDistribution {
+public:
+    WeightedDistribution() {}
+
+    explicit WeightedDistribution(const std::vector<double>& weights) {
+        cumulative.reserve(weights.size());
+        double total = 0;
+        for (size_t i = 0; i < weights.size(); i++) {
+            total += weights[i];
+            cumulative.push_back(total);
+        }
+        if (weights.empty() || total <= 0) {
+            throw std::runtime_error("A weighted distribution needs at least one positive weight!");
+        }
+    }
+
+    size_t operator()(SeededRandom& random) const {
+        return at(random.nextDouble());
+    }
+
+    // The index at fraction (0 to 1) of the way through the total weight; fractions spread evenly over [0, 1) give each index its share
+    size_t at(double fraction) const {
+        double target = fraction * cumulative.back();
+        size_t index = static_cast<size_t>(std::upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin());
+        return std::min(index, cumulative.size() - 1);
+    }
+
+    size_t size() const {
+        return cumulative.size();
+    }
+
+private:
+    std::vector<double> cumulative;
+};
+
+
+/*
++ ZipfDistribution: Picks a rank from 0 to n - 1, where rank k comes up in proportion to 1 / (k + 1)^exponent.
+    With an exponent around 1, a few ranks get most of the picks and there's a long tail, like product popularity.
+
+NOTE: Rank 0 is the most popular, so map ranks onto ids through a shuffled vector if the popular ones shouldn't
+    all be the lowest ids.
+*/
+class ZipfDistribution {
+public:
+    ZipfDistribution() {}
+
+    ZipfDistribution(size_t n, double exponent) : distribution(weights(n, exponent)) {}
+
+    size_t operator()(SeededRandom& random) const {
+        return distribution(random);
+    }
+
+private:
+    WeightedDistribution distribution;
+
+    static std::vector<double> weights(size_t n, double exponent) {
+        std::vector<double> rankWeights(n);
+        for (size_t k = 0; k < n; k++) {
+            rankWeights[k] = 1.0 / std::pow(static_cast<double>(k + 1), exponent);
+        }
+        return rankWeights;
+    }
+};
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef SlowQueryLog_H
+#define SlowQueryLog_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+
+#include "SQLParam.h"
+
+/*
++ QueryCaller: Labels the database work done on this thread while it's alive with the method doing it, so the
+    slow query log can say who ran a statement:
+
+        std::vector<Supplier> getAllSuppliers() {
+            QueryCaller queryCaller("SupplierManager::getAllSuppliers");
+            ...
+
+- Labels nest, so a statement run by CheckoutManager::checkout from RetailApp::handleCheckout is logged with
+  "RetailApp::handleCheckout > CheckoutManager::checkout".
+- The name has to be a string literal (or otherwise outlive the statement), since only the pointer is kept.
+*/
+class QueryCaller {
+public:
+    // The innermost few labels, captured when a statement starts; cheap enough to take for every statement
+    struct Chain {
+        enum { MAX_DEPTH = 4 };
+        const char* names[MAX_DEPTH];
+        int depth = 0;
+        bool isTruncated = false;
+
+        // "Outer > Inner", or "unknown" when the statement wasn't run inside a labeled method
+        std::string toString() const {
+            if (depth == 0) {
+                return "unknown";
+            }
+            std::string text = isTruncated ? "... > " : "";
+            for (int i = depth - 1; i >= 0; i--) {
+                text += names[i];
+                if (i > 0) {
+                    text += " > ";
+                }
+            }
+            return text;
+        }
+    };
+
+    explicit QueryCaller(const char* name) : name(name), outer(innermost()) {
+        innermost() = this;
+    }
+
+    QueryCaller(const QueryCaller&) = delete;
+    QueryCaller& operator=(const QueryCaller&) = delete;
+
+    ~QueryCaller() {
+        innermost() = outer;
+    }
+
+    const char* getName() const {
+        return name;
+    }
+
+    static Chain capture() {
+        Chain chain;
+        for (const QueryCaller* caller = innermost(); caller != nullptr; caller = caller->outer) {
+            if (chain.depth == Chain::MAX_DEPTH) {
+                chain.isTruncated = true;
+                break;
+            }
+            chain.names[chain.depth++] = caller->name;
+        }
+        return chain;
+    }
+
+private:
+    const char* name;
+    QueryCaller* outer;
+
+    static QueryCaller*& innermost() {
+        static thread_local QueryCaller* caller = nullptr;
+        return caller;
+    }
+};
+
+
+/*
++ SlowQueryLog: Writes statements that took longer than a threshold, plus a sample of all statements, to a local log
+    file, so latency spikes can be looked into after the fact. Turn it on with ConnectionPool::setSlowQueryLog.
+
+- Each entry is one line: when the statement finished, why it was logged (slow or sampled), how long it took in the
+  driver (like QueryMetrics), rows fetched, whether it failed, the labeled caller (see QueryCaller), the SQL, and the
+  values of its bound parameters.
+- sampleEvery logs 1 in every sampleEvery statements no matter how long they took, to see what normal looks like
+  next to the slow ones. 0 turns sampling off.
+- The file is rotated when it gets bigger than maxFileBytes: path becomes path.1, path.1 becomes path.2, and so on,
+  keeping up to maxOldFiles old files.
+
+NOTE: Parameter values are written as they are (strings cut off at MAX_PARAM_LENGTH), so the log can have customer
+    details in it; keep it somewhere only the people looking into problems can read it.
+*/
+class SlowQueryLog {
+public:
+    static const size_t MAX_PARAM_LENGTH = 200;
+
+    SlowQueryLog(
+        const std::string& path,
+        std::chrono::milliseconds threshold,
+        unsigned long long sampleEvery = 0,
+        unsigned long long maxFileBytes = 10 * 1024 * 1024,
+        int maxOldFiles = 5
+    ) : path(path),
+        thresholdMicros(static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(threshold).count())),
+        sampleEvery(sampleEvery),
+        maxFileBytes(maxFileBytes),
+        maxOldFiles(maxOldFiles < 0 ? 0 : maxOldFiles),
+        statementCount(0),
+        fileBytes(0) {
+        openFile();
+    }
+
+    SlowQueryLog(const SlowQueryLog&) = delete;
+    SlowQueryLog& operator=(const SlowQueryLog&) = delete;
+
+    /*
+    + Logs a finished statement if it was slow, or it's the one being sampled. DBConn calls this for every statement.
+
+    - params is null for statements that weren't parameterized. bulkRows is how many rows of parameters a bulk execute
+      sent (0 otherwise); only the count is logged for those.
+    */
+    void consider(const std::string& sqlQuery, const std::vector<SQLParam>* params, size_t bulkRows,
+        const QueryCaller::Chain& caller, unsigned long long micros, unsigned long long rowsFetched, bool failed) {
+        bool isSlow = micros >= thresholdMicros;
+        bool isSampled = sampleEvery > 0 && statementCount.fetch_add(1) % sampleEvery == 0;
+        if (!isSlow && !isSampled) {
+            return;
+        }
+
+        // Build the line before taking the lock
+        std::ostringstream line;
+        line << timestamp() << " " << (isSlow ? "slow" : "sampled") << " " << std::fixed << std::setprecision(3) << micros / 1000.0
+            << "ms rows=" << rowsFetched << " failed=" << (failed ? 1 : 0) << " caller=" << caller.toString()
+            << " sql=\"" << oneLine(sqlQuery) << "\"";
+        if (bulkRows > 0) {
+            line << " params=(" << bulkRows << " rows)";
+        }
+        else if (params != nullptr && !params->empty()) {
+            line << " params=[";
+            for (size_t i = 0; i < params->size(); i++) {
+                line << (i > 0 ? ", " : "") << formatParam((*params)[i]);
+            }
+            line << "]";
+        }
+        line << "\n";
+        write(line.str());
+    }
+
+private:
+    std::string path;
+    unsigned long long thresholdMicros;
+    unsigned long long sampleEvery;
+    unsigned long long maxFileBytes;
+    int maxOldFiles;
+    std::atomic<unsigned long long> statementCount;
+
+    std::mutex mutex; // Guards the file
+    std::ofstream file;
+    unsigned long long fileBytes;
+
+    void openFile() {
+        file.open(path, std::ios::app | std::ios::binary);
+        file.seekp(0, std::ios::end);
+        std::streamoff size = file.tellp();
+        fileBytes = size > 0 ? static_cast<unsigned long long>(size) : 0;
+    }
+
+    void write(const std::string& line) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (fileBytes > 0 && fileBytes + line.size() > maxFileBytes) {
+            rotate();
+        }
+        file << line;
+        file.flush(); // So the entries are there even if we crash right after a spike
+        fileBytes += line.size();
+    }
+
+    // path.(n-1) -> path.n, ..., path -> path.1, dropping the oldest
+    void rotate() {
+        file.close();
+        if (maxOldFiles == 0) {
+            std::remove(path.c_str());
+        }
+        else {
+            std::remove((path + "." + std::to_string(maxOldFiles)).c_str());
+            for (int i = maxOldFiles - 1; i >= 1; i--) {
+                std::rename((path + "." + std::to_string(i)).c_str(), (path + "." + std::to_string(i + 1)).c_str());
+            }
+            std::rename(path.c_str(), (path + ".1").c_str());
+        }
+        openFile();
+    }
+
+    // Keeps each entry on one line; batches and procedures can have line breaks in them
+    static std::string oneLine(std::string text) {
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '\n' || text[i] == '\r' || text[i] == '\t') {
+                text[i] = ' ';
+            }
+        }
+        return text;
+    }
+
+    static std::string formatParam(const SQLParam& param) {
+        switch (param.getType()) {
+        case SQLParam::Type::Integer:
+            return std::to_string(param.getInt());
+        case SQLParam::Type::Double: {
+            std::ostringstream value;
+            value << param.getDouble();
+            return value.str();
+        }
+        default: {
+            const std::string& value = param.getString();
+            std::string quoted = "'";
+            for (size_t i = 0; i < value.size() && i < MAX_PARAM_LENGTH; i++) {
+                if (value[i] == '\'') {
+                    quoted += "''";
+                }
+                else if (value[i] == '\n' || value[i] == '\r' || value[i] == '\t') {
+                    quoted += ' ';
+                }
+                else {
+                    quoted += value[i];
+                }
+            }
+            quoted += value.size() > MAX_PARAM_LENGTH ? "'..." : "'";
+            return quoted;
+        }
+        }
+    }
+
+    // Local time with milliseconds, like "2024-05-01 13:45:02.123"
+    static std::string timestamp() {
+        std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+        time_t seconds = std::chrono::system_clock::to_time_t(now);
+        long long millis = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+        struct tm localTime;
+#ifdef _WIN32
+        localtime_s(&localTime, &seconds);
+#else
+        localtime_r(&seconds, &localTime);
+#endif
+        char buffer[32];
+        strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &localTime);
+        char withMillis[40];
+        snprintf(withMillis, sizeof(withMillis), "%s.%03lld", buffer, millis);
+        return withMillis;
+    }
+};
+
+#endif
@@ -0,0 +1,424 @@
+#ifndef StorageBackend_H
+#define StorageBackend_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <future>
+#include <stdexcept>
+
+#include "PageSource.h"
+#include "RowStream.h"
+#include "Customer.h"
+#include "Supplier.h"
+#include "Product.h"
+#include "CartItem.h"
+#include "Transaction.h"
+#include "OrderItem.h"
+
+/*
++ StorageBackend: What RetailApp (and the benchmark and replayer) store the shop's data in. Each table gets a store
+    interface with the same functions its manager has always had, and a backend hands out one of each:
+
+    - OdbcBackend: the managers, talking to SQL Server through the connection pool. This is what the store runs on.
+    - InProcessBackend: hash-indexed tables in this process's memory (see InProcessDatabase). No server or network
+      is involved, so it's for measuring and profiling our own code (building the objects, RetailApp's logic), and
+      for load tests in CI where there's no SQL Server to run against.
+
+- The stores keep the managers' names, arguments and errors, so code written against them runs the same on either one.
+- Things that only make sense for SQL Server stay on the managers: initTable, the product cache, CheckoutQueue, and
+  the connection pool's knobs.
+*/
+
+
+// Keeps hold of a backend's connection for the thread that made it, until it's destroyed (see StorageBackend::runAsync)
+class ConnectionHold {
+public:
+    virtual ~ConnectionHold() {}
+};
+
+
+// A write transaction across stores; rolled back when it's destroyed without commit(). Like TransactionScope, these nest.
+class StorageTransaction {
+public:
+    virtual ~StorageTransaction() {}
+
+    virtual void commit() = 0;
+};
+
+
+// Reads collected from several stores (the batchGet functions) and run together; the vectors are filled in by execute()
+class ReadBatch {
+public:
+    virtual ~ReadBatch() {}
+
+    virtual void execute() = 0;
+};
+
+
+/*
++ CustomerStore: The 'Customer' table.
+*/
+class CustomerStore {
+protected:
+    /*
+    - Maximum lengths of the varchar columns.
+
+    NOTE: If you make changes to the length constraints, to see these changes on SQL Server, delete
+        the current customers table and re-initialize it.
+    */
+    static const int MAX_FNAME_LENGTH = 50;
+    static const int MAX_LNAME_LENGTH = 50;
+    static const int MAX_EMAIL_LENGTH = 50;
+
+public:
+    virtual ~CustomerStore() {}
+
+    virtual std::vector<Customer> getAllCustomers() = 0;
+    virtual int getCustomerCount() = 0;
+    virtual std::vector<Customer> getCustomerPage(int afterID, int pageSize) = 0;
+    virtual Customer getCustomerByID(int customer_id) = 0;
+    virtual void batchGetCustomerByID(ReadBatch& batch, int customer_id, std::vector<Customer>& customers) = 0;
+    virtual Customer createCustomer(std::string fname, std::string lname, std::string email, int points) = 0;
+    virtual std::vector<Customer> batchCreateCustomer(std::vector<std::tuple<std::string, std::string, std::string, int>> customerRows) = 0;
+    virtual void updateFirstName(int customer_id, std::string fname) = 0;
+    virtual void updateLastName(int customer_id, std::string lname) = 0;
+    virtual void updateEmail(int customer_id, std::string email) = 0;
+    virtual void updatePoints(int customer_id, int points) = 0;
+    virtual void deleteCustomer(int customer_id) = 0;
+
+    // Returns a page source over all customers, for the paginated menus; only the page being shown is fetched
+    PageSource<Customer> getCustomerPages(int pageSize) {
+        return PageSource<Customer>(pageSize,
+            [this](int afterID, int size) { return getCustomerPage(afterID, size); },
+            [](Customer& customer) { return customer.getCustomerID(); },
+            [this]() { return getCustomerCount(); });
+    }
+
+    /*
+    - Ensures the string attributes that were inputted meet max length constraints.
+    - If they aren't then an error is thrown
+    */
+    void validateFirstName(std::string fname) {
+        if (fname.length() > MAX_FNAME_LENGTH) {
+            throw std::runtime_error("Customer fname exceeds maximum length of " + std::to_string(MAX_FNAME_LENGTH) + " characters!");
+        }
+    }
+
+    void validateLastName(std::string lname) {
+        if (lname.length() > MAX_LNAME_LENGTH) {
+            throw std::runtime_error("Customer lname exceeds maximum length of " + std::to_string(MAX_LNAME_LENGTH) + " characters!");
+        }
+    }
+
+    void validateEmail(std::string email) {
+        if (email.length() > MAX_EMAIL_LENGTH) {
+            throw std::runtime_error("Customer email exceeds maximum length of " + std::to_string(MAX_EMAIL_LENGTH) + " characters!");
+        }
+    }
+};
+
+
+/*
++ SupplierStore: The 'Supplier' table, along with each supplier's (unique) name.
+*/
+class SupplierStore {
+protected:
+    // Maximum lengths of the varchar columns
+    static const int MAX_S_NAME_LENGTH = 50;
+    static const int MAX_DESCRIPTION_LENGTH = 2000;
+    static const int MAX_EMAIL_LENGTH = 50;
+    static const int MAX_ADDRESS_LENGTH = 50;
+
+public:
+    virtual ~SupplierStore() {}
+
+    virtual bool isValidSupplierID(int supplier_id) = 0;
+    virtual std::vector<Supplier> getAllSuppliers() = 0;
+    virtual int getSupplierCount() = 0;
+    virtual std::vector<Supplier> getSupplierPage(int afterID, int pageSize) = 0;
+    virtual Supplier getSupplierByID(int supplier_id) = 0;
+    virtual Supplier createSupplier(std::string& s_name, std::string& description, std::string& email, std::string& address) = 0;
+    virtual void updateName(int supplier_id, std::string& s_name) = 0;
+    virtual void updateDescription(int supplier_id, std::string& description) = 0;
+    virtual void updateEmail(int supplier_id, std::string& email) = 0;
+    virtual void updateAddress(int supplier_id, std::string& address) = 0;
+    virtual void deleteSupplier(int supplier_id) = 0;
+
+    // Returns a page source over all suppliers, for the paginated menus; only the page being shown is fetched
+    PageSource<Supplier> getSupplierPages(int pageSize) {
+        return PageSource<Supplier>(pageSize,
+            [this](int afterID, int size) { return getSupplierPage(afterID, size); },
+            [](Supplier& supplier) { return supplier.getSupplierID(); },
+            [this]() { return getSupplierCount(); });
+    }
+
+    // Checks that supplier name is within length constraints
+    void validateSupplierName(std::string& s_name) {
+        if (s_name.length() > MAX_S_NAME_LENGTH) {
+            throw std::runtime_error("Supplier name exceeds maximum length of " + std::to_string(MAX_S_NAME_LENGTH) + " characters!");
+        }
+    }
+
+    // Checks that supplier description is within length constraints
+    void validateDescription(std::string& description) {
+        if (description.length() > MAX_DESCRIPTION_LENGTH) {
+            throw std::runtime_error("Supplier description exceeds maximum length of " + std::to_string(MAX_DESCRIPTION_LENGTH) + " characters!");
+        }
+    }
+
+    // Checks that supplier email is within length constraints
+    void validateEmail(std::string& email) {
+        if (email.length() > MAX_EMAIL_LENGTH) {
+            throw std::runtime_error("Supplier email exceeds maximum length of " + std::to_string(MAX_EMAIL_LENGTH) + " characters!");
+        }
+    }
+
+    // Checks that supplier address is within length constraints
+    void validateAddress(std::string& address) {
+        if (address.length() > MAX_ADDRESS_LENGTH) {
+            throw std::runtime_error("Suppiler address exceeds maximum length of " + std::to_string(MAX_ADDRESS_LENGTH) + " characters!");
+        }
+    }
+};
+
+
+/*
++ ProductStore: The 'Product' table.
+
+NOTE: The list functions (getAllProducts, getProductPage, ...) may hand back products without their description
+    (hasDescription is false). Use getProductDescription to load it where it's actually shown.
+*/
+class ProductStore {
+protected:
+    // Maximum lengths of the varchar columns
+    static const int MAX_P_NAME_LENGTH = 50;
+    static const int MAX_DESCRIPTION_LENGTH = 2000;
+
+public:
+    virtual ~ProductStore() {}
+
+    virtual std::string getProductDescription(int product_id) = 0;
+    virtual std::vector<Product> getAllProducts() = 0;
+    virtual RowStream<Product> streamAll() = 0;
+    virtual std::vector<Product> getAvailableProducts() = 0;
+    virtual int getProductCount(bool onlyAvailable = false) = 0;
+    virtual std::vector<Product> getProductPage(int afterID, int pageSize, bool onlyAvailable = false) = 0;
+    virtual Product getProductByID(int product_id) = 0;
+    virtual std::map<int, int> getProductQuantities(std::vector<int> productIDs) = 0;
+    virtual void batchUpdateProductQty(std::vector<std::tuple<int, int>> productQuantities) = 0;
+    virtual Product createProduct(int supplier_id, std::string p_name, std::string description, float price, int qty) = 0;
+    virtual std::vector<Product> batchCreateProduct(std::vector<std::tuple<int, std::string, std::string, float, int>> productRows) = 0;
+    virtual void updateName(int product_id, std::string p_name) = 0;
+    virtual void updateDescription(int product_id, std::string description) = 0;
+    virtual void updatePrice(int product_id, float price) = 0;
+    virtual void updateQuantity(int product_id, int qty) = 0;
+    virtual void deleteProduct(int product_id) = 0;
+    virtual void deleteBySupplierID(int supplier_id) = 0;
+
+    // Tells the store the given products were changed behind its back (like by a checkout), for stores that cache them
+    virtual void invalidateCachedProducts(const std::vector<int>& productIDs) = 0;
+
+    // Returns a page source over all products (or just the ones in stock), for the paginated menus
+    PageSource<Product> getProductPages(int pageSize, bool onlyAvailable = false) {
+        return PageSource<Product>(pageSize,
+            [this, onlyAvailable](int afterID, int size) { return getProductPage(afterID, size, onlyAvailable); },
+            [](Product& product) { return product.getProductID(); },
+            [this, onlyAvailable]() { return getProductCount(onlyAvailable); });
+    }
+
+    // Validates p_name is within length constraints
+    void validateProductName(std::string& p_name) {
+        if (p_name.length() > MAX_P_NAME_LENGTH) {
+            throw std::runtime_error("Product p_name exceeds maximum length of " + std::to_string(MAX_P_NAME_LENGTH) + " characters!");
+        }
+    }
+
+    // Validates description is within length constraints
+    void validateDescription(std::string& description) {
+        if (description.length() > MAX_DESCRIPTION_LENGTH) {
+            throw std::runtime_error("Product description exceeds maximum length of " + std::to_string(MAX_DESCRIPTION_LENGTH) + " characters!");
+        }
+    }
+
+    // Validates price isn't negative
+    void validatePrice(float price) {
+        if (price < 0) {
+            throw std::runtime_error("Product price can't be negative!");
+        }
+    }
+
+    // Validates quantity isn't negative
+    void validateQty(int qty) {
+        if (qty < 0) {
+            throw std::runtime_error("Product quantity can't be negative!");
+        }
+    }
+};
+
+
+/*
++ CartItemStore: The 'CartItem' table; each customer's shopping cart. Cart items come back with their product's name and price.
+*/
+class CartItemStore {
+public:
+    // Whether a cart item was added to the cart, or was already there and had its quantity changed
+    enum class UpsertResult {
+        Inserted,
+        Updated
+    };
+
+    virtual ~CartItemStore() {}
+
+    virtual std::vector<CartItem> getCustomerCartItems(int customer_id) = 0;
+    virtual void batchGetCustomerCartItems(ReadBatch& batch, int customer_id, std::vector<CartItem>& cartItems) = 0;
+    virtual CartItem getCartItem(int customer_id, int product_id) = 0;
+    virtual bool isExistingCartItem(int customer_id, int product_id) = 0;
+    virtual void createCartItem(int customer_id, int product_id, int qty) = 0;
+    virtual void updateCartItem(int customer_id, int product_id, int qty) = 0;
+    virtual UpsertResult setCartItemQty(int customer_id, int product_id, int qty) = 0;
+    virtual UpsertResult incrementCartItemQty(int customer_id, int product_id, int qty) = 0;
+    virtual void deleteCartItem(int customer_id, int product_id) = 0;
+    virtual void deleteByProductID(int product_id) = 0;
+    virtual void deleteByCustomerID(int customer_id) = 0;
+    virtual void deleteBySupplierID(int supplier_id) = 0;
+};
+
+
+/*
++ TransactionStore: The 'Transaction' table; one row per checkout. customer_id comes back as 0 once the customer was deleted.
+*/
+class TransactionStore {
+public:
+    virtual ~TransactionStore() {}
+
+    virtual Transaction createTransaction(int customer_id, float total) = 0;
+    virtual std::vector<Transaction> getAllTransactions() = 0;
+    virtual RowStream<Transaction> streamAll() = 0;
+    virtual int getTransactionCount() = 0;
+    virtual std::vector<Transaction> getTransactionPage(int afterID, int pageSize) = 0;
+    virtual Transaction getTransactionByID(int transaction_id) = 0;
+    virtual void batchGetTransactionByID(ReadBatch& batch, int transaction_id, std::vector<Transaction>& transactions) = 0;
+    virtual void nullifyCustomerID(int customer_id) = 0;
+
+    // Returns a page source over all transactions, for the paginated menus; only the page being shown is fetched
+    PageSource<Transaction> getTransactionPages(int pageSize) {
+        return PageSource<Transaction>(pageSize,
+            [this](int afterID, int size) { return getTransactionPage(afterID, size); },
+            [](Transaction& transaction) { return transaction.getTransactionID(); },
+            [this]() { return getTransactionCount(); });
+    }
+};
+
+
+/*
++ OrderItemStore: The 'OrderItem' table; the products bought in each transaction. product_id comes back as 0 once the product was deleted.
+*/
+class OrderItemStore {
+public:
+    virtual ~OrderItemStore() {}
+
+    virtual OrderItem createOrderItem(int transaction_id, int product_id, int qty) = 0;
+    virtual std::vector<OrderItem> getOrderItems(int transaction_id) = 0;
+    virtual RowStream<OrderItem> streamAll() = 0;
+    virtual void batchGetOrderItems(ReadBatch& batch, int transaction_id, std::vector<OrderItem>& orderItems) = 0;
+    virtual void batchCreateOrderItem(std::vector<std::tuple<int, int, int>> orderItems) = 0;
+    virtual void nullifyProductID(int product_id) = 0;
+    virtual void nullifyProductIDBySupplierID(int supplier_id) = 0;
+};
+
+
+/*
++ CheckoutStore: Checks out a customer's cart all at once: takes the stock, creates the transaction and its order
+    items, clears the cart, and updates the customer's points. A failed checkout doesn't change anything.
+*/
+class CheckoutStore {
+public:
+    // Status codes for how a checkout went
+    enum class Status {
+        Success = 0,
+        EmptyCart = 1,
+        InsufficientStock = 2, // A product in the cart doesn't have enough in stock; productID says which one
+        InsufficientPoints = 3,
+        CustomerNotFound = 4
+    };
+
+    struct CheckoutResult {
+        Status status = Status::Success;
+        int transactionID = 0;
+        float total = 0;     // Total after the used points were taken off
+        int points = 0;      // Customer's points after checking out
+        int productID = 0;   // Product that didn't have enough stock, for InsufficientStock
+        std::string orderDate;
+
+        bool succeeded() const {
+            return status == Status::Success;
+        }
+
+        Transaction getTransaction(int customer_id) const {
+            return Transaction(transactionID, customer_id, total, orderDate);
+        }
+    };
+
+    virtual ~CheckoutStore() {}
+
+    // Returns the result of the checkout; throws only if the checkout couldn't be run at all
+    virtual CheckoutResult checkout(int customer_id, int usedPoints) = 0;
+};
+
+
+class StorageBackend {
+public:
+    virtual ~StorageBackend() {}
+
+    virtual CustomerStore& getCustomerStore() = 0;
+    virtual SupplierStore& getSupplierStore() = 0;
+    virtual ProductStore& getProductStore() = 0;
+    virtual CartItemStore& getCartItemStore() = 0;
+    virtual TransactionStore& getTransactionStore() = 0;
+    virtual OrderItemStore& getOrderItemStore() = 0;
+    virtual CheckoutStore& getCheckoutStore() = 0;
+
+    // Starts a transaction on this thread; everything done through the stores until it's committed or destroyed is part of it
+    virtual std::unique_ptr<StorageTransaction> beginTransaction() = 0;
+
+    // Starts an empty batch of reads, for the stores' batchGet functions
+    virtual std::unique_ptr<ReadBatch> newReadBatch() = 0;
+
+    // True if the last call on this thread threw only because it lost a deadlock, so running it again can work
+    virtual bool wasDeadlockVictim() = 0;
+
+    // Forgets this thread's last error, so wasDeadlockVictim only answers for calls made after this; call it before each attempt
+    virtual void clearLastError() = 0;
+
+    // Takes a connection for the calling thread and keeps it until the hold is destroyed; null if the backend has none
+    virtual std::unique_ptr<ConnectionHold> holdConnection() = 0;
+
+    /*
+    + Runs function (which uses the stores) on another thread, and returns a future for its result. Use it to run
+      independent reads at the same time, so waiting on them takes as long as the slowest one rather than the sum:
+
+            std::future<Customer> customer = backend.runAsync([&]() { return customerStore.getCustomerByID(id); });
+            std::vector<CartItem> cartItems = cartItemStore.getCustomerCartItems(id);
+            ... customer.get() ...
+
+    - The task holds its own connection for as long as it runs (see holdConnection), so everything it does shares
+      one connection, and it runs alongside the caller's queries rather than queuing behind them. An exception
+      thrown by function is rethrown by the future's get().
+
+    NOTE: Since it's a different connection, the task isn't part of the caller's transaction (if it has one), and
+        it can't see the caller's uncommitted writes. Don't wait on the future while holding the last connection in
+        the pool (like a transaction with a pool of one), since the task would be waiting for that same connection.
+    */
+    template<typename Function>
+    auto runAsync(Function function) -> std::future<decltype(function())> {
+        return std::async(std::launch::async, [this, function]() mutable {
+            std::unique_ptr<ConnectionHold> hold = holdConnection();
+            return function();
+        });
+    }
+};
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef Supplier_H
 #define Supplier_H
 #include <string>
+#include <utility>
 #include <ostream>
 
 class Supplier {
@@ -22,10 +23,10 @@ public:
 		std::string email,
 		std::string address
 	) : supplier_id(supplier_id),
-		s_name(s_name),
-		description(description),
-		email(email),
-		address(address) {}
+		s_name(std::move(s_name)),
+		description(std::move(description)),
+		email(std::move(email)),
+		address(std::move(address)) {}
 
 	const int getSupplierID() {
 		return supplier_id;
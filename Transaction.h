@@ -1,6 +1,7 @@
 #ifndef Transaction_H
 #define Transaction_H
 #include <string>
+#include <utility>
 
 class Transaction {
 private:
@@ -18,7 +19,7 @@ public:
 	) : transaction_id(transaction_id),
 		customer_id(customer_id),
 		total(total),
-		order_date(order_date) {}
+		order_date(std::move(order_date)) {}
 
 
 	int getTransactionID() {
@@ -0,0 +1,136 @@
+#ifndef TransactionScope_H
+#define TransactionScope_H
+
+#include <string>
+#include <stdexcept>
+
+#include "ConnectionPool.h"
+
+/*
++ TransactionScope: Runs everything done on this thread, while the scope is alive, in one database transaction.
+
+        TransactionScope transaction(connectionPool);
+        cartItemManager.deleteByCustomerID(customer_id);
+        customerManager.deleteCustomer(customer_id);
+        transaction.commit();
+
+- The scope holds a lease on a connection, and leases are re-entrant per thread, so every manager call in
+  between gets the same connection and runs inside the transaction without knowing about it.
+- If the scope is destroyed without commit() (like when a manager throws), everything is rolled back, so a
+  chain of writes that fails halfway doesn't leave the first half done.
+- Scopes can be nested, such as a manager using one inside a RetailApp function that's already using one.
+  The inner scope uses a savepoint: its rollback only undoes its own work, and its commit leaves the
+  decision to the outer scope.
+
+NOTE: The isolation level only applies to the outermost scope; a nested one runs in the outer transaction's level.
+*/
+class TransactionScope {
+public:
+    enum class IsolationLevel {
+        ReadUncommitted,
+        ReadCommitted,
+        RepeatableRead,
+        Serializable
+    };
+
+    TransactionScope(ConnectionPool& connectionPool, IsolationLevel isolationLevel = IsolationLevel::ReadCommitted)
+        : dbConn(connectionPool.acquire()), isDone(false) {
+        if (dbConn->inTransaction()) {
+            // Nested scope; mark where our work starts so we can undo just that
+            savepointName = "scope_" + std::to_string(dbConn->transactionDepth);
+            if (!dbConn->saveTransaction(savepointName)) {
+                throw std::runtime_error("Failed to create savepoint '" + savepointName + "'!");
+            }
+            dbConn->transactionDepth++;
+        }
+        else if (!dbConn->beginTransaction(toSQLIsolationLevel(isolationLevel))) {
+            throw std::runtime_error("Failed to begin transaction!");
+        }
+    }
+
+    TransactionScope(const TransactionScope&) = delete;
+    TransactionScope& operator=(const TransactionScope&) = delete;
+
+    // Rolls back if neither commit() nor rollback() was called
+    ~TransactionScope() {
+        if (!isDone) {
+            try {
+                rollback();
+            }
+            catch (...) {
+                // Don't throw out of a destructor; the transaction ends when the connection goes back to the pool
+            }
+        }
+    }
+
+    // Commits the transaction; for a nested scope, keeps its work as part of the outer transaction
+    void commit() {
+        finish();
+        if (isNested()) {
+            dbConn->transactionDepth--;
+            return;
+        }
+        if (!dbConn->commitTransaction()) {
+            throw std::runtime_error("Failed to commit transaction!");
+        }
+    }
+
+    // Undoes everything done in the scope
+    void rollback() {
+        finish();
+        if (isNested()) {
+            dbConn->transactionDepth--;
+            if (!dbConn->rollbackToSavepoint(savepointName)) {
+                throw std::runtime_error("Failed to roll back to savepoint '" + savepointName + "'!");
+            }
+            return;
+        }
+        if (!dbConn->rollbackTransaction()) {
+            throw std::runtime_error("Failed to roll back transaction!");
+        }
+    }
+
+    // Marks a savepoint inside the scope, which rollbackTo can undo back to without ending the scope
+    void savepoint(const std::string& name) {
+        if (isDone || !dbConn->saveTransaction(name)) {
+            throw std::runtime_error("Failed to create savepoint '" + name + "'!");
+        }
+    }
+
+    void rollbackTo(const std::string& name) {
+        if (isDone || !dbConn->rollbackToSavepoint(name)) {
+            throw std::runtime_error("Failed to roll back to savepoint '" + name + "'!");
+        }
+    }
+
+private:
+    DBConnLease dbConn;
+    std::string savepointName; // Empty for the outermost scope
+    bool isDone;
+
+    bool isNested() const {
+        return !savepointName.empty();
+    }
+
+    void finish() {
+        if (isDone) {
+            throw std::runtime_error("Transaction was already committed or rolled back!");
+        }
+        isDone = true;
+    }
+
+    static SQLUINTEGER toSQLIsolationLevel(IsolationLevel isolationLevel) {
+        switch (isolationLevel) {
+        case IsolationLevel::ReadUncommitted:
+            return SQL_TXN_READ_UNCOMMITTED;
+        case IsolationLevel::RepeatableRead:
+            return SQL_TXN_REPEATABLE_READ;
+        case IsolationLevel::Serializable:
+            return SQL_TXN_SERIALIZABLE;
+        default:
+            return SQL_TXN_READ_COMMITTED;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef WorkloadRecorder_H
+#define WorkloadRecorder_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <stdexcept>
+#include <exception>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+#include "WorkloadTrace.h"
+#include "SlowQueryLog.h"
+
+/*
++ WorkloadRecorder: Records the calls made to the managers, with their arguments and timing, into a trace file
+    (see WorkloadTrace), so the same traffic can be played back later with WorkloadReplayer.
+
+        WorkloadRecorder recorder("terminal1.trace");
+        WorkloadRecorder::setCurrent(&recorder);
+        ... use the store like normal ...
+        WorkloadRecorder::setCurrent(nullptr);
+
+- Calls are recorded by a WorkloadCall at the top of each manager method (see below). When no recorder is set,
+  that costs one atomic load.
+- Each thread that makes calls gets its own session number, in the order they made their first call.
+- Calls are kept in memory and written to the file in chunks of FLUSH_BYTES, and whatever's left when the recorder
+  is destroyed (or flush is called).
+*/
+class WorkloadRecorder {
+public:
+    static const size_t FLUSH_BYTES = 64 * 1024;
+
+    explicit WorkloadRecorder(const std::string& path)
+        : file(path, std::ios::binary | std::ios::trunc),
+        startMicros(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count()),
+        startTime(std::chrono::steady_clock::now()),
+        previousStartMicros(0),
+        callCount(0) {
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open workload trace '" + path + "' for writing!");
+        }
+        WorkloadTrace::writeHeader(buffer, startMicros);
+    }
+
+    WorkloadRecorder(const WorkloadRecorder&) = delete;
+    WorkloadRecorder& operator=(const WorkloadRecorder&) = delete;
+
+    ~WorkloadRecorder() {
+        if (getCurrent() == this) {
+            setCurrent(nullptr);
+        }
+        flush();
+    }
+
+    // The recorder that manager calls are recorded into, or null to stop recording
+    static void setCurrent(WorkloadRecorder* recorder) {
+        current().store(recorder);
+    }
+
+    static WorkloadRecorder* getCurrent() {
+        return current().load(std::memory_order_acquire);
+    }
+
+    // Adds a finished call to the trace; name has to outlive the recorder (WorkloadCall passes its method's string literal)
+    void record(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end,
+        const std::vector<WorkloadArg>& args, bool threw) {
+        long long callStartMicros = std::chrono::duration_cast<std::chrono::microseconds>(start - startTime).count();
+        long long durationMicros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map<const char*, unsigned long long>::iterator nameID = nameIDs.find(name);
+        if (nameID == nameIDs.end()) {
+            nameID = nameIDs.insert(std::make_pair(name, static_cast<unsigned long long>(nameIDs.size()))).first;
+            WorkloadTrace::writeName(buffer, nameID->second, name);
+        }
+        std::map<std::thread::id, int>::iterator session = sessions.find(std::this_thread::get_id());
+        if (session == sessions.end()) {
+            session = sessions.insert(std::make_pair(std::this_thread::get_id(), static_cast<int>(sessions.size()))).first;
+        }
+        WorkloadTrace::writeCall(buffer, nameID->second, session->second, callStartMicros - previousStartMicros,
+            durationMicros < 0 ? 0 : static_cast<unsigned long long>(durationMicros), threw, args);
+        previousStartMicros = callStartMicros;
+        callCount++;
+
+        if (buffer.size() >= FLUSH_BYTES) {
+            writeBuffer();
+        }
+    }
+
+    // Writes the calls recorded so far to the file
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        writeBuffer();
+    }
+
+    unsigned long long getCallCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return callCount;
+    }
+
+private:
+    std::mutex mutex; // Guards everything below
+    std::ofstream file;
+    std::string buffer;
+    long long startMicros; // Since the epoch, for the header
+    std::chrono::steady_clock::time_point startTime;
+    long long previousStartMicros;
+    std::map<const char*, unsigned long long> nameIDs; // Keyed by the literal's address; the same name twice just gets two ids
+    std::map<std::thread::id, int> sessions;
+    unsigned long long callCount;
+
+    static std::atomic<WorkloadRecorder*>& current() {
+        static std::atomic<WorkloadRecorder*> recorder(nullptr);
+        return recorder;
+    }
+
+    void writeBuffer() {
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        file.flush();
+        buffer.clear();
+    }
+};
+
+
+/*
++ WorkloadCall: Records the manager method it's declared in, with the method's arguments, while a WorkloadRecorder
+    is set. It goes right under the method's QueryCaller, and takes its name from it:
+
+        void createCartItem(int customer_id, int product_id, int qty) {
+            QueryCaller queryCaller("CartItemManager::createCartItem");
+            WorkloadCall workloadCall(queryCaller, customer_id, product_id, qty);
+            ...
+
+- Only the outermost call on a thread is recorded. So when a manager method calls another one (like SupplierManager
+  creating the supplier's name), replaying the outer call does the inner one too, the same as it did the first time.
+- A call that ends by throwing is recorded with the threw flag, so the replay can tell expected failures from new ones.
+- Arguments are only copied when recording, so this costs next to nothing otherwise.
+*/
+class WorkloadCall {
+public:
+    template<typename... Args>
+    WorkloadCall(const QueryCaller& caller, const Args&... callArgs) : recorder(nullptr), name(caller.getName()), exceptionsBefore(0) {
+        WorkloadRecorder* currentRecorder = WorkloadRecorder::getCurrent();
+        if (currentRecorder == nullptr || isRecordingCall()) {
+            return;
+        }
+        recorder = currentRecorder;
+        isRecordingCall() = true;
+        args.reserve(sizeof...(Args));
+        int expand[] = { 0, (args.push_back(WorkloadArg(callArgs)), 0)... };
+        (void)expand;
+        exceptionsBefore = uncaughtExceptions();
+        start = std::chrono::steady_clock::now();
+    }
+
+    WorkloadCall(const WorkloadCall&) = delete;
+    WorkloadCall& operator=(const WorkloadCall&) = delete;
+
+    ~WorkloadCall() {
+        if (recorder == nullptr) {
+            return;
+        }
+        isRecordingCall() = false;
+        recorder->record(name, start, std::chrono::steady_clock::now(), args, uncaughtExceptions() > exceptionsBefore);
+    }
+
+private:
+    WorkloadRecorder* recorder; // Null when this call isn't being recorded
+    const char* name;
+    std::vector<WorkloadArg> args;
+    std::chrono::steady_clock::time_point start;
+    int exceptionsBefore; // So a call made while unwinding from some other exception isn't counted as throwing
+
+    // std::uncaught_exception (without the s) is all C++14 has, and it's deprecated after that
+    static int uncaughtExceptions() {
+#ifdef __cpp_lib_uncaught_exceptions
+        return std::uncaught_exceptions();
+#else
+        return std::uncaught_exception() ? 1 : 0;
+#endif
+    }
+
+    // Whether an outer call on this thread is already being recorded
+    static bool& isRecordingCall() {
+        static thread_local bool isRecording = false;
+        return isRecording;
+    }
+};
+
+#endif
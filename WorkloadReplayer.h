@@ -0,0 +1,379 @@
+#ifndef WorkloadReplayer_H
+#define WorkloadReplayer_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <chrono>
+#include <ostream>
+#include <iomanip>
+
+#include "WorkloadTrace.h"
+#include "QueryMetrics.h"
+#include "StorageBackend.h"
+
+/*
++ WorkloadReplayer: Plays traces made by WorkloadRecorder back through a StorageBackend's stores, so real traffic can be
+    used as a load test, and run again the same way before and after a change (or on another backend).
+
+        WorkloadReplayer replayer(backend);
+        replayer.load("terminal1.trace");
+        replayer.load("terminal2.trace");
+        WorkloadReplayer::Report report = replayer.run(4, 2.0); // 4 sessions at twice the recorded speed
+        report.print(std::cout);
+
+- The recorded sessions are dealt out to the replay sessions (recorded session % sessions), and each replay session
+  runs on its own thread, making its calls one after another in the order they were recorded.
+- speed scales the time between calls: 1 is how fast they came in when recording, 2 is twice as fast, and 0 doesn't
+  wait at all. Calls are started on schedule from when the replay began, not from when the previous call finished,
+  so a slower server makes the replay fall behind (see maxLagMicros) rather than quietly sending less load.
+- Traces from different files are lined up by the time they started recording.
+- The report has each method's latency when it was recorded next to its latency in the replay.
+
+NOTE: Replay against a copy of the database as it was when recording started. The calls are made with the recorded
+    ids, so things like a deleted customer or an identity that came out differently will make later calls fail, and
+    those show up as failures in the report. Calls recorded as throwing are expected to throw again.
+NOTE: The pool needs at least as many connections as there are sessions, or the sessions will wait on each other.
+NOTE: Only the manager methods with a WorkloadCall in them are recorded; the batch, bulk and streaming ones aren't.
+*/
+class WorkloadReplayer {
+public:
+    struct MethodStats {
+        std::string name;
+        unsigned long long calls = 0;
+        unsigned long long failures = 0;
+        unsigned long long recordedFailures = 0;
+        unsigned long long recordedTotalMicros = 0;
+        unsigned long long replayedTotalMicros = 0;
+        LatencyHistogram recordedHistogram;
+        LatencyHistogram replayedHistogram;
+    };
+
+    struct Report {
+        int sessions = 0;
+        double speed = 0;
+        unsigned long long calls = 0;
+        unsigned long long failures = 0;
+        unsigned long long unknownCalls = 0; // Methods the replayer doesn't know how to call; skipped
+        unsigned long long recordedMicros = 0; // How long the trace took to record, first call to last
+        unsigned long long wallMicros = 0;     // How long the replay took
+        unsigned long long maxLagMicros = 0;   // Furthest behind schedule a call was started
+        std::vector<MethodStats> methods;      // Most replayed time first
+
+        void print(std::ostream& os) const {
+            std::ios::fmtflags flags = os.flags();
+            std::streamsize precision = os.precision();
+            os << std::fixed << std::setprecision(3);
+            os << "<WorkloadReplay sessions(" << sessions << "), speed(" << speed << "), calls(" << calls << "), failures("
+                << failures << "), unknown(" << unknownCalls << "), recorded(" << recordedMicros / 1000.0 << "ms), replayed("
+                << wallMicros / 1000.0 << "ms), max lag(" << maxLagMicros / 1000.0 << "ms)>" << std::endl;
+            for (size_t i = 0; i < methods.size(); i++) {
+                const MethodStats& method = methods[i];
+                os << "  " << method.name << ": calls(" << method.calls << "), failures(" << method.failures
+                    << ", recorded " << method.recordedFailures << ")" << std::endl
+                    << "    recorded avg(" << average(method.recordedTotalMicros, method.calls) / 1000.0
+                    << "), p50(" << method.recordedHistogram.percentile(50) / 1000.0
+                    << "), p99(" << method.recordedHistogram.percentile(99) / 1000.0 << ")"
+                    << "  replayed avg(" << average(method.replayedTotalMicros, method.calls) / 1000.0
+                    << "), p50(" << method.replayedHistogram.percentile(50) / 1000.0
+                    << "), p99(" << method.replayedHistogram.percentile(99) / 1000.0 << ")" << std::endl;
+            }
+            os.flags(flags);
+            os.precision(precision);
+            os << "</WorkloadReplay>" << std::endl;
+        }
+
+    private:
+        static double average(unsigned long long totalMicros, unsigned long long calls) {
+            return calls == 0 ? 0.0 : static_cast<double>(totalMicros) / calls;
+        }
+    };
+
+    explicit WorkloadReplayer(StorageBackend& backend)
+        : customerManager(backend.getCustomerStore()),
+        supplierManager(backend.getSupplierStore()),
+        productManager(backend.getProductStore()),
+        cartItemManager(backend.getCartItemStore()),
+        transactionManager(backend.getTransactionStore()),
+        orderItemManager(backend.getOrderItemStore()),
+        checkoutManager(backend.getCheckoutStore()),
+        nextSession(0) {
+        addMethods();
+    }
+
+    // Adds the calls in a trace file to the ones that will be replayed; its sessions are numbered after the ones already loaded
+    void load(const std::string& path) {
+        std::vector<WorkloadTrace::Call> traceCalls = WorkloadTrace::read(path, nextSession);
+        for (size_t i = 0; i < traceCalls.size(); i++) {
+            nextSession = std::max(nextSession, traceCalls[i].session + 1);
+            calls.push_back(std::move(traceCalls[i]));
+        }
+        std::stable_sort(calls.begin(), calls.end(), [](const WorkloadTrace::Call& a, const WorkloadTrace::Call& b) {
+            return a.startMicros < b.startMicros;
+        });
+    }
+
+    size_t getCallCount() const {
+        return calls.size();
+    }
+
+    // Replays every loaded call over the given number of sessions, at speed times the recorded rate (0 for no waiting)
+    Report run(int sessions, double speed = 1.0) {
+        if (sessions < 1) {
+            throw std::runtime_error("A workload replay needs at least one session!");
+        }
+        Report report;
+        report.sessions = sessions;
+        report.speed = speed;
+        if (calls.empty()) {
+            return report;
+        }
+        const long long traceStart = calls.front().startMicros;
+        report.recordedMicros = static_cast<unsigned long long>(calls.back().startMicros - traceStart);
+
+        std::vector<SessionResult> results(sessions);
+        std::vector<std::thread> threads;
+        std::chrono::steady_clock::time_point replayStart = std::chrono::steady_clock::now();
+        for (int i = 0; i < sessions; i++) {
+            threads.push_back(std::thread([this, i, sessions, speed, traceStart, replayStart, &results]() {
+                replaySession(i, sessions, speed, traceStart, replayStart, results[i]);
+            }));
+        }
+        for (size_t i = 0; i < threads.size(); i++) {
+            threads[i].join();
+        }
+        report.wallMicros = elapsedMicros(replayStart, std::chrono::steady_clock::now());
+
+        // Add up the sessions
+        std::map<std::string, MethodStats> methodStats;
+        for (size_t i = 0; i < results.size(); i++) {
+            const SessionResult& result = results[i];
+            report.unknownCalls += result.unknownCalls;
+            report.maxLagMicros = std::max(report.maxLagMicros, result.maxLagMicros);
+            for (size_t k = 0; k < result.calls.size(); k++) {
+                const CallResult& call = result.calls[k];
+                MethodStats& method = methodStats[call.name];
+                method.name = call.name;
+                method.calls++;
+                method.failures += call.failed ? 1 : 0;
+                method.recordedFailures += call.recordedThrew ? 1 : 0;
+                method.recordedTotalMicros += call.recordedMicros;
+                method.replayedTotalMicros += call.replayedMicros;
+                method.recordedHistogram.add(call.recordedMicros);
+                method.replayedHistogram.add(call.replayedMicros);
+                report.calls++;
+                report.failures += call.failed ? 1 : 0;
+            }
+        }
+        for (std::map<std::string, MethodStats>::const_iterator it = methodStats.begin(); it != methodStats.end(); ++it) {
+            report.methods.push_back(it->second);
+        }
+        std::sort(report.methods.begin(), report.methods.end(), [](const MethodStats& a, const MethodStats& b) {
+            return a.replayedTotalMicros > b.replayedTotalMicros;
+        });
+        return report;
+    }
+
+private:
+    typedef std::function<void(const std::vector<WorkloadArg>&)> Method;
+
+    struct CallResult {
+        const char* name; // Points into the loaded calls
+        bool failed;
+        bool recordedThrew;
+        unsigned long long recordedMicros;
+        unsigned long long replayedMicros;
+    };
+
+    // What one session did; each session only writes to its own, so they're added up after the threads finish
+    struct SessionResult {
+        std::vector<CallResult> calls;
+        unsigned long long unknownCalls = 0;
+        unsigned long long maxLagMicros = 0;
+    };
+
+    CustomerStore& customerManager;
+    SupplierStore& supplierManager;
+    ProductStore& productManager;
+    CartItemStore& cartItemManager;
+    TransactionStore& transactionManager;
+    OrderItemStore& orderItemManager;
+    CheckoutStore& checkoutManager;
+    std::map<std::string, Method> methods; // Keyed by the name the call was recorded with
+    std::vector<WorkloadTrace::Call> calls; // Every loaded call, in the order they started
+    int nextSession;
+
+    // Maps each recorded method name to a call of that method with the recorded arguments
+    void addMethods() {
+        typedef const std::vector<WorkloadArg>& Args;
+
+        // Customers
+        methods["CustomerManager::getAllCustomers"] = [this](Args) { customerManager.getAllCustomers(); };
+        methods["CustomerManager::getCustomerCount"] = [this](Args) { customerManager.getCustomerCount(); };
+        methods["CustomerManager::getCustomerPage"] = [this](Args args) { customerManager.getCustomerPage(arg(args, 0).getInt(), arg(args, 1).getInt()); };
+        methods["CustomerManager::getCustomerByID"] = [this](Args args) { customerManager.getCustomerByID(arg(args, 0).getInt()); };
+        methods["CustomerManager::createCustomer"] = [this](Args args) {
+            customerManager.createCustomer(arg(args, 0).getString(), arg(args, 1).getString(), arg(args, 2).getString(), arg(args, 3).getInt());
+        };
+        methods["CustomerManager::updateFirstName"] = [this](Args args) { customerManager.updateFirstName(arg(args, 0).getInt(), arg(args, 1).getString()); };
+        methods["CustomerManager::updateLastName"] = [this](Args args) { customerManager.updateLastName(arg(args, 0).getInt(), arg(args, 1).getString()); };
+        methods["CustomerManager::updateEmail"] = [this](Args args) { customerManager.updateEmail(arg(args, 0).getInt(), arg(args, 1).getString()); };
+        methods["CustomerManager::updatePoints"] = [this](Args args) { customerManager.updatePoints(arg(args, 0).getInt(), arg(args, 1).getInt()); };
+        methods["CustomerManager::deleteCustomer"] = [this](Args args) { customerManager.deleteCustomer(arg(args, 0).getInt()); };
+
+        // Suppliers; these take their strings by (non-const) reference, so they get copies
+        methods["SupplierManager::isValidSupplierID"] = [this](Args args) { supplierManager.isValidSupplierID(arg(args, 0).getInt()); };
+        methods["SupplierManager::getAllSuppliers"] = [this](Args) { supplierManager.getAllSuppliers(); };
+        methods["SupplierManager::getSupplierCount"] = [this](Args) { supplierManager.getSupplierCount(); };
+        methods["SupplierManager::getSupplierPage"] = [this](Args args) { supplierManager.getSupplierPage(arg(args, 0).getInt(), arg(args, 1).getInt()); };
+        methods["SupplierManager::getSupplierByID"] = [this](Args args) { supplierManager.getSupplierByID(arg(args, 0).getInt()); };
+        methods["SupplierManager::createSupplier"] = [this](Args args) {
+            std::string s_name = arg(args, 0).getString();
+            std::string description = arg(args, 1).getString();
+            std::string email = arg(args, 2).getString();
+            std::string address = arg(args, 3).getString();
+            supplierManager.createSupplier(s_name, description, email, address);
+        };
+        methods["SupplierManager::updateName"] = [this](Args args) {
+            std::string s_name = arg(args, 1).getString();
+            supplierManager.updateName(arg(args, 0).getInt(), s_name);
+        };
+        methods["SupplierManager::updateDescription"] = [this](Args args) {
+            std::string description = arg(args, 1).getString();
+            supplierManager.updateDescription(arg(args, 0).getInt(), description);
+        };
+        methods["SupplierManager::updateEmail"] = [this](Args args) {
+            std::string email = arg(args, 1).getString();
+            supplierManager.updateEmail(arg(args, 0).getInt(), email);
+        };
+        methods["SupplierManager::updateAddress"] = [this](Args args) {
+            std::string address = arg(args, 1).getString();
+            supplierManager.updateAddress(arg(args, 0).getInt(), address);
+        };
+        methods["SupplierManager::deleteSupplier"] = [this](Args args) { supplierManager.deleteSupplier(arg(args, 0).getInt()); };
+
+        // Products
+        methods["ProductManager::getProductDescription"] = [this](Args args) { productManager.getProductDescription(arg(args, 0).getInt()); };
+        methods["ProductManager::getAllProducts"] = [this](Args) { productManager.getAllProducts(); };
+        methods["ProductManager::getAvailableProducts"] = [this](Args) { productManager.getAvailableProducts(); };
+        methods["ProductManager::getProductCount"] = [this](Args args) { productManager.getProductCount(arg(args, 0).getBool()); };
+        methods["ProductManager::getProductPage"] = [this](Args args) {
+            productManager.getProductPage(arg(args, 0).getInt(), arg(args, 1).getInt(), arg(args, 2).getBool());
+        };
+        methods["ProductManager::getProductByID"] = [this](Args args) { productManager.getProductByID(arg(args, 0).getInt()); };
+        methods["ProductManager::getProductQuantities"] = [this](Args args) { productManager.getProductQuantities(arg(args, 0).getIntList()); };
+        methods["ProductManager::createProduct"] = [this](Args args) {
+            productManager.createProduct(arg(args, 0).getInt(), arg(args, 1).getString(), arg(args, 2).getString(),
+                static_cast<float>(arg(args, 3).getDouble()), arg(args, 4).getInt());
+        };
+        methods["ProductManager::updateName"] = [this](Args args) { productManager.updateName(arg(args, 0).getInt(), arg(args, 1).getString()); };
+        methods["ProductManager::updateDescription"] = [this](Args args) { productManager.updateDescription(arg(args, 0).getInt(), arg(args, 1).getString()); };
+        methods["ProductManager::updatePrice"] = [this](Args args) {
+            productManager.updatePrice(arg(args, 0).getInt(), static_cast<float>(arg(args, 1).getDouble()));
+        };
+        methods["ProductManager::updateQuantity"] = [this](Args args) { productManager.updateQuantity(arg(args, 0).getInt(), arg(args, 1).getInt()); };
+        methods["ProductManager::deleteProduct"] = [this](Args args) { productManager.deleteProduct(arg(args, 0).getInt()); };
+        methods["ProductManager::deleteBySupplierID"] = [this](Args args) { productManager.deleteBySupplierID(arg(args, 0).getInt()); };
+
+        // Cart items
+        methods["CartItemManager::getCustomerCartItems"] = [this](Args args) { cartItemManager.getCustomerCartItems(arg(args, 0).getInt()); };
+        methods["CartItemManager::getCartItem"] = [this](Args args) { cartItemManager.getCartItem(arg(args, 0).getInt(), arg(args, 1).getInt()); };
+        methods["CartItemManager::isExistingCartItem"] = [this](Args args) { cartItemManager.isExistingCartItem(arg(args, 0).getInt(), arg(args, 1).getInt()); };
+        methods["CartItemManager::createCartItem"] = [this](Args args) {
+            cartItemManager.createCartItem(arg(args, 0).getInt(), arg(args, 1).getInt(), arg(args, 2).getInt());
+        };
+        methods["CartItemManager::updateCartItem"] = [this](Args args) {
+            cartItemManager.updateCartItem(arg(args, 0).getInt(), arg(args, 1).getInt(), arg(args, 2).getInt());
+        };
+        methods["CartItemManager::setCartItemQty"] = [this](Args args) {
+            cartItemManager.setCartItemQty(arg(args, 0).getInt(), arg(args, 1).getInt(), arg(args, 2).getInt());
+        };
+        methods["CartItemManager::incrementCartItemQty"] = [this](Args args) {
+            cartItemManager.incrementCartItemQty(arg(args, 0).getInt(), arg(args, 1).getInt(), arg(args, 2).getInt());
+        };
+        methods["CartItemManager::deleteCartItem"] = [this](Args args) { cartItemManager.deleteCartItem(arg(args, 0).getInt(), arg(args, 1).getInt()); };
+        methods["CartItemManager::deleteByProductID"] = [this](Args args) { cartItemManager.deleteByProductID(arg(args, 0).getInt()); };
+        methods["CartItemManager::deleteByCustomerID"] = [this](Args args) { cartItemManager.deleteByCustomerID(arg(args, 0).getInt()); };
+        methods["CartItemManager::deleteBySupplierID"] = [this](Args args) { cartItemManager.deleteBySupplierID(arg(args, 0).getInt()); };
+
+        // Transactions and order items
+        methods["TransactionManager::createTransaction"] = [this](Args args) {
+            transactionManager.createTransaction(arg(args, 0).getInt(), static_cast<float>(arg(args, 1).getDouble()));
+        };
+        methods["TransactionManager::getAllTransactions"] = [this](Args) { transactionManager.getAllTransactions(); };
+        methods["TransactionManager::getTransactionCount"] = [this](Args) { transactionManager.getTransactionCount(); };
+        methods["TransactionManager::getTransactionPage"] = [this](Args args) { transactionManager.getTransactionPage(arg(args, 0).getInt(), arg(args, 1).getInt()); };
+        methods["TransactionManager::getTransactionByID"] = [this](Args args) { transactionManager.getTransactionByID(arg(args, 0).getInt()); };
+        methods["TransactionManager::nullifyCustomerID"] = [this](Args args) { transactionManager.nullifyCustomerID(arg(args, 0).getInt()); };
+        methods["OrderItemManager::createOrderItem"] = [this](Args args) {
+            orderItemManager.createOrderItem(arg(args, 0).getInt(), arg(args, 1).getInt(), arg(args, 2).getInt());
+        };
+        methods["OrderItemManager::getOrderItems"] = [this](Args args) { orderItemManager.getOrderItems(arg(args, 0).getInt()); };
+        methods["OrderItemManager::nullifyProductID"] = [this](Args args) { orderItemManager.nullifyProductID(arg(args, 0).getInt()); };
+        methods["OrderItemManager::nullifyProductIDBySupplierID"] = [this](Args args) { orderItemManager.nullifyProductIDBySupplierID(arg(args, 0).getInt()); };
+
+        // Checkout; like when recording, a checkout that comes back with a failed status (like InsufficientStock) isn't a failure
+        methods["CheckoutManager::checkout"] = [this](Args args) { checkoutManager.checkout(arg(args, 0).getInt(), arg(args, 1).getInt()); };
+    }
+
+    static const WorkloadArg& arg(const std::vector<WorkloadArg>& args, size_t i) {
+        if (i >= args.size()) {
+            throw std::runtime_error("Recorded call is missing an argument!");
+        }
+        return args[i];
+    }
+
+    static unsigned long long elapsedMicros(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+        long long micros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        return micros < 0 ? 0 : static_cast<unsigned long long>(micros);
+    }
+
+    void replaySession(int session, int sessions, double speed, long long traceStart,
+        std::chrono::steady_clock::time_point replayStart, SessionResult& result) {
+        for (size_t i = 0; i < calls.size(); i++) {
+            const WorkloadTrace::Call& call = calls[i];
+            if (call.session % sessions != session) {
+                continue;
+            }
+            std::map<std::string, Method>::const_iterator method = methods.find(call.name);
+            if (method == methods.end()) {
+                result.unknownCalls++;
+                continue;
+            }
+
+            // Wait until the call is due, or note how far behind we are
+            if (speed > 0) {
+                std::chrono::steady_clock::time_point due = replayStart +
+                    std::chrono::microseconds(static_cast<long long>((call.startMicros - traceStart) / speed));
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                if (now < due) {
+                    std::this_thread::sleep_until(due);
+                }
+                else {
+                    result.maxLagMicros = std::max(result.maxLagMicros, elapsedMicros(due, now));
+                }
+            }
+
+            CallResult callResult;
+            callResult.name = call.name.c_str();
+            callResult.failed = false;
+            callResult.recordedThrew = call.threw;
+            callResult.recordedMicros = call.durationMicros;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            try {
+                method->second(call.args);
+            }
+            catch (const std::exception&) {
+                callResult.failed = true;
+            }
+            callResult.replayedMicros = elapsedMicros(start, std::chrono::steady_clock::now());
+            result.calls.push_back(callResult);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,320 @@
+#ifndef WorkloadTrace_H
+#define WorkloadTrace_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+
+// One argument of a recorded manager call
+class WorkloadArg {
+public:
+    enum class Type { Integer, Double, String, IntegerList };
+
+    WorkloadArg(int value) : type(Type::Integer), intValue(value), doubleValue(0) {}
+    WorkloadArg(bool value) : type(Type::Integer), intValue(value ? 1 : 0), doubleValue(0) {}
+    WorkloadArg(long long value) : type(Type::Integer), intValue(value), doubleValue(0) {}
+    WorkloadArg(float value) : type(Type::Double), intValue(0), doubleValue(value) {}
+    WorkloadArg(double value) : type(Type::Double), intValue(0), doubleValue(value) {}
+    WorkloadArg(std::string value) : type(Type::String), intValue(0), doubleValue(0), stringValue(std::move(value)) {}
+    WorkloadArg(const char* value) : WorkloadArg(std::string(value)) {}
+    WorkloadArg(std::vector<int> value) : type(Type::IntegerList), intValue(0), doubleValue(0), listValue(std::move(value)) {}
+
+    Type getType() const {
+        return type;
+    }
+
+    int getInt() const {
+        return static_cast<int>(intValue);
+    }
+
+    bool getBool() const {
+        return intValue != 0;
+    }
+
+    long long getLongLong() const {
+        return intValue;
+    }
+
+    double getDouble() const {
+        return doubleValue;
+    }
+
+    const std::string& getString() const {
+        return stringValue;
+    }
+
+    const std::vector<int>& getIntList() const {
+        return listValue;
+    }
+
+private:
+    Type type;
+    long long intValue;
+    double doubleValue;
+    std::string stringValue;
+    std::vector<int> listValue;
+};
+
+
+/*
++ WorkloadTrace: The file format WorkloadRecorder writes and WorkloadReplayer reads. Everything is little endian,
+    and numbers are varints (7 bits a byte), so a typical call takes 10 to 20 bytes.
+
+- Header: "WLTR", a version byte, then the time recording started as 8 bytes of microseconds since the epoch.
+- Then records, each starting with its kind:
+    - Name (0): id, length, bytes. Defines the id that later calls use for a method's name, so names are only written once.
+    - Call (1): name id, session, start (microseconds after the previous call's start, zigzagged since calls are written
+      when they finish, which isn't always in the order they started), duration in microseconds, flags (1 = threw),
+      argument count, then each argument as a type byte and its value.
+- Arguments: Integer (zigzag varint), Double (8 bytes), String (length and bytes), IntegerList (count and zigzag varints).
+- A session is one thread of the recording process; calls in one session were made one after another.
+
+NOTE: A trace is only ever appended to, so one that got cut off (like if the program crashed) reads fine up to the
+    last whole record.
+*/
+class WorkloadTrace {
+public:
+    static const unsigned char VERSION = 1;
+
+    enum RecordKind {
+        NAME_RECORD = 0,
+        CALL_RECORD = 1
+    };
+
+    enum CallFlags {
+        CALL_THREW = 1
+    };
+
+    struct Call {
+        std::string name;                     // Like "CartItemManager::createCartItem"
+        int session = 0;
+        long long startMicros = 0;            // Since the epoch
+        unsigned long long durationMicros = 0;
+        bool threw = false;
+        std::vector<WorkloadArg> args;
+    };
+
+    static void writeHeader(std::string& out, long long startMicros) {
+        out += "WLTR";
+        out += static_cast<char>(VERSION);
+        unsigned long long bits = static_cast<unsigned long long>(startMicros);
+        for (int i = 0; i < 8; i++) {
+            out += static_cast<char>((bits >> (8 * i)) & 0xFF);
+        }
+    }
+
+    static void writeName(std::string& out, unsigned long long id, const std::string& name) {
+        out += static_cast<char>(NAME_RECORD);
+        writeVarint(out, id);
+        writeVarint(out, name.size());
+        out += name;
+    }
+
+    // startDelta is microseconds after the start of the call written before this one
+    static void writeCall(std::string& out, unsigned long long nameID, int session, long long startDelta,
+        unsigned long long durationMicros, bool threw, const std::vector<WorkloadArg>& args) {
+        out += static_cast<char>(CALL_RECORD);
+        writeVarint(out, nameID);
+        writeVarint(out, static_cast<unsigned long long>(session));
+        writeVarint(out, zigzag(startDelta));
+        writeVarint(out, durationMicros);
+        out += static_cast<char>(threw ? CALL_THREW : 0);
+        out += static_cast<char>(args.size());
+        for (size_t i = 0; i < args.size(); i++) {
+            writeArg(out, args[i]);
+        }
+    }
+
+    /*
+    + Reads every call in a trace file, in the order they were written.
+
+    - firstSession is added to every call's session, so traces from different processes (like two terminals) can be
+      loaded together without their sessions getting mixed up.
+    - Throws if the file can't be opened or isn't a trace; a cut off last record is dropped.
+    */
+    static std::vector<Call> read(const std::string& path, int firstSession = 0) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open workload trace '" + path + "'!");
+        }
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        Reader reader(data);
+        if (data.size() < 13 || data.compare(0, 4, "WLTR") != 0) {
+            throw std::runtime_error("'" + path + "' isn't a workload trace!");
+        }
+        reader.position = 4;
+        if (reader.readByte() != VERSION) {
+            throw std::runtime_error("Workload trace '" + path + "' is from a different version!");
+        }
+        unsigned long long bits = 0;
+        for (int i = 0; i < 8; i++) {
+            bits |= static_cast<unsigned long long>(reader.readByte()) << (8 * i);
+        }
+        long long previousStart = static_cast<long long>(bits);
+
+        std::map<unsigned long long, std::string> names;
+        std::vector<Call> calls;
+        try {
+            while (!reader.isAtEnd()) {
+                unsigned char kind = reader.readByte();
+                if (kind == NAME_RECORD) {
+                    unsigned long long id = reader.readVarint();
+                    names[id] = reader.readString();
+                }
+                else if (kind == CALL_RECORD) {
+                    Call call;
+                    std::map<unsigned long long, std::string>::const_iterator name = names.find(reader.readVarint());
+                    if (name == names.end()) {
+                        throw std::runtime_error("Workload trace '" + path + "' has a call to a name it never defined!");
+                    }
+                    call.name = name->second;
+                    call.session = firstSession + static_cast<int>(reader.readVarint());
+                    call.startMicros = previousStart + unzigzag(reader.readVarint());
+                    call.durationMicros = reader.readVarint();
+                    call.threw = (reader.readByte() & CALL_THREW) != 0;
+                    unsigned char argCount = reader.readByte();
+                    for (unsigned char i = 0; i < argCount; i++) {
+                        call.args.push_back(reader.readArg());
+                    }
+                    previousStart = call.startMicros;
+                    calls.push_back(std::move(call));
+                }
+                else {
+                    throw std::runtime_error("Workload trace '" + path + "' has a record of an unknown kind!");
+                }
+            }
+        }
+        catch (const TruncatedTrace&) {
+            // The recording stopped partway through writing a record; keep everything before it
+        }
+        return calls;
+    }
+
+private:
+    struct TruncatedTrace {};
+
+    struct Reader {
+        const std::string& data;
+        size_t position;
+
+        explicit Reader(const std::string& data) : data(data), position(0) {}
+
+        bool isAtEnd() const {
+            return position >= data.size();
+        }
+
+        unsigned char readByte() {
+            if (position >= data.size()) {
+                throw TruncatedTrace();
+            }
+            return static_cast<unsigned char>(data[position++]);
+        }
+
+        unsigned long long readVarint() {
+            unsigned long long value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                unsigned char byte = readByte();
+                value |= static_cast<unsigned long long>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+            throw std::runtime_error("Workload trace has a number that's too long!");
+        }
+
+        std::string readString() {
+            unsigned long long length = readVarint();
+            if (length > data.size() - position) {
+                throw TruncatedTrace();
+            }
+            std::string value = data.substr(position, static_cast<size_t>(length));
+            position += static_cast<size_t>(length);
+            return value;
+        }
+
+        WorkloadArg readArg() {
+            WorkloadArg::Type type = static_cast<WorkloadArg::Type>(readByte());
+            switch (type) {
+            case WorkloadArg::Type::Integer:
+                return WorkloadArg(unzigzag(readVarint()));
+            case WorkloadArg::Type::Double: {
+                unsigned long long bits = 0;
+                for (int i = 0; i < 8; i++) {
+                    bits |= static_cast<unsigned long long>(readByte()) << (8 * i);
+                }
+                double value;
+                std::memcpy(&value, &bits, sizeof(value));
+                return WorkloadArg(value);
+            }
+            case WorkloadArg::Type::String:
+                return WorkloadArg(readString());
+            case WorkloadArg::Type::IntegerList: {
+                unsigned long long count = readVarint();
+                std::vector<int> values;
+                for (unsigned long long i = 0; i < count; i++) {
+                    values.push_back(static_cast<int>(unzigzag(readVarint())));
+                }
+                return WorkloadArg(std::move(values));
+            }
+            default:
+                throw std::runtime_error("Workload trace has an argument of an unknown type!");
+            }
+        }
+    };
+
+    static void writeVarint(std::string& out, unsigned long long value) {
+        while (value >= 0x80) {
+            out += static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    // Small negative numbers become small varints too: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+    static unsigned long long zigzag(long long value) {
+        return (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63);
+    }
+
+    static long long unzigzag(unsigned long long value) {
+        return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1);
+    }
+
+    static void writeArg(std::string& out, const WorkloadArg& arg) {
+        out += static_cast<char>(arg.getType());
+        switch (arg.getType()) {
+        case WorkloadArg::Type::Integer:
+            writeVarint(out, zigzag(arg.getLongLong()));
+            break;
+        case WorkloadArg::Type::Double: {
+            double value = arg.getDouble();
+            unsigned long long bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            for (int i = 0; i < 8; i++) {
+                out += static_cast<char>((bits >> (8 * i)) & 0xFF);
+            }
+            break;
+        }
+        case WorkloadArg::Type::String:
+            writeVarint(out, arg.getString().size());
+            out += arg.getString();
+            break;
+        case WorkloadArg::Type::IntegerList: {
+            const std::vector<int>& values = arg.getIntList();
+            writeVarint(out, values.size());
+            for (size_t i = 0; i < values.size(); i++) {
+                writeVarint(out, zigzag(values[i]));
+            }
+            break;
+        }
+        }
+    }
+};
+
+#endif
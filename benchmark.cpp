@@ -0,0 +1,431 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <memory>
+#include <fstream>
+#include <new>
+#include <cstring>
+
+#include "ConnectionPool.h"
+#include "QueryMetrics.h"
+#include "CustomerManager.h"
+#include "SupplierManager.h"
+#include "SupplierNameManager.h"
+#include "ProductManager.h"
+#include "CartItemManager.h"
+#include "TransactionManager.h"
+#include "OrderItemManager.h"
+#include "CheckoutManager.h"
+#include "OdbcBackend.h"
+#include "InProcessBackend.h"
+#include "BenchmarkSuite.h"
+
+/*
++ benchmark: Runs every manager against a scratch database and prints how long each operation takes, so a change
+    can be measured the same way every time, on Windows or on Linux (unixODBC).
+
+        retail_benchmark "<ODBC connection string>" [rows] [iterations] [--filter=text] [--json=path]
+        retail_benchmark --in-process [rows] [iterations] [--filter=text] [--json=path]
+
+- The connection string can also be given with the RETAIL_BENCHMARK_CONNECTION environment variable, like
+  "DRIVER={ODBC Driver 18 for SQL Server};SERVER=localhost,1433;UID=sa;PWD=...;TrustServerCertificate=yes;"
+  for a local SQL Server container.
+- The benchmark_store database is dropped and made again on every run, then seeded with rows customers and products
+  (default 1000), and rows / 10 suppliers. So every run starts from the same data.
+- Each manager method gets its own case (see BenchmarkSuite), and the ones that take a size (pages, batches) get a
+  case per size, like ProductManager::getProductPage/100. Each case runs about iterations times (default 1000;
+  fewer for the big sizes), one call after another on one thread. For each one we print ops/s, items/s, latency
+  percentiles, and allocations per op. Page sizes bigger than the table are skipped, so pass more rows to run them.
+- The timed cases run without QueryMetrics, since recording every statement adds to their times and a SQL Server run
+  wouldn't compare fairly with an in-process one. After them comes a separate "QueryMetrics pass": the same cases
+  again, on a fresh database, with QueryMetrics on and their times thrown away, then its report of what the server
+  spent its time on. Its numbers aren't in the --json results.
+- --filter only runs the cases with that text in their name, and --json writes the results in Google Benchmark's
+  JSON format, so two runs (before and after a change, or SQL Server and in-process) can be compared with its
+  tools/compare.py. The cases have the same names on both backends.
+- With --in-process the same operations run on an InProcessBackend instead, with no server at all. Next to a SQL
+  Server run, that shows how much of each operation's time is our own code and how much is the driver, the network
+  and the server. There's no cached case or QueryMetrics pass then, since those are ODBC-only.
+- Allocations are the ones made with C++ new (counted by the operator new below), so they're ours and the standard
+  library's; the driver's own mallocs aren't in them.
+
+NOTE: The managers use T-SQL (MERGE, OUTPUT, a stored procedure for checkout), so the data source has to be
+    SQL Server; SQLite and the like won't run them.
+*/
+
+// Counts every allocation for BenchmarkSuite's allocations per op; the other forms of new and delete end up in these
+void* operator new(std::size_t size) {
+    AllocationCounter::add(size);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+/*
+- Seeds backend's (empty) tables, then runs every case on them. queryMetrics is reset after seeding, if there
+  is one. cachedProductManager is the same ProductManager as backend's product store, to time it again with its cache
+  turned on; null skips that.
+*/
+void runBenchmarks(BenchmarkSuite& suite, StorageBackend& backend, int rows, int iterations, QueryMetrics* queryMetrics, ProductManager* cachedProductManager) {
+    CustomerStore& customerManager = backend.getCustomerStore();
+    SupplierStore& supplierManager = backend.getSupplierStore();
+    ProductStore& productManager = backend.getProductStore();
+    CartItemStore& cartItemManager = backend.getCartItemStore();
+    TransactionStore& transactionManager = backend.getTransactionStore();
+    OrderItemStore& orderItemManager = backend.getOrderItemStore();
+    CheckoutStore& checkoutManager = backend.getCheckoutStore();
+
+    // Seed the tables; products get plenty of stock, so no checkout runs out
+    std::cout << "Seeding " << rows << " customers and products..." << std::endl;
+    std::vector<int> supplierIDs;
+    for (int i = 0; i < rows / 10; i++) {
+        std::string s_name = "Supplier " + std::to_string(i);
+        std::string description = "Benchmark supplier " + std::to_string(i);
+        std::string email = "supplier" + std::to_string(i) + "@example.com";
+        std::string address = std::to_string(i) + " Benchmark Street";
+        supplierIDs.push_back(supplierManager.createSupplier(s_name, description, email, address).getSupplierID());
+    }
+
+    std::vector<std::tuple<int, std::string, std::string, float, int>> productRows;
+    std::vector<std::tuple<std::string, std::string, std::string, int>> customerRows;
+    for (int i = 0; i < rows; i++) {
+        productRows.push_back(std::make_tuple(supplierIDs[i % supplierIDs.size()], "Product " + std::to_string(i),
+            "Benchmark product " + std::to_string(i), 1.0f + (i % 100) * 0.5f, 1000000));
+        customerRows.push_back(std::make_tuple("First" + std::to_string(i), "Last" + std::to_string(i),
+            "customer" + std::to_string(i) + "@example.com", 1000));
+    }
+    std::vector<int> productIDs;
+    std::vector<Product> products = productManager.batchCreateProduct(productRows);
+    for (size_t i = 0; i < products.size(); i++) {
+        productIDs.push_back(products[i].getProductID());
+    }
+    std::vector<int> customerIDs;
+    std::vector<Customer> customers = customerManager.batchCreateCustomer(customerRows);
+    for (size_t i = 0; i < customers.size(); i++) {
+        customerIDs.push_back(customers[i].getCustomerID());
+    }
+    if (queryMetrics != nullptr) {
+        queryMetrics->reset();
+    }
+
+    // Reads go to random rows, the same ones every run
+    std::mt19937 random(42);
+    std::uniform_int_distribution<size_t> pickCustomer(0, customerIDs.size() - 1);
+    std::uniform_int_distribution<size_t> pickProduct(0, productIDs.size() - 1);
+    std::uniform_int_distribution<size_t> pickSupplier(0, supplierIDs.size() - 1);
+
+    // Cases that handle items items per op run fewer times, so each one moves about the same number of rows
+    auto iterationsFor = [iterations](int items) {
+        return std::max(5, std::min(iterations, 200000 / std::max(1, items)));
+    };
+    const int batchSizes[] = { 1, 10, 100, 1000 };
+
+    std::cout << "<Benchmark rows(" << rows << "), iterations(" << iterations << ")>" << std::endl;
+
+    // Customers
+    suite.run("CustomerManager::createCustomer", iterations, [&](int i) {
+        customerManager.createCustomer("New" + std::to_string(i), "Customer", "new" + std::to_string(i) + "@example.com", 0);
+    });
+    suite.run("CustomerManager::getCustomerByID", iterations, [&](int) {
+        customerManager.getCustomerByID(customerIDs[pickCustomer(random)]);
+    });
+    suite.run("CustomerManager::getCustomerPage/20", iterations, [&](int) {
+        customerManager.getCustomerPage(customerIDs[pickCustomer(random)], 20);
+    }, 20);
+    suite.run("CustomerManager::updatePoints", iterations, [&](int i) {
+        customerManager.updatePoints(customerIDs[pickCustomer(random)], 1000 + i);
+    });
+
+    // Suppliers; getAllSuppliers joins in the supplier names
+    suite.run("SupplierManager::getSupplierByID", iterations, [&](int) {
+        supplierManager.getSupplierByID(supplierIDs[pickSupplier(random)]);
+    });
+    suite.run("SupplierManager::getSupplierPage/20", iterations, [&](int) {
+        supplierManager.getSupplierPage(supplierIDs[pickSupplier(random)], 20);
+    }, 20);
+    const int supplierCount = static_cast<int>(supplierIDs.size());
+    suite.run("SupplierManager::getAllSuppliers", iterationsFor(supplierCount), [&](int) {
+        supplierManager.getAllSuppliers();
+    }, supplierCount);
+
+    // Products; getProductByID goes to the server first, then (on SQL Server) through the cache main.cpp turns on
+    suite.run("ProductManager::getProductByID", iterations, [&](int) {
+        productManager.getProductByID(productIDs[pickProduct(random)]);
+    });
+    if (cachedProductManager != nullptr && suite.selected("ProductManager::getProductByID (cached)")) {
+        cachedProductManager->enableCache(1000);
+        suite.run("ProductManager::getProductByID (cached)", iterations, [&](int) {
+            productManager.getProductByID(productIDs[pickProduct(random)]);
+        });
+    }
+
+    // Pages from the start of the table, so each one is full. A page can't have more rows than the table, so
+    // the sizes bigger than it are skipped (seed more rows to run them) rather than timed under a size they didn't fetch.
+    const int pageSizes[] = { 1, 100, 10000, 1000000 };
+    for (int pageSize : pageSizes) {
+        std::string name = "ProductManager::getProductPage/" + std::to_string(pageSize);
+        if (pageSize > static_cast<int>(productIDs.size())) {
+            if (suite.selected(name)) {
+                std::cout << "  " << name << " skipped, there are only " << productIDs.size() << " products" << std::endl;
+            }
+            continue;
+        }
+        suite.run(name, iterationsFor(pageSize), [&](int) {
+            productManager.getProductPage(0, pageSize);
+        }, pageSize);
+    }
+    suite.run("ProductManager::getProductQuantities/10", iterations, [&](int) {
+        std::vector<int> ids;
+        for (int k = 0; k < 10; k++) {
+            ids.push_back(productIDs[pickProduct(random)]);
+        }
+        productManager.getProductQuantities(ids);
+    }, 10);
+    suite.run("ProductManager::updateQuantity", iterations, [&](int) {
+        productManager.updateQuantity(productIDs[pickProduct(random)], 1000000);
+    });
+    for (int batchSize : batchSizes) {
+        std::vector<std::tuple<int, int>> productQuantities;
+        for (int k = 0; k < batchSize; k++) {
+            productQuantities.push_back(std::make_tuple(productIDs[k % productIDs.size()], 1000000));
+        }
+        suite.run("ProductManager::batchUpdateProductQty/" + std::to_string(batchSize), iterationsFor(batchSize), [&](int) {
+            productManager.batchUpdateProductQty(productQuantities);
+        }, batchSize);
+    }
+
+    // Carts; each of the first (up to) iterations customers gets a cart with three products, to check out below
+    const int carts = std::min(iterations, static_cast<int>(customerIDs.size()));
+    suite.run("CartItemManager::setCartItemQty", carts, [&](int i) {
+        cartItemManager.setCartItemQty(customerIDs[i], productIDs[i % productIDs.size()], 1);
+    });
+    suite.run("CartItemManager::incrementCartItemQty", carts, [&](int i) {
+        cartItemManager.incrementCartItemQty(customerIDs[i], productIDs[(i + 1) % productIDs.size()], 2);
+    });
+    suite.run("CartItemManager::createCartItem", carts, [&](int i) {
+        cartItemManager.createCartItem(customerIDs[i], productIDs[(i + 2) % productIDs.size()], 1);
+    });
+    suite.run("CartItemManager::getCustomerCartItems", iterations, [&](int) {
+        cartItemManager.getCustomerCartItems(customerIDs[pickCustomer(random)]);
+    });
+
+    // Checkout, then read back what it made. If the cart cases were filtered out, fill the carts first (untimed).
+    std::vector<int> transactionIDs;
+    if (suite.selected("CheckoutManager::checkout") && !suite.selected("CartItemManager::setCartItemQty")) {
+        for (int i = 0; i < carts; i++) {
+            cartItemManager.setCartItemQty(customerIDs[i], productIDs[i % productIDs.size()], 1);
+        }
+    }
+    suite.run("CheckoutManager::checkout", carts, [&](int i) {
+        CheckoutStore::CheckoutResult result = checkoutManager.checkout(customerIDs[i], 0);
+        if (result.succeeded()) {
+            transactionIDs.push_back(result.transactionID);
+        }
+    });
+
+    // The whole path a shopper takes: put three products in the cart, then check out
+    suite.run("CheckoutManager::checkout (end to end)", iterations, [&](int i) {
+        int customer_id = customerIDs[(carts + i) % customerIDs.size()];
+        for (int k = 0; k < 3; k++) {
+            cartItemManager.setCartItemQty(customer_id, productIDs[pickProduct(random)], 1);
+        }
+        CheckoutStore::CheckoutResult result = checkoutManager.checkout(customer_id, 0);
+        if (result.succeeded()) {
+            transactionIDs.push_back(result.transactionID);
+        }
+    });
+    if (!transactionIDs.empty()) {
+        std::uniform_int_distribution<size_t> pickTransaction(0, transactionIDs.size() - 1);
+        suite.run("TransactionManager::getTransactionByID", iterations, [&](int) {
+            transactionManager.getTransactionByID(transactionIDs[pickTransaction(random)]);
+        });
+        suite.run("TransactionManager::getTransactionPage/20", iterations, [&](int) {
+            transactionManager.getTransactionPage(transactionIDs[pickTransaction(random)], 20);
+        }, 20);
+        suite.run("OrderItemManager::getOrderItems", iterations, [&](int) {
+            orderItemManager.getOrderItems(transactionIDs[pickTransaction(random)]);
+        });
+        suite.run("ReadBatch (transaction + order items)", iterations, [&](int) {
+            int transaction_id = transactionIDs[pickTransaction(random)];
+            std::unique_ptr<ReadBatch> batch = backend.newReadBatch();
+            std::vector<Transaction> transactions;
+            std::vector<OrderItem> orderItems;
+            transactionManager.batchGetTransactionByID(*batch, transaction_id, transactions);
+            orderItemManager.batchGetOrderItems(*batch, transaction_id, orderItems);
+            batch->execute();
+        });
+    }
+    else if (suite.selected("TransactionManager") || suite.selected("OrderItemManager::getOrderItems") || suite.selected("ReadBatch")) {
+        std::cout << "  (no checkouts ran or succeeded, so there are no transactions to read)" << std::endl;
+    }
+
+    // Order items go into one transaction made for them
+    bool anyBatchCreate = false;
+    for (int batchSize : batchSizes) {
+        anyBatchCreate = anyBatchCreate || suite.selected("OrderItemManager::batchCreateOrderItem/" + std::to_string(batchSize));
+    }
+    if (anyBatchCreate) {
+        int transaction_id = transactionManager.createTransaction(customerIDs[0], 0).getTransactionID();
+        for (int batchSize : batchSizes) {
+            std::vector<std::tuple<int, int, int>> orderItems;
+            for (int k = 0; k < batchSize; k++) {
+                orderItems.push_back(std::make_tuple(transaction_id, productIDs[k % productIDs.size()], 1));
+            }
+            suite.run("OrderItemManager::batchCreateOrderItem/" + std::to_string(batchSize), iterationsFor(batchSize), [&](int) {
+                orderItemManager.batchCreateOrderItem(orderItems);
+            }, batchSize);
+        }
+    }
+
+    // Whole tables, a few passes each
+    suite.run("ProductManager::streamAll", 5, [&](int) {
+        for (Product& product : productManager.streamAll()) {
+            (void)product;
+        }
+    }, static_cast<double>(productIDs.size()));
+    suite.run("OrderItemManager::streamAll", 5, [&](int) {
+        for (OrderItem& orderItem : orderItemManager.streamAll()) {
+            (void)orderItem;
+        }
+    });
+    std::cout << "</Benchmark>" << std::endl;
+}
+
+/*
+- Makes the benchmark_store database from scratch on the server connectionString points to, then runs the cases
+  on it (see runBenchmarks). With queryMetrics, every statement after the seeding is recorded in it; null records nothing.
+*/
+void runOnSqlServer(BenchmarkSuite& suite, const std::string& connectionString, int rows, int iterations, QueryMetrics* queryMetrics) {
+    const std::string dbName = "benchmark_store";
+    std::string customerTableName = "Customers";
+    std::string supplierTableName = "Suppliers";
+    std::string supplierNameTableName = "Supplier_Names";
+    std::string productTableName = "Products";
+    std::string cartItemTableName = "Cart_Items";
+    std::string transactionTableName = "Transactions";
+    std::string orderItemTableName = "Order_Items";
+    std::string checkoutProcedureName = "Checkout_Cart";
+
+    // queryMetrics belongs to the caller, so it outlives the connections recording into it
+    ConnectionPool connectionPool(connectionString, 1, 4);
+    connectionPool.setQueryMetrics(queryMetrics);
+
+    // Start from an empty database every run
+    {
+        DBConnLease dbConn = connectionPool.acquire();
+        if (dbConn->dbExists(dbName)) {
+            dbConn->dropDatabase(dbName);
+        }
+        dbConn->createDatabase(dbName);
+    }
+    connectionPool.useDatabase(dbName);
+
+    // Same order as main.cpp, since the later tables reference the earlier ones
+    CustomerManager customerManager(connectionPool, customerTableName);
+    SupplierNameManager supplierNameManager(connectionPool, supplierNameTableName, supplierTableName);
+    SupplierManager supplierManager(connectionPool, supplierTableName, supplierNameManager);
+    ProductManager productManager(connectionPool, productTableName, supplierTableName);
+    CartItemManager cartItemManager(connectionPool, cartItemTableName, customerTableName, productTableName);
+    TransactionManager transactionManager(connectionPool, transactionTableName, customerTableName);
+    OrderItemManager orderItemManager(connectionPool, orderItemTableName, transactionTableName, productTableName);
+    CheckoutManager checkoutManager(connectionPool, checkoutProcedureName, customerTableName, productTableName, cartItemTableName, transactionTableName, orderItemTableName);
+    customerManager.initTable();
+    supplierManager.initTable();
+    supplierNameManager.initTable();
+    productManager.initTable();
+    cartItemManager.initTable();
+    transactionManager.initTable();
+    orderItemManager.initTable();
+    checkoutManager.initTable();
+
+    OdbcBackend backend(connectionPool, customerManager, supplierManager, productManager, cartItemManager,
+        transactionManager, orderItemManager, checkoutManager);
+    runBenchmarks(suite, backend, rows, iterations, queryMetrics, &productManager);
+}
+
+// Writes the suite's results to jsonPath, if there is one
+void writeJSON(const BenchmarkSuite& suite, const std::string& jsonPath, const std::string& backendName, int rows, int iterations) {
+    if (jsonPath.empty()) {
+        return;
+    }
+    std::ofstream json(jsonPath);
+    if (!json) {
+        throw std::runtime_error("Couldn't open '" + jsonPath + "' to write the results to!");
+    }
+    suite.writeJSON(json, { { "backend", backendName }, { "rows", std::to_string(rows) }, { "iterations", std::to_string(iterations) } });
+    std::cout << "Wrote the results to " << jsonPath << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        // --name=value options can go anywhere; the rest are the connection string (or --in-process), rows and iterations
+        std::string filter;
+        std::string jsonPath;
+        std::vector<std::string> args;
+        for (int i = 1; i < argc; i++) {
+            if (std::strncmp(argv[i], "--filter=", 9) == 0) {
+                filter = argv[i] + 9;
+            }
+            else if (std::strncmp(argv[i], "--json=", 7) == 0) {
+                jsonPath = argv[i] + 7;
+            }
+            else {
+                args.push_back(argv[i]);
+            }
+        }
+
+        std::string connectionString;
+        if (!args.empty()) {
+            connectionString = args[0];
+        }
+        else if (const char* fromEnvironment = std::getenv("RETAIL_BENCHMARK_CONNECTION")) {
+            connectionString = fromEnvironment;
+        }
+        if (connectionString.empty()) {
+            std::cerr << "Usage: " << argv[0] << " \"<ODBC connection string>\" [rows] [iterations] [--filter=text] [--json=path]" << std::endl;
+            std::cerr << "   or: " << argv[0] << " --in-process [rows] [iterations] [--filter=text] [--json=path]" << std::endl;
+            std::cerr << "(or set RETAIL_BENCHMARK_CONNECTION)" << std::endl;
+            return 1;
+        }
+        const int rows = args.size() > 1 ? std::max(10, std::atoi(args[1].c_str())) : 1000;
+        const int iterations = args.size() > 2 ? std::max(1, std::atoi(args[2].c_str())) : 1000;
+        BenchmarkSuite suite(std::cout, filter);
+
+        if (connectionString == "--in-process") {
+            InProcessBackend backend;
+            runBenchmarks(suite, backend, rows, iterations, nullptr, nullptr);
+            writeJSON(suite, jsonPath, "in-process", rows, iterations);
+            return 0;
+        }
+
+        // The timed pass, then the QueryMetrics pass with its own suite, whose times go nowhere
+        runOnSqlServer(suite, connectionString, rows, iterations, nullptr);
+        writeJSON(suite, jsonPath, "sql-server", rows, iterations);
+
+        std::cout << "QueryMetrics pass (the same cases again, untimed, to see where the server's time goes)" << std::endl;
+        std::ostream discard(nullptr);
+        BenchmarkSuite metricsSuite(discard, filter);
+        QueryMetrics queryMetrics;
+        runOnSqlServer(metricsSuite, connectionString, rows, iterations, &queryMetrics);
+        queryMetrics.printReport(std::cout, 10);
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "Benchmark failed: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
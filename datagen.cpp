@@ -0,0 +1,159 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "ConnectionPool.h"
+#include "CustomerManager.h"
+#include "SupplierManager.h"
+#include "SupplierNameManager.h"
+#include "ProductManager.h"
+#include "CartItemManager.h"
+#include "TransactionManager.h"
+#include "OrderItemManager.h"
+#include "CheckoutManager.h"
+#include "DataGenerator.h"
+
+/*
++ datagen: Makes a database with the store's tables, and fills it with generated data (see DataGenerator) to
+    benchmark against.
+
+        retail_datagen "<ODBC connection string>" [--name=value ...]
+        retail_datagen "<ODBC connection string>" --customers=1000000 --suppliers=5000 --products=200000 \
+            --transactions=20000000 --order-items=80000000 --threads=8
+
+- Options: --database (default generated_store), --seed, --customers, --suppliers, --products, --transactions,
+  --order-items, --product-skew, --customer-skew, --supplier-skew, --first-year, --years, --yearly-growth,
+  --threads and --chunk-rows. The defaults are DataGenerator::Config's, which make a small store in a few seconds.
+- The connection string can also be given with the RETAIL_BENCHMARK_CONNECTION environment variable, like the benchmark.
+
+NOTE: The database is dropped and made again on every run, so don't point it at one you want to keep.
+*/
+
+// Sets value to option's value and returns true if arg is --option=value
+bool readOption(const char* arg, const char* option, std::string& value) {
+    size_t length = std::strlen(option);
+    if (std::strncmp(arg, "--", 2) != 0 || std::strncmp(arg + 2, option, length) != 0 || arg[2 + length] != '=') {
+        return false;
+    }
+    value = arg + 3 + length;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        std::string connectionString;
+        int firstOption = 1;
+        if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+            connectionString = argv[1];
+            firstOption = 2;
+        }
+        else if (const char* fromEnvironment = std::getenv("RETAIL_BENCHMARK_CONNECTION")) {
+            connectionString = fromEnvironment;
+        }
+        if (connectionString.empty()) {
+            std::cerr << "Usage: " << argv[0] << " \"<ODBC connection string>\" [--customers=N --products=N ...]" << std::endl;
+            std::cerr << "(or set RETAIL_BENCHMARK_CONNECTION)" << std::endl;
+            return 1;
+        }
+
+        std::string dbName = "generated_store";
+        DataGenerator::Config config;
+        for (int i = firstOption; i < argc; i++) {
+            std::string value;
+            if (readOption(argv[i], "database", value)) {
+                dbName = value;
+            }
+            else if (readOption(argv[i], "seed", value)) {
+                config.seed = std::strtoull(value.c_str(), nullptr, 10);
+            }
+            else if (readOption(argv[i], "customers", value)) {
+                config.customers = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "suppliers", value)) {
+                config.suppliers = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "products", value)) {
+                config.products = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "transactions", value)) {
+                config.transactions = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "order-items", value)) {
+                config.orderItems = std::atoll(value.c_str());
+            }
+            else if (readOption(argv[i], "product-skew", value)) {
+                config.productSkew = std::atof(value.c_str());
+            }
+            else if (readOption(argv[i], "customer-skew", value)) {
+                config.customerSkew = std::atof(value.c_str());
+            }
+            else if (readOption(argv[i], "supplier-skew", value)) {
+                config.supplierSkew = std::atof(value.c_str());
+            }
+            else if (readOption(argv[i], "first-year", value)) {
+                config.firstYear = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "years", value)) {
+                config.years = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "yearly-growth", value)) {
+                config.yearlyGrowth = std::atof(value.c_str());
+            }
+            else if (readOption(argv[i], "threads", value)) {
+                config.threads = static_cast<size_t>(std::max(1, std::atoi(value.c_str())));
+            }
+            else if (readOption(argv[i], "chunk-rows", value)) {
+                config.chunkRows = std::atoi(value.c_str());
+            }
+            else {
+                throw std::runtime_error(std::string("Unknown option '") + argv[i] + "'!");
+            }
+        }
+
+        // Start from an empty database every run; one connection per worker thread
+        ConnectionPool connectionPool(connectionString, 1, config.threads);
+        {
+            DBConnLease dbConn = connectionPool.acquire();
+            if (dbConn->dbExists(dbName)) {
+                dbConn->dropDatabase(dbName);
+            }
+            dbConn->createDatabase(dbName);
+        }
+        connectionPool.useDatabase(dbName);
+
+        // Same tables, in the same order, as main.cpp, so the store can be run on the database afterwards
+        DataGenerator::Tables tables;
+        CustomerManager customerManager(connectionPool, tables.customers);
+        SupplierNameManager supplierNameManager(connectionPool, tables.supplierNames, tables.suppliers);
+        SupplierManager supplierManager(connectionPool, tables.suppliers, supplierNameManager);
+        ProductManager productManager(connectionPool, tables.products, tables.suppliers);
+        CartItemManager cartItemManager(connectionPool, "Cart_Items", tables.customers, tables.products);
+        TransactionManager transactionManager(connectionPool, tables.transactions, tables.customers);
+        OrderItemManager orderItemManager(connectionPool, tables.orderItems, tables.transactions, tables.products);
+        CheckoutManager checkoutManager(connectionPool, "Checkout_Cart", tables.customers, tables.products, "Cart_Items", tables.transactions, tables.orderItems);
+        customerManager.initTable();
+        supplierManager.initTable();
+        supplierNameManager.initTable();
+        productManager.initTable();
+        cartItemManager.initTable();
+        transactionManager.initTable();
+        orderItemManager.initTable();
+        checkoutManager.initTable();
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        DataGenerator generator(connectionPool, config, tables);
+        long long orderItems = generator.run(std::cout);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Generated '" << dbName << "' with seed " << config.seed << ": " << config.customers << " customers, "
+            << config.suppliers << " suppliers, " << config.products << " products, " << config.transactions << " transactions and "
+            << orderItems << " order items in " << seconds << "s" << std::endl;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "Data generation failed: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,189 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include "ConnectionPool.h"
+#include "QueryMetrics.h"
+#include "CustomerManager.h"
+#include "SupplierManager.h"
+#include "SupplierNameManager.h"
+#include "ProductManager.h"
+#include "CartItemManager.h"
+#include "TransactionManager.h"
+#include "OrderItemManager.h"
+#include "CheckoutManager.h"
+#include "OdbcBackend.h"
+#include "InProcessBackend.h"
+#include "LoadGenerator.h"
+
+/*
++ loadgen: Runs many shoppers at once against a scratch database (see LoadGenerator), to see how much checkout
+    traffic the server can take before it gets slow, deadlocks, or gets the stock wrong.
+
+        retail_loadgen "<ODBC connection string>" [--name=value ...]
+        retail_loadgen "<ODBC connection string>" --shoppers=200 --rate=5000 --seconds=60
+        retail_loadgen --in-process --shoppers=16
+
+- Options: --database (default load_test_store), --seed, --shoppers, --rate (actions a second for all the shoppers
+  together; 0, the default, is flat out), --seconds, --products, --stock, --product-skew, --page-size,
+  --browses-per-visit, --max-items-per-visit, --update-chance, --checkout-chance and --max-retries. The defaults
+  are LoadGenerator::Config's.
+- To size hardware for a sale, raise --rate until p99 or the late actions go up; that's about what the server can take.
+- On SQL Server, the QueryMetrics report afterwards shows which statements the time went to.
+- The connection string can also be given with the RETAIL_BENCHMARK_CONNECTION environment variable, like the benchmark.
+- Exits with 2 if any product was oversold or its stock doesn't add up, so it can be used as a check too.
+
+NOTE: The database is dropped and made again on every run, so don't point it at one you want to keep.
+*/
+
+// Sets value to option's value and returns true if arg is --option=value
+bool readOption(const char* arg, const char* option, std::string& value) {
+    size_t length = std::strlen(option);
+    if (std::strncmp(arg, "--", 2) != 0 || std::strncmp(arg + 2, option, length) != 0 || arg[2 + length] != '=') {
+        return false;
+    }
+    value = arg + 3 + length;
+    return true;
+}
+
+// Runs the load test on backend and prints the report; returns the exit code
+int runLoadTest(StorageBackend& backend, const LoadGenerator::Config& config) {
+    LoadGenerator generator(backend, config);
+    LoadGenerator::Results results = generator.run(std::cout);
+    LoadGenerator::printReport(results, std::cout);
+    if (!results.stockIsRight()) {
+        std::cerr << "The stock doesn't match what was sold!" << std::endl;
+        return 2;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        std::string connectionString;
+        int firstOption = 1;
+        if (argc > 1 && (std::strncmp(argv[1], "--", 2) != 0 || std::strcmp(argv[1], "--in-process") == 0)) {
+            connectionString = argv[1];
+            firstOption = 2;
+        }
+        else if (const char* fromEnvironment = std::getenv("RETAIL_BENCHMARK_CONNECTION")) {
+            connectionString = fromEnvironment;
+        }
+        if (connectionString.empty()) {
+            std::cerr << "Usage: " << argv[0] << " \"<ODBC connection string>\" [--shoppers=N --rate=N --seconds=N ...]" << std::endl;
+            std::cerr << "   or: " << argv[0] << " --in-process [--shoppers=N --rate=N --seconds=N ...]" << std::endl;
+            std::cerr << "(or set RETAIL_BENCHMARK_CONNECTION)" << std::endl;
+            return 1;
+        }
+
+        std::string dbName = "load_test_store";
+        LoadGenerator::Config config;
+        for (int i = firstOption; i < argc; i++) {
+            std::string value;
+            if (readOption(argv[i], "database", value)) {
+                dbName = value;
+            }
+            else if (readOption(argv[i], "seed", value)) {
+                config.seed = std::strtoull(value.c_str(), nullptr, 10);
+            }
+            else if (readOption(argv[i], "shoppers", value)) {
+                config.shoppers = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "rate", value)) {
+                config.actionsPerSecond = std::atof(value.c_str());
+            }
+            else if (readOption(argv[i], "seconds", value)) {
+                config.seconds = std::atof(value.c_str());
+            }
+            else if (readOption(argv[i], "products", value)) {
+                config.products = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "stock", value)) {
+                config.stock = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "product-skew", value)) {
+                config.productSkew = std::atof(value.c_str());
+            }
+            else if (readOption(argv[i], "page-size", value)) {
+                config.pageSize = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "browses-per-visit", value)) {
+                config.browsesPerVisit = std::atof(value.c_str());
+            }
+            else if (readOption(argv[i], "max-items-per-visit", value)) {
+                config.maxItemsPerVisit = std::atoi(value.c_str());
+            }
+            else if (readOption(argv[i], "update-chance", value)) {
+                config.updateChance = std::atof(value.c_str());
+            }
+            else if (readOption(argv[i], "checkout-chance", value)) {
+                config.checkoutChance = std::atof(value.c_str());
+            }
+            else if (readOption(argv[i], "max-retries", value)) {
+                config.maxRetries = std::atoi(value.c_str());
+            }
+            else {
+                throw std::runtime_error(std::string("Unknown option '") + argv[i] + "'!");
+            }
+        }
+
+        if (connectionString == "--in-process") {
+            InProcessBackend backend;
+            return runLoadTest(backend, config);
+        }
+
+        // queryMetrics is declared before the pool, so it outlives the connections recording into it; a connection per shopper
+        QueryMetrics queryMetrics;
+        ConnectionPool connectionPool(connectionString, 1, static_cast<size_t>(std::max(1, config.shoppers)));
+        connectionPool.setQueryMetrics(&queryMetrics);
+
+        // Start from an empty database every run
+        {
+            DBConnLease dbConn = connectionPool.acquire();
+            if (dbConn->dbExists(dbName)) {
+                dbConn->dropDatabase(dbName);
+            }
+            dbConn->createDatabase(dbName);
+        }
+        connectionPool.useDatabase(dbName);
+
+        // Same tables, in the same order, as main.cpp
+        std::string customerTableName = "Customers";
+        std::string supplierTableName = "Suppliers";
+        std::string supplierNameTableName = "Supplier_Names";
+        std::string productTableName = "Products";
+        std::string cartItemTableName = "Cart_Items";
+        std::string transactionTableName = "Transactions";
+        std::string orderItemTableName = "Order_Items";
+        std::string checkoutProcedureName = "Checkout_Cart";
+        CustomerManager customerManager(connectionPool, customerTableName);
+        SupplierNameManager supplierNameManager(connectionPool, supplierNameTableName, supplierTableName);
+        SupplierManager supplierManager(connectionPool, supplierTableName, supplierNameManager);
+        ProductManager productManager(connectionPool, productTableName, supplierTableName);
+        CartItemManager cartItemManager(connectionPool, cartItemTableName, customerTableName, productTableName);
+        TransactionManager transactionManager(connectionPool, transactionTableName, customerTableName);
+        OrderItemManager orderItemManager(connectionPool, orderItemTableName, transactionTableName, productTableName);
+        CheckoutManager checkoutManager(connectionPool, checkoutProcedureName, customerTableName, productTableName, cartItemTableName, transactionTableName, orderItemTableName);
+        customerManager.initTable();
+        supplierManager.initTable();
+        supplierNameManager.initTable();
+        productManager.initTable();
+        cartItemManager.initTable();
+        transactionManager.initTable();
+        orderItemManager.initTable();
+        checkoutManager.initTable();
+
+        OdbcBackend backend(connectionPool, customerManager, supplierManager, productManager, cartItemManager,
+            transactionManager, orderItemManager, checkoutManager);
+        int exitCode = runLoadTest(backend, config);
+        queryMetrics.printReport(std::cout, 10);
+        return exitCode;
+    }
+    catch (const std::exception& ex) {
+        std::cerr << "Load test failed: " << ex.what() << std::endl;
+        return 1;
+    }
+}
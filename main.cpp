@@ -1,8 +1,13 @@
 #include <iostream>
 #include <string>
+#include <memory>
+#include <chrono>
 
 #include "SQLServerConn.h"
 #include "DBConn.h"
+#include "ConnectionPool.h"
+#include "QueryMetrics.h"
+#include "SlowQueryLog.h"
 #include "CustomerManager.h"
 #include "SupplierManager.h"
 #include "SupplierNameManager.h"
@@ -10,9 +15,64 @@
 #include "CartItemManager.h"
 #include "TransactionManager.h"
 #include "OrderItemManager.h"
+#include "CheckoutManager.h"
+#include "CheckoutQueue.h"
+#include "WorkloadRecorder.h"
+#include "WorkloadReplayer.h"
+#include "OdbcBackend.h"
+#include "InProcessBackend.h"
 
 #include "RetailApp.h"
 
+// Runs the main menu until the user quits
+void runMainMenu(RetailApp& myStore) {
+    int choice;
+
+    do {
+        // Display main menu and prompt input
+        std::cout << "Main Menu: " << std::endl;
+        std::cout << "1. Customers" << std::endl;
+        std::cout << "2. Suppliers" << std::endl;
+        std::cout << "3. Products" << std::endl;
+        std::cout << "4. Cart Items" << std::endl;
+        std::cout << "5. Transactions" << std::endl;
+        std::cout << "6. Quit" << std::endl;
+        std::cout << "Please enter a number to continue: ";
+        std::cin >> choice;
+
+        if (std::cin.fail()) {
+            std::cout << "Invalid input. Please enter a number!" << std::endl;
+            std::cin.clear(); // Clear the error flag
+            std::cin.ignore(64, '\n'); // Clear input buffer up to 64 characters or until newline is encountered
+            continue; // Restart the loop
+        }
+
+        switch (choice) {
+        case 1:
+            myStore.handleCustomerMenu();
+            break;
+        case 2:
+            myStore.handleSupplierMenu();
+            break;
+        case 3:
+            myStore.handleProductMenu();
+            break;
+        case 4:
+            myStore.handleCartMenu();
+            break;
+        case 5:
+            myStore.handleTransactionMenu();
+            break;
+        case 6:
+            std::cout << "Exiting Program!" << std::endl;
+            break;
+        default:
+            std::cout << "Invalid choice. Please enter a number between 1 and 5." << std::endl;
+        }
+
+    } while (choice != 6);
+}
+
 int main() {
     try {
         // Table names
@@ -25,23 +85,74 @@ int main() {
         std::string cartItemTableName = "Cart_Items";
         std::string transactionTableName = "Transactions";
         std::string orderItemTableName = "Order_Items";
+        std::string checkoutProcedureName = "Checkout_Cart";
 
+        /*
+        - Optionally run the store on an InProcessBackend instead of SQL Server, to try it out without a server. It
+        starts empty, and everything is gone when the program quits.
+        */
+        const bool useInProcessBackend = false;
+        if (useInProcessBackend) {
+            InProcessBackend backend;
+            RetailApp myStore(backend);
+            runMainMenu(myStore);
+            return 0;
+        }
+
+        /*
+        - Open a pool of connections to the SQL Server instance. Managers lease a connection from the pool 
+        for each operation, so separate threads (or terminals) can use the database at the same time.
+        - poolMinSize connections are opened right away, and up to poolMaxSize are opened when needed.
+        - sqlTextMode: Narrow sends our (ASCII) SQL text to the driver without converting it to UTF-16 first,
+        which saves time on bulk imports; Wide is the safe choice for any text (see SQLText.h).
+        */
+        const size_t poolMinSize = 1;
+        const size_t poolMaxSize = 4;
+        const SQLTextMode sqlTextMode = SQLTextMode::Wide;
+
+        /*
+        - Optionally record how long every kind of query takes (see QueryMetrics), to find the hot ones. The report
+        is printed when the program quits, and every queryMetricsReportInterval as well if that isn't 0.
+        NOTE: queryMetrics (and slowQueryLog below) are declared before the pool, so they outlive the connections recording into them.
+        */
+        const bool useQueryMetrics = false;
+        const std::chrono::seconds queryMetricsReportInterval(0);
+        QueryMetrics queryMetrics;
+
+        /*
+        - Optionally log statements slower than slowQueryThreshold, and 1 in every slowQuerySampleEvery statements,
+        with their callers and parameters (see SlowQueryLog). The log file is rotated once it gets to 10MB.
+        */
+        const bool useSlowQueryLog = false;
+        const std::chrono::milliseconds slowQueryThreshold(100);
+        const unsigned long long slowQuerySampleEvery = 1000;
+        std::unique_ptr<SlowQueryLog> slowQueryLog;
+        if (useSlowQueryLog) {
+            slowQueryLog.reset(new SlowQueryLog("slow_queries.log", slowQueryThreshold, slowQuerySampleEvery));
+        }
 
-        // Connect to SQL Server instance on 
-        SQLServerConn connector;
-        connector.connect(connectionString);
+        ConnectionPool connectionPool(connectionString, poolMinSize, poolMaxSize, sqlTextMode);
+        connectionPool.setSlowQueryLog(slowQueryLog.get());
+        if (useQueryMetrics) {
+            connectionPool.setQueryMetrics(&queryMetrics);
+            if (queryMetricsReportInterval.count() > 0) {
+                queryMetrics.startReporting(std::cerr, queryMetricsReportInterval);
+            }
+        }
 
-        // Connect to database 
-        DBConn dbConn(connector.getHDBC());
-        if (!dbConn.dbExists(dbName)) {
-            dbConn.createDatabase(dbName);
+        // Lease a connection for setting up the database and its tables
+        DBConnLease dbConn = connectionPool.acquire();
+        if (!dbConn->dbExists(dbName)) {
+            dbConn->createDatabase(dbName);
         }
-        dbConn.useDatabase(dbName);
+
+        // Switch every connection in the pool over to our database
+        connectionPool.useDatabase(dbName);
 
 
         // Create manager for 'customer'. Create table if it doesn't already exist
-        CustomerManager customerManager(dbConn, customerTableName);
-        if (!dbConn.tableExists(customerTableName)) {
+        CustomerManager customerManager(connectionPool, customerTableName);
+        if (!dbConn->tableExists(customerTableName)) {
             customerManager.initTable();
         }
 
@@ -52,95 +163,111 @@ int main() {
         supplier name table. This is because the latter references the former, so we must make sure
         the former exists before the latter.
         */
-        SupplierNameManager supplierNameManager(dbConn, supplierNameTableName, supplierTableName);
-        SupplierManager supplierManager(dbConn, supplierTableName, supplierNameManager);
+        SupplierNameManager supplierNameManager(connectionPool, supplierNameTableName, supplierTableName);
+        SupplierManager supplierManager(connectionPool, supplierTableName, supplierNameManager);
 
-        if (!dbConn.tableExists(supplierTableName)) {
+        if (!dbConn->tableExists(supplierTableName)) {
             supplierManager.initTable();
         }
 
-        if (!dbConn.tableExists(supplierNameTableName)) {
+        if (!dbConn->tableExists(supplierNameTableName)) {
             supplierNameManager.initTable();
         }
 
-        // Create manager for products table
-        ProductManager productManager(dbConn, productTableName, supplierTableName);
-        if (!dbConn.tableExists(productTableName)) {
+        /*
+        - Create manager for products table. Products are looked up by ID over and over (showing carts, adding
+        to carts, etc.), so keep up to productCacheCapacity of them in memory.
+        */
+        const size_t productCacheCapacity = 1000;
+        ProductManager productManager(connectionPool, productTableName, supplierTableName);
+        productManager.enableCache(productCacheCapacity);
+        if (!dbConn->tableExists(productTableName)) {
             productManager.initTable();
         }
 
         // Create manager for cart items table and initialize table if it doesn't already exist
-        CartItemManager cartItemManager(dbConn, cartItemTableName, customerTableName, productTableName);
-        if (!dbConn.tableExists(cartItemTableName)) {
+        CartItemManager cartItemManager(connectionPool, cartItemTableName, customerTableName, productTableName);
+        if (!dbConn->tableExists(cartItemTableName)) {
             cartItemManager.initTable();
         }
 
         // Create manager for transactions table; needs for customer table to exist first
-        TransactionManager transactionManager(dbConn, transactionTableName, customerTableName);
-        if (!dbConn.tableExists(transactionTableName)) {
+        TransactionManager transactionManager(connectionPool, transactionTableName, customerTableName);
+        if (!dbConn->tableExists(transactionTableName)) {
             transactionManager.initTable();
         }
 
         // Create manager for order items table; needs the transaction and product table to exist first.
-        OrderItemManager orderItemManager(dbConn, orderItemTableName, transactionTableName, productTableName);
-        if (!dbConn.tableExists(orderItemTableName)) {
+        OrderItemManager orderItemManager(connectionPool, orderItemTableName, transactionTableName, productTableName);
+        if (!dbConn->tableExists(orderItemTableName)) {
             orderItemManager.initTable();
         }
 
+        // Create manager for checking out carts; installs its procedure every time, since it uses all of the tables above
+        CheckoutManager checkoutManager(connectionPool, checkoutProcedureName, customerTableName, productTableName, cartItemTableName, transactionTableName, orderItemTableName);
+        checkoutManager.initTable();
+
 
 
         
 
-        RetailApp myStore(customerManager, supplierManager, productManager, cartItemManager, transactionManager, orderItemManager);
-        int choice;
-
-        do {
-            // Display main menu and prompt input
-            std::cout << "Main Menu: " << std::endl;
-            std::cout << "1. Customers" << std::endl;
-            std::cout << "2. Suppliers" << std::endl;
-            std::cout << "3. Products" << std::endl;
-            std::cout << "4. Cart Items" << std::endl;
-            std::cout << "5. Transactions" << std::endl;
-            std::cout << "6. Quit" << std::endl;
-            std::cout << "Please enter a number to continue: ";
-            std::cin >> choice;
-
-            if (std::cin.fail()) {
-                std::cout << "Invalid input. Please enter a number!" << std::endl;
-                std::cin.clear(); // Clear the error flag
-                std::cin.ignore(64, '\n'); // Clear input buffer up to 64 characters or until newline is encountered
-                continue; // Restart the loop
-            }
+        // Setup is done, so give the connection back to the pool
+        dbConn.release();
+
+        // The managers are the stores of the SQL Server backend, which the app and the replayer run on
+        OdbcBackend backend(connectionPool, customerManager, supplierManager, productManager, cartItemManager, transactionManager, orderItemManager, checkoutManager);
 
-            switch (choice) {
-            case 1:
-                myStore.handleCustomerMenu();
-                break;
-            case 2:
-                myStore.handleSupplierMenu();
-                break;
-            case 3:
-                myStore.handleProductMenu();
-                break;
-            case 4:
-                myStore.handleCartMenu();
-                break;
-            case 5:
-                myStore.handleTransactionMenu();
-                break;
-            case 6:
-                std::cout << "Exiting Program!" << std::endl;
-                break;
-            default:
-                std::cout << "Invalid choice. Please enter a number between 1 and 5." << std::endl;
+        /*
+        - Optionally record every call made to the managers into workloadTracePath (see WorkloadRecorder), to replay
+        later as a load test made from real traffic.
+        - Or, with replayWorkload, play that trace back through the managers over replaySessions sessions, at
+        replaySpeed times the rate it was recorded at (0 for as fast as possible), print how it went, and quit
+        instead of opening the menu (see WorkloadReplayer). Replay against a copy of the database from when the
+        recording started, and keep poolMaxSize at least replaySessions.
+        */
+        const bool recordWorkload = false;
+        const bool replayWorkload = false;
+        const std::string workloadTracePath = "workload.trace";
+        const int replaySessions = 4;
+        const double replaySpeed = 1.0;
+        if (replayWorkload) {
+            WorkloadReplayer replayer(backend);
+            replayer.load(workloadTracePath);
+            replayer.run(replaySessions, replaySpeed).print(std::cout);
+            if (useQueryMetrics) {
+                queryMetrics.stopReporting();
+                queryMetrics.printReport(std::cout);
             }
+            return 0;
+        }
+        std::unique_ptr<WorkloadRecorder> workloadRecorder;
+        if (recordWorkload) {
+            workloadRecorder.reset(new WorkloadRecorder(workloadTracePath));
+            WorkloadRecorder::setCurrent(workloadRecorder.get());
+        }
+
+        RetailApp myStore(backend);
 
-        } while (choice != 6);
+        /*
+        - Optionally send checkouts through a group-commit queue, which commits up to checkoutBatchSize of them
+        in one transaction. It only helps when many terminals check out at once (like during a sale), so it's off
+        by default; with a single terminal every batch would just be one checkout.
+        */
+        const bool useCheckoutQueue = false;
+        const size_t checkoutBatchSize = 32;
+        std::unique_ptr<CheckoutQueue> checkoutQueue;
+        if (useCheckoutQueue) {
+            checkoutQueue.reset(new CheckoutQueue(connectionPool, checkoutManager, checkoutBatchSize));
+            myStore.setCheckoutQueue(checkoutQueue.get());
+        }
+        runMainMenu(myStore);
+        if (useQueryMetrics) {
+            queryMetrics.stopReporting();
+            queryMetrics.printReport(std::cout);
+        }
         
 
-        // Disconnect from SQL Server
-        connector.disconnect();
+        // Connections in the pool are disconnected from SQL Server when connectionPool goes out of scope
     }
     catch (const std::exception& ex) {
         std::cerr << "Exception caught: " << ex.what() << std::endl;
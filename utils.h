@@ -3,6 +3,9 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cmath>
+
+#include "PageSource.h"
 
 template<typename T>
 T getValidNumericInput(const std::string prompt) {
@@ -52,7 +55,7 @@ void displayItemPage(const std::vector<T>& items, int page, int pageSize, std::s
     - However, if endIndex, is greater than the size of the vector,
     then set endIndex to the size of the vector to avoid going over.
     */
-    if (endIndex > items.size()) {
+    if (endIndex > static_cast<int>(items.size())) {
         endIndex = items.size();
     }
 
@@ -104,7 +107,7 @@ T selectPaginatedItems(std::vector<T>& items, int pageSize, std::string menuName
 			if (page > maxPage) {
 				page = maxPage;
 			}
-        } else if (menuChoice < 1 || menuChoice > items.size()) {
+        } else if (menuChoice < 1 || menuChoice > static_cast<int>(items.size())) {
             // If out of range value that isn't 0, -1, or -2
             std::cout << "Please enter a list value between 1 and " << items.size() << "!" << std::endl;
         } else {
@@ -163,6 +166,106 @@ void navigatePaginatedItems(const std::vector<T>& items, int pageSize, std::stri
     } while (page <= maxPage);
 }
 
+/*
+- Paginated menus over a PageSource rather than a vector. Only the page being shown is fetched from the database, so
+  these work the same for 50 rows or 2 million. List numbers keep counting up across pages, like the vector versions.
+*/
+
+// Displays the current page of a page source
+template<typename T>
+void displayItemPage(PageSource<T>& source, std::string menuText) {
+    std::vector<T>& items = source.getPage();
+    const int firstNumber = (source.getPageNumber() - 1) * source.getPageSize() + 1;
+
+    std::cout << menuText << std::endl;
+    for (size_t i = 0; i < items.size(); ++i) {
+        std::cout << firstNumber + static_cast<int>(i) << ". " << items[i] << std::endl;
+    }
+}
+
+template<typename T>
+T selectPaginatedItems(PageSource<T>& source, std::string menuName, std::string prompt) {
+    const int maxPage = source.getPageCount();
+    do {
+        // Construct text for the menu and render the menu for the current page
+        std::string itemMenuText = menuName + " (Page " + std::to_string(source.getPageNumber()) + " / " + std::to_string(maxPage) + ")";
+        displayItemPage(source, itemMenuText);
+
+        // Only the items on the current page can be picked
+        std::vector<T>& items = source.getPage();
+        const int firstNumber = (source.getPageNumber() - 1) * source.getPageSize() + 1;
+        const int lastNumber = firstNumber + static_cast<int>(items.size()) - 1;
+
+        // Prompt for menu selection
+        int menuChoice;
+        std::cout << prompt << " (0 to exit, -1 for previous page, -2 for next page): ";
+        std::cin >> menuChoice;
+
+        // Check if the input is valid integer
+        if (std::cin.fail()) {
+            std::cout << "Invalid input. Please enter a valid number." << std::endl;
+            std::cin.clear();
+            std::cin.ignore(64, '\n');
+        }
+        else if (menuChoice == 0) {
+            // Exit loop and return instance created by default constructor
+            return T();
+        }
+        else if (menuChoice == -1) {
+            // Move to previous page; stays on the first page
+            source.previous();
+        }
+        else if (menuChoice == -2) {
+            // Move to next page; stays on the last page
+            source.next();
+        }
+        else if (menuChoice < firstNumber || menuChoice > lastNumber) {
+            std::cout << "Please enter a list value between " << firstNumber << " and " << lastNumber << "!" << std::endl;
+        }
+        else {
+            return items[menuChoice - firstNumber];
+        }
+
+        std::cout << std::endl;
+    } while (true);
+}
+
+// Controls paginated item menu over a page source, for viewing purposes only
+template<typename T>
+void navigatePaginatedItems(PageSource<T>& source, std::string menuName) {
+    const int maxPage = source.getPageCount();
+    do {
+        std::string itemMenuText = menuName + " (Page " + std::to_string(source.getPageNumber()) + " / " + std::to_string(maxPage) + ")";
+        displayItemPage(source, itemMenuText);
+
+        // Prompt for menu selection
+        int menuChoice;
+        std::cout << "Select number to navigate (0 to exit, -1 for previous page, -2 for next page): ";
+        std::cin >> menuChoice;
+
+        // Check if the input is valid
+        if (std::cin.fail()) {
+            std::cout << "Invalid input. Please enter a valid number." << std::endl;
+            std::cin.clear();
+            std::cin.ignore(64, '\n');
+        }
+        else if (menuChoice == 0) {
+            break; // Exit the loop
+        }
+        else if (menuChoice == -1) {
+            source.previous();
+        }
+        else if (menuChoice == -2) {
+            source.next();
+        }
+        else {
+            std::cout << "Invalid numerical choice. Please try again!" << std::endl;
+        }
+
+        std::cout << std::endl;
+    } while (true);
+}
+
 char promptYesOrNo(std::string prompt) {
     char choice;
     do {